@@ -20,6 +20,9 @@
  */
 
 #include "imbs.hpp"
+#include "imbs_kernels.hpp"
+
+#include <algorithm>
 
 using namespace std;
 using namespace cv;
@@ -47,6 +50,24 @@ BackgroundSubtractorIMBS::BackgroundSubtractorIMBS()
 	bgFilename = NULL;
 	loadedBg = false;
 	isBackgroundCreated = false;
+	nframes = 0;
+
+	binValues = NULL;
+	binHeights = NULL;
+	binIsFg = NULL;
+	binCapacity = 0;
+	memset(&model, 0, sizeof(model));
+	memset(&stagingModel, 0, sizeof(stagingModel));
+	pixelState = NULL;
+	persistenceMap = NULL;
+	threadPool = NULL;
+	finalizeTarget = NULL;
+
+	incrementalUpdate = false;
+	stagingPending = false;
+	stagingCycleEnd = false;
+	stagingRow = 0;
+	isFirstBg = true;
 }
 
 BackgroundSubtractorIMBS::BackgroundSubtractorIMBS(
@@ -94,13 +115,118 @@ BackgroundSubtractorIMBS::BackgroundSubtractorIMBS(
 	bgFilename = NULL;
 	loadedBg = false;
 	isBackgroundCreated = false;
+	nframes = 0;
+
+	binValues = NULL;
+	binHeights = NULL;
+	binIsFg = NULL;
+	binCapacity = 0;
+	memset(&model, 0, sizeof(model));
+	memset(&stagingModel, 0, sizeof(stagingModel));
+	pixelState = NULL;
+	persistenceMap = NULL;
+	threadPool = NULL;
+	finalizeTarget = NULL;
+
+	incrementalUpdate = false;
+	stagingPending = false;
+	stagingCycleEnd = false;
+	stagingRow = 0;
+	isFirstBg = true;
 }
 
 BackgroundSubtractorIMBS::~BackgroundSubtractorIMBS()
 {
-	delete[] bgBins;
-	delete[] bgModel;
-	delete[] persistenceMap;
+	releaseModel();
+	delete threadPool;
+}
+
+void BackgroundSubtractorIMBS::allocateModel(bool withModelSlabs)
+{
+	releaseModel();
+
+	if(minBinHeight <= 1){
+		minBinHeight = 1;
+	}
+
+	binCapacity = numSamples;
+	maxBgBins = numSamples / minBinHeight;
+
+	//one slab per field instead of a handful of small arrays per pixel
+	const size_t binSlots = (size_t)binCapacity * numPixels;
+	const size_t modelSlots = (size_t)maxBgBins * numPixels;
+
+	binValues = (Vec3b*)fastMalloc(binSlots * sizeof(Vec3b));
+	binHeights = (uchar*)fastMalloc(binSlots * sizeof(uchar));
+	binIsFg = (bool*)fastMalloc(binSlots * sizeof(bool));
+
+	if(withModelSlabs) {
+		allocateSlabs(model, modelSlots);
+		//the incremental update builds the next model aside the one in use
+		if(incrementalUpdate) {
+			allocateSlabs(stagingModel, modelSlots);
+		}
+	}
+
+	pixelState = (uchar*)fastMalloc(numPixels * sizeof(uchar));
+	persistenceMap = (unsigned int*)fastMalloc(numPixels * sizeof(unsigned int));
+
+	memset((uchar*)binValues, 0, binSlots * sizeof(Vec3b));
+	memset(binHeights, 0, binSlots * sizeof(uchar));
+	memset(binIsFg, 0, binSlots * sizeof(bool));
+	memset(pixelState, 0, numPixels * sizeof(uchar));
+	memset(persistenceMap, 0, numPixels * sizeof(unsigned int));
+}
+
+void BackgroundSubtractorIMBS::allocateSlabs(ModelSlabs& slabs, size_t slots)
+{
+	for(int k = 0; k < 3; ++k) {
+		slabs.values[k] = (uchar*)fastMalloc(slots * sizeof(uchar));
+		slabs.hsv[k] = (uchar*)fastMalloc(slots * sizeof(uchar));
+		memset(slabs.values[k], 0, slots * sizeof(uchar));
+		memset(slabs.hsv[k], 0, slots * sizeof(uchar));
+	}
+	slabs.isValid = (bool*)fastMalloc(slots * sizeof(bool));
+	slabs.isFg = (bool*)fastMalloc(slots * sizeof(bool));
+	slabs.counter = (uchar*)fastMalloc(slots * sizeof(uchar));
+	memset(slabs.isValid, 0, slots * sizeof(bool));
+	memset(slabs.isFg, 0, slots * sizeof(bool));
+	memset(slabs.counter, 0, slots * sizeof(uchar));
+}
+
+void BackgroundSubtractorIMBS::releaseSlabs(ModelSlabs& slabs)
+{
+	if(slabs.mapping.address != NULL) {
+		imbsUnmapSnapshot(slabs.mapping);
+	}
+	else {
+		for(int k = 0; k < 3; ++k) {
+			fastFree(slabs.values[k]);
+			fastFree(slabs.hsv[k]);
+		}
+		fastFree(slabs.isValid);
+		fastFree(slabs.isFg);
+		fastFree(slabs.counter);
+	}
+	memset(&slabs, 0, sizeof(slabs));
+}
+
+void BackgroundSubtractorIMBS::releaseModel()
+{
+	fastFree(binValues);
+	fastFree(binHeights);
+	fastFree(binIsFg);
+	releaseSlabs(model);
+	releaseSlabs(stagingModel);
+	fastFree(pixelState);
+	fastFree(persistenceMap);
+
+	binValues = NULL;
+	binHeights = NULL;
+	binIsFg = NULL;
+	binCapacity = 0;
+	pixelState = NULL;
+	persistenceMap = NULL;
 }
 
 void BackgroundSubtractorIMBS::initialize(Size frameSize, int frameType)
@@ -109,20 +235,30 @@ void BackgroundSubtractorIMBS::initialize(Size frameSize, int frameType)
 		return;
 	cout << "INPUT: WIDTH " << frameSize.width << "  HEIGHT " << frameSize.height <<
 			"  FPS " << fps << endl;
+	cout << "IMBS KERNELS: " << imbsKernelsInstructionSet() << endl;
 	cout << endl;
 
 	this->frameSize = frameSize;
 	this->frameType = frameType;
 	this->numPixels = frameSize.width*frameSize.height;
 
-	persistenceMap = new unsigned int[numPixels];
-	for(unsigned int i = 0; i < numPixels; i++) {
-		persistenceMap[i] = 0;
-	}
+	initializeModel();
 
-	bgBins = new Bins[numPixels];
-	bgModel = new BgModel[numPixels];
-	maxBgBins = numSamples / minBinHeight;
+	//initial message to be shown until the first fg mask is computed
+	initialMsgGray = Mat::zeros(frameSize, CV_8UC1);
+	putText(initialMsgGray, "Creating", Point(10,20), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
+	putText(initialMsgGray, "initial", Point(10,40), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
+	putText(initialMsgGray, "background...", Point(10,60), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
+	
+	initialMsgRGB = Mat::zeros(frameSize, CV_8UC3);
+	putText(initialMsgRGB, "Creating", Point(10,20), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
+	putText(initialMsgRGB, "initial", Point(10,40), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
+	putText(initialMsgRGB, "background...", Point(10,60), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
+}
+
+void BackgroundSubtractorIMBS::initializeModel(bool withModelSlabs)
+{
+	allocateModel(withModelSlabs);
 
 	timestamp = 0.;//ms
 	prev_timestamp = 0.;//ms
@@ -131,6 +267,7 @@ void BackgroundSubtractorIMBS::initialize(Size frameSize, int frameType)
 	bg_reset = false;
 	prev_area = 0;
 	sudden_change = false;
+	stagingPending = false;
 
 	SHADOW_LABEL = 80;
 	PERSISTENCE_LABEL = 180;
@@ -138,37 +275,12 @@ void BackgroundSubtractorIMBS::initialize(Size frameSize, int frameType)
 
 	fgmask.create(frameSize, CV_8UC1);
 	fgfiltered.create(frameSize, CV_8UC1);
+	for(int k = 0; k < 3; ++k) {
+		frameHSV[k].create(frameSize, CV_8UC1);
+	}
 	persistenceImage = Mat::zeros(frameSize, CV_8UC1);
 	bgSample.create(frameSize, CV_8UC3);
 	bgImage = Mat::zeros(frameSize, CV_8UC3);
-
-	//initial message to be shown until the first fg mask is computed
-	initialMsgGray = Mat::zeros(frameSize, CV_8UC1);
-	putText(initialMsgGray, "Creating", Point(10,20), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
-	putText(initialMsgGray, "initial", Point(10,40), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
-	putText(initialMsgGray, "background...", Point(10,60), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
-	
-	initialMsgRGB = Mat::zeros(frameSize, CV_8UC3);
-	putText(initialMsgRGB, "Creating", Point(10,20), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
-	putText(initialMsgRGB, "initial", Point(10,40), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
-	putText(initialMsgRGB, "background...", Point(10,60), FONT_HERSHEY_SIMPLEX, 0.4, CV_RGB(255, 255, 255));
-
-	if(minBinHeight <= 1){
-		minBinHeight = 1;
-	}
-
-	for(unsigned int p = 0; p < numPixels; ++p)
-	{
-		bgBins[p].binValues = new Vec3b[numSamples];
-		bgBins[p].binHeights = new uchar[numSamples];
-		bgBins[p].isFg = new bool[numSamples];
-		
-		bgModel[p].values = new Vec3b[maxBgBins];
-		bgModel[p].isValid = new bool[maxBgBins];
-		bgModel[p].isValid[0] = false;
-		bgModel[p].isFg = new bool[maxBgBins];
-		bgModel[p].counter = new uchar[maxBgBins];
-	}	
 }
 
 void BackgroundSubtractorIMBS::apply(InputArray _frame, OutputArray _fgmask, double learningRate)
@@ -202,7 +314,7 @@ void BackgroundSubtractorIMBS::apply(InputArray _frame, OutputArray _fgmask, dou
 	}
 
     //wait for the first model to be generated
-    if(bgModel[0].isValid[0]) {
+    if(model.isValid[0]) {
     	getFg();    	
     	hsvSuppression();
 		filterFg();
@@ -211,7 +323,7 @@ void BackgroundSubtractorIMBS::apply(InputArray _frame, OutputArray _fgmask, dou
     updateBg();
 	
 	//show an initial message if the first bg is not yet ready
-	if(!bgModel[0].isValid[0]) {
+	if(!model.isValid[0]) {
 		initialMsgGray.copyTo(fgmask);
 		initialMsgRGB.copyTo(bgImage);
 	}
@@ -223,7 +335,10 @@ void BackgroundSubtractorIMBS::updateBg() {
 /// Uncomment to enable the background update over time.
 ///
 #if 1
-    static bool isFirstTime = true;
+	if(incrementalUpdate) {
+		updateBgIncremental();
+		return;
+	}
 
 	if(bg_reset) {
 		if(bg_frame_counter > numSamples - 1) {
@@ -237,9 +352,9 @@ void BackgroundSubtractorIMBS::updateBg() {
 
     if(bg_frame_counter == numSamples - 1) {
         createBg(bg_frame_counter);
-        if (isFirstTime)
+        if (isFirstBg)
         {
-            isFirstTime = false;
+            isFirstBg = false;
             samplingPeriod = 2000.0;
             bg_reset = true;
         }
@@ -261,44 +376,111 @@ void BackgroundSubtractorIMBS::updateBg() {
 ///
 }
 
+void BackgroundSubtractorIMBS::updateBgIncremental() {
+	if(prev_bg_frame_time > timestamp) {
+		prev_bg_frame_time = timestamp;
+	}
+
+	if((timestamp - prev_bg_frame_time) < samplingPeriod) {
+		//spread the construction of the staging model over the frames
+		//between two samples, so that it is over before the next one
+		if(stagingPending) {
+			const double frameTime = std::max(timestamp - prev_timestamp, 1.);
+			finalizeStagingRows((unsigned int)ceil(2. * frameSize.height * frameTime / samplingPeriod));
+		}
+		return;
+	}
+
+	//the bins are about to change, so the pending model has to be completed first
+	if(stagingPending) {
+		finalizeStagingRows(frameSize.height);
+	}
+	if(bg_frame_counter >= numSamples) {
+		bg_frame_counter = 0;
+	}
+
+	//fold the new sample into the bins
+	prev_bg_frame_time = timestamp;
+	frame.copyTo(bgSample);
+	createBg(bg_frame_counter);
+	++bg_frame_counter;
+
+	//a model is built at the end of every sampling cycle and, until the first
+	//one is ready, from the bins collected so far
+	const bool cycleEnd = bg_frame_counter == numSamples;
+	if(cycleEnd || (!isBackgroundCreated && bg_frame_counter >= std::min(BOOTSTRAP_SAMPLES, numSamples))) {
+		stagingPending = true;
+		stagingCycleEnd = cycleEnd;
+		stagingRow = 0;
+	}
+}
+
+void BackgroundSubtractorIMBS::finalizeStagingRows(unsigned int rows) {
+	const unsigned int lastRow = std::min(stagingRow + std::max(rows, 1u), (unsigned int)frameSize.height);
+	finalizeBg(&stagingModel, stagingRow, lastRow);
+	stagingRow = lastRow;
+
+	if(stagingRow < (unsigned int)frameSize.height) {
+		return;
+	}
+
+	//rolling swap: the old model becomes the next staging model
+	std::swap(model, stagingModel);
+	stagingPending = false;
+
+	if(stagingCycleEnd) {
+		completeBg();
+		if(isFirstBg) {
+			isFirstBg = false;
+			samplingPeriod = 2000.0;
+		}
+	}
+	else {
+		updateBgImage();
+	}
+}
+
 double BackgroundSubtractorIMBS::getTimestamp() {
 	return ((double)getTickCount() - initial_tick_count)*1000./getTickFrequency();
 }
 
 void BackgroundSubtractorIMBS::hsvSuppression() {
+	runStage(&BackgroundSubtractorIMBS::hsvSuppressionBand);
+}
+
+void BackgroundSubtractorIMBS::hsvSuppressionBand(unsigned int begin, unsigned int end) {
 
 	uchar h_i, s_i, v_i;
 	uchar h_b, s_b, v_b;
 	float h_diff, s_diff, v_ratio;
 
-	Mat bgrPixel(cv::Size(1, 1), CV_8UC3);
-	
-	vector<Mat> imHSV;
-	cv::split(convertImageRGBtoHSV(frame), imHSV);
+	//frameBGR has already been split by getFg()
+	const uchar* framePlanes[3] = { frameBGR[0].data + begin, frameBGR[1].data + begin, frameBGR[2].data + begin };
+	uchar* hsvPlanes[3] = { frameHSV[0].data, frameHSV[1].data, frameHSV[2].data };
+	uchar* hsvBand[3] = { hsvPlanes[0] + begin, hsvPlanes[1] + begin, hsvPlanes[2] + begin };
+	imbsConvertBGRtoHSV(framePlanes, hsvBand, end - begin);
 
-	for(unsigned int p = 0; p < numPixels; ++p) {
+	for(unsigned int p = begin; p < end; ++p) {
 		if(fgmask.data[p]) {
 
-			h_i = imHSV[0].data[p];
-			s_i = imHSV[1].data[p];
-			v_i = imHSV[2].data[p];
+			h_i = hsvPlanes[0][p];
+			s_i = hsvPlanes[1][p];
+			v_i = hsvPlanes[2][p];
 
 			for(unsigned int n = 0; n < maxBgBins; ++n) {
-				if(!bgModel[p].isValid[n]) {
+				const size_t o = (size_t)n * numPixels + p;
+
+				if(!model.isValid[o]) {
 					break;
 				}
 
-				if(bgModel[p].isFg[n]) {
+				if(model.isFg[o]) {
 					continue;
 				}
 
-				bgrPixel.at<cv::Vec3b>(0,0) = bgModel[p].values[n];
-
-				cv::Mat hsvPixel = convertImageRGBtoHSV(bgrPixel);
-
-				h_b = hsvPixel.at<cv::Vec3b>(0,0)[0];
-				s_b = hsvPixel.at<cv::Vec3b>(0,0)[1];
-				v_b = hsvPixel.at<cv::Vec3b>(0,0)[2];
+				h_b = model.hsv[0][o];
+				s_b = model.hsv[1][o];
+				v_b = model.hsv[2][o];
 
 				v_ratio = (float)v_i / (float)v_b;
 				s_diff = std::abs(s_i - s_b);
@@ -317,6 +499,13 @@ void BackgroundSubtractorIMBS::hsvSuppression() {
 	}//numPixels
 }
 
+void BackgroundSubtractorIMBS::updateModelHSV() {
+	//the slabs are contiguous, so the whole model is converted in one go
+	const size_t modelSlots = (size_t)maxBgBins * numPixels;
+	const uchar* valuePlanes[3] = { model.values[0], model.values[1], model.values[2] };
+	imbsConvertBGRtoHSV(valuePlanes, model.hsv, modelSlots);
+}
+
 void BackgroundSubtractorIMBS::createBg(unsigned int bg_sample_number) {
 	if(!bgSample.data) {
 		//cerr << "createBg -- an error occurred: " <<
@@ -325,234 +514,246 @@ void BackgroundSubtractorIMBS::createBg(unsigned int bg_sample_number) {
 		//TODO vedere gestione errori
 		abort();
 	}
-	//aux variable
-	Vec3b currentPixel;
 	//split bgSample in channels
 	cv::split(bgSample, bgSampleBGR);
 	//create a statistical model for each pixel (a set of bins of variable size)
-	for(unsigned int p = 0; p < numPixels; ++p) {
-		//create an initial bin for each pixel from the first sample (bg_sample_number = 0)
-		if(bg_sample_number == 0) {
-			for(int k = 0; k < 3; ++k) {
-				bgBins[p].binValues[0][k] = bgSampleBGR[k].data[p];
+	bgSampleNumber = bg_sample_number;
+	runStage(&BackgroundSubtractorIMBS::createBgBand);
+
+	//in incremental mode the model is built by updateBgIncremental()
+	if(!incrementalUpdate && bg_sample_number == (numSamples - 1)) {
+		finalizeBg(&model, 0, frameSize.height);
+		completeBg();
+	}
+}
+
+void BackgroundSubtractorIMBS::finalizeBg(ModelSlabs* target, unsigned int firstRow, unsigned int lastRow) {
+	finalizeTarget = target;
+	runStage(&BackgroundSubtractorIMBS::finalizeBgBand, firstRow, lastRow);
+}
+
+void BackgroundSubtractorIMBS::completeBg() {
+	std::cout << "new bg created" << std::endl;
+	isBackgroundCreated = true;
+	persistenceImage = Scalar(0);
+	
+	bg_reset = false;
+	if(sudden_change) {
+		numSamples *= 3.;
+		samplingPeriod *= 2.;
+		sudden_change = false;
+	}
+	
+	for(unsigned int i = 0; i < numPixels; i++) {
+		persistenceMap[i] = 0;
+	}
+	
+	updateBgImage();
+	
+	if(bgFilename != NULL) {
+		//the slabs are copied here and written by the snapshot thread
+		IMBSSnapshotHeader header;
+		memset(&header, 0, sizeof(header));
+		header.width = frameSize.width;
+		header.height = frameSize.height;
+		header.frameType = frameType;
+		header.numBins = maxBgBins;
+
+		const uchar* slabs[IMBS_SNAPSHOT_SLABS] = {
+			model.values[0], model.values[1], model.values[2],
+			model.hsv[0], model.hsv[1], model.hsv[2],
+			(const uchar*)model.isValid, (const uchar*)model.isFg, model.counter
+		};
+		snapshotWriter.write(*bgFilename, header, slabs);
+		bgFilename = NULL;
+	}//if bgFilename
+}
+
+void BackgroundSubtractorIMBS::updateBgImage() {
+	//slab 0 holds the highest bin of every pixel, i.e., the bg image itself
+	vector<Mat> bgPlanes(3);
+	for(int k = 0; k < 3; ++k) {
+		bgPlanes[k] = Mat(frameSize, CV_8UC1, model.values[k]);
+	}
+	cv::merge(bgPlanes, bgImage);
+}
+
+void BackgroundSubtractorIMBS::createBgBand(unsigned int begin, unsigned int end) {
+	const unsigned int bg_sample_number = bgSampleNumber;
+	const uchar* sampleB = bgSampleBGR[0].data;
+	const uchar* sampleG = bgSampleBGR[1].data;
+	const uchar* sampleR = bgSampleBGR[2].data;
+	//create a statistical model for each pixel (a set of bins of variable size)
+	if(bg_sample_number == 0) {
+		//create an initial bin for each pixel from the first sample
+		for(unsigned int p = begin; p < end; ++p) {
+			binValues[p] = Vec3b(sampleB[p], sampleG[p], sampleR[p]);
+			binHeights[p] = 1;
+			//if the sample pixel is from foreground keep track of that situation
+			binIsFg[p] = (fgmask.data[p] == FOREGROUND_LABEL);
+		}
+		for(unsigned int s = 1; s < binCapacity; ++s) {
+			memset(binHeights + (size_t)s * numPixels + begin, 0, end - begin);
+		}
+		return;
+	}
+
+	//try to associate the current pixel values to an existing bin, one bin
+	//slab at a time; pixelState marks the pixels still waiting for a bin
+	memset(pixelState + begin, 1, end - begin);
+	for(unsigned int s = 0; s < bg_sample_number; ++s) {
+		Vec3b* values = binValues + (size_t)s * numPixels;
+		uchar* heights = binHeights + (size_t)s * numPixels;
+		bool* isFg = binIsFg + (size_t)s * numPixels;
+		bool pending = false;
+
+		for(unsigned int p = begin; p < end; ++p) {
+			if(!pixelState[p]) {
+				continue;
 			}
-			bgBins[p].binHeights[0] = 1;
-			for(unsigned int s = 1; s < numSamples; ++s)	{
-				bgBins[p].binHeights[s] = 0;
+			if( std::abs(sampleR[p] - values[p][2]) <= (int) associationThreshold &&
+				std::abs(sampleG[p] - values[p][1]) <= (int) associationThreshold &&
+				std::abs(sampleB[p] - values[p][0]) <= (int) associationThreshold )
+			{
+				const int den = heights[p] + 1;
+				values[p][0] = (values[p][0] * heights[p] + sampleB[p]) / den;
+				values[p][1] = (values[p][1] * heights[p] + sampleG[p]) / den;
+				values[p][2] = (values[p][2] * heights[p] + sampleR[p]) / den;
+				heights[p]++; //increment the height of the bin
+				if(fgmask.data[p] == FOREGROUND_LABEL) {
+					isFg[p] = true;
+				}
+				pixelState[p] = 0;
 			}
-			//if the sample pixel is from foreground keep track of that situation
-			if(fgmask.data[p] == FOREGROUND_LABEL) {
-				bgBins[p].isFg[0] = true;
+			//if the association is not possible, create a new bin
+			else if(heights[p] == 0) {
+				values[p] = Vec3b(sampleB[p], sampleG[p], sampleR[p]);
+				heights[p] = 1;
+				isFg[p] = (fgmask.data[p] == FOREGROUND_LABEL);
+				pixelState[p] = 0;
 			}
 			else {
-				bgBins[p].isFg[0] = false;
+				pending = true;
 			}
-		}//if(bg_sample_number == 0)
-		else { //bg_sample_number > 0
-			for(int k = 0; k < 3; ++k) {
-				currentPixel[k] = bgSampleBGR[k].data[p];
-			}
-			int den = 0;
-			for(unsigned int s = 0; s < bg_sample_number; ++s) {
-				//try to associate the current pixel values to an existing bin
-				if( std::abs(currentPixel[2] - bgBins[p].binValues[s][2]) <= (int) associationThreshold &&
-						 std::abs(currentPixel[1] - bgBins[p].binValues[s][1]) <= (int) associationThreshold &&
-						 std::abs(currentPixel[0] - bgBins[p].binValues[s][0]) <= (int) associationThreshold )
-				{
-					den = (bgBins[p].binHeights[s] + 1);
-					for(int k = 0; k < 3; ++k) {
-						bgBins[p].binValues[s][k] =
-							(bgBins[p].binValues[s][k] * bgBins[p].binHeights[s] + currentPixel[k]) / den;
-					}
-					bgBins[p].binHeights[s]++; //increment the height of the bin
-					if(fgmask.data[p] == FOREGROUND_LABEL) {
-						bgBins[p].isFg[s] = true;
-					}
-					break;
-				}
-				//if the association is not possible, create a new bin
-				else if(bgBins[p].binHeights[s] == 0)	{
-					bgBins[p].binValues[s] = currentPixel;
-					bgBins[p].binHeights[s]++;
-					if(fgmask.data[p] == FOREGROUND_LABEL) {
-						bgBins[p].isFg[s] = true;
-					}
-					else {
-						bgBins[p].isFg[s] = false;
-					}
-					break;
-				}
-				else continue;
-			}//for(unsigned int s = 0; s <= bg_sample_number; ++s)
-
-			//if all samples have been processed
-			//it is time to compute the fg mask
-			if(bg_sample_number == (numSamples - 1)) {
-				unsigned int index = 0;
-				int max_height = -1;
-				for(unsigned int s = 0; s < numSamples; ++s){
-					if(bgBins[p].binHeights[s] == 0) {
-						bgModel[p].isValid[index] = false;
-						break;
-					}
-					if(index == maxBgBins) {
-						break;
-					}
-					else if(bgBins[p].binHeights[s] >= minBinHeight) {
-						if(fgmask.data[p] == PERSISTENCE_LABEL) {
-							for(unsigned int n = 0; n < maxBgBins; n++) {
-								if(!bgModel[p].isValid[n]) {
-									break;
-								}
-								unsigned int d = std::max((int)std::abs(bgModel[p].values[n][0] - bgBins[p].binValues[s][0]),
-									std::abs(bgModel[p].values[n][1] - bgBins[p].binValues[s][1]) );
-								d = std::max((int)d, std::abs(bgModel[p].values[n][2] - bgBins[p].binValues[s][2]) );
-								if(d < fgThreshold){
-									bgModel[p].isFg[n] = false;
-									bgBins[p].isFg[s] = false;
-								}
-							}
-						}
-
-						if(bgBins[p].binHeights[s] > max_height) {
-							max_height = bgBins[p].binHeights[s];
-
-							for(int k = 0; k < 3; ++k) {
-								bgModel[p].values[index][k] = bgModel[p].values[0][k];
-							}
-							bgModel[p].isValid[index] = true;
-							bgModel[p].isFg[index] = bgModel[p].isFg[0];
-							bgModel[p].counter[index] = bgModel[p].counter[0];
-
-							for(int k = 0; k < 3; ++k) {
-								bgModel[p].values[0][k] = bgBins[p].binValues[s][k];
-							}
-							bgModel[p].isValid[0] = true;
-							bgModel[p].isFg[0] = bgBins[p].isFg[s];
-							bgModel[p].counter[0] = bgBins[p].binHeights[s];
-						}
-						else {
-							for(int k = 0; k < 3; ++k) {
-								bgModel[p].values[index][k] = bgBins[p].binValues[s][k];
-							}
-							bgModel[p].isValid[index] = true;
-							bgModel[p].isFg[index] = bgBins[p].isFg[s];
-							bgModel[p].counter[index] = bgBins[p].binHeights[s];
-						}
-						++index;
-					}
-				} //for all numSamples
-			}//bg_sample_number == (numSamples - 1)
-		}//else --> if(frame_number == 0)
-	}//numPixels
-
-	if(bg_sample_number == (numSamples - 1)) {
-		std::cout << "new bg created" << std::endl;
-		isBackgroundCreated = true;
-		persistenceImage = Scalar(0);
-		
-		bg_reset = false;
-		if(sudden_change) {
-			numSamples *= 3.;
-			samplingPeriod *= 2.;
-			sudden_change = false;
 		}
-		
-		for(unsigned int i = 0; i < numPixels; i++) {
-			persistenceMap[i] = 0;
+		if(!pending) {
+			break;
 		}
-		
-		unsigned int p = 0;
-		for(int i = 0; i < bgImage.rows; ++i) {
-			for(int j = 0; j < bgImage.cols; ++j, ++p) {
-				bgImage.at<cv::Vec3b>(i,j) = bgModel[p].values[0];
+	}
+
+}
+
+void BackgroundSubtractorIMBS::finalizeBgBand(unsigned int begin, unsigned int end) {
+	//the bins are compared against the model in use, while the new bins are
+	//written to the target, which is the model itself in batch mode
+	ModelSlabs& target = *finalizeTarget;
+
+	for(unsigned int p = begin; p < end; ++p) {
+		unsigned int index = 0;
+		int max_height = -1;
+		for(unsigned int s = 0; s < binCapacity; ++s) {
+			const size_t b = (size_t)s * numPixels + p;
+			if(binHeights[b] == 0) {
+				break;
 			}
-		}
-		
-		if(bgFilename != NULL) {
-			ofstream file;
-			file.open(bgFilename->c_str());
-			file<<(int)frameSize.width<<" ";
-			file<<(int)frameSize.height<<endl;
-			file<<(int)frameType<<endl;
-			int c = 0;
-			for(int i = 0; i<frameSize.height; i++) {
-				for(int j = 0; j<frameSize.width; j++, c++) {
-					for(unsigned int e = 0; e < maxBgBins; e++) {
-						if(!bgModel[c].isValid[e]) {
-							file<<endl;
+			if(index == maxBgBins) {
+				break;
+			}
+			else if(binHeights[b] >= minBinHeight) {
+				if(fgmask.data[p] == PERSISTENCE_LABEL) {
+					for(unsigned int n = 0; n < maxBgBins; n++) {
+						const size_t m = (size_t)n * numPixels + p;
+						if(!model.isValid[m]) {
 							break;
 						}
-						file<<(int)bgModel[c].values[e].val[2]<<" ";
-						file<<(int)bgModel[c].values[e].val[1]<<" ";
-						file<<(int)bgModel[c].values[e].val[0]<<" ";
-						if(e == (maxBgBins - 1)) {
-							file<<endl;
+						unsigned int d = std::max((int)std::abs(model.values[0][m] - binValues[b][0]),
+							std::abs(model.values[1][m] - binValues[b][1]) );
+						d = std::max((int)d, std::abs(model.values[2][m] - binValues[b][2]) );
+						if(d < fgThreshold){
+							model.isFg[m] = false;
+							binIsFg[b] = false;
 						}
 					}
 				}
+
+				const size_t m = (size_t)index * numPixels + p;
+				if(binHeights[b] > max_height) {
+					max_height = binHeights[b];
+
+					//the highest bin always lives in slab 0
+					target.setValue(m, target.value(p));
+					target.isValid[m] = true;
+					target.isFg[m] = target.isFg[p];
+					target.counter[m] = target.counter[p];
+
+					target.setValue(p, binValues[b]);
+					target.isValid[p] = true;
+					target.isFg[p] = binIsFg[b];
+					target.counter[p] = binHeights[b];
+				}
+				else {
+					target.setValue(m, binValues[b]);
+					target.isValid[m] = true;
+					target.isFg[m] = binIsFg[b];
+					target.counter[m] = binHeights[b];
+				}
+				++index;
 			}
-			file.close();
-			bgFilename = NULL;
-		}//if bgFilename	
-				
+		} //for all bins
+		if(index < maxBgBins) {
+			target.isValid[(size_t)index * numPixels + p] = false;
+		}
+	}//numPixels
+
+	//refresh the HSV cache of the band, one bin slab at a time
+	for(unsigned int n = 0; n < maxBgBins; ++n) {
+		const size_t offset = (size_t)n * numPixels + begin;
+		const uchar* valuePlanes[3] = { target.values[0] + offset, target.values[1] + offset, target.values[2] + offset };
+		uchar* hsvPlanes[3] = { target.hsv[0] + offset, target.hsv[1] + offset, target.hsv[2] + offset };
+		imbsConvertBGRtoHSV(valuePlanes, hsvPlanes, end - begin);
 	}
 }
 
 void BackgroundSubtractorIMBS::getFg() {
-	fgmask = Scalar(0);
 	cv::split(frame, frameBGR);
+	runStage(&BackgroundSubtractorIMBS::getFgBand);
+}
 
-	bool isFg = true;
-	bool conditionalUpdated = false;
-	unsigned int d = 0;
-	for(unsigned int p = 0; p < numPixels; ++p) {
-		isFg = true;
-		conditionalUpdated = false;
-		d = 0;
-		for(unsigned int n = 0; n < maxBgBins; ++n) {
-			if(!bgModel[p].isValid[n]) {
-				if(n == 0) {
-					isFg = false;
-				}
-				break;
-			}
-			else { //the model is valid
-				d = std::max(
-						(int)std::abs(bgModel[p].values[n][0] - frameBGR[0].data[p]),
-						std::abs(bgModel[p].values[n][1] - frameBGR[1].data[p]) );
-				d = std::max(
-						(int)d, std::abs(bgModel[p].values[n][2] - frameBGR[2].data[p]) );
-				if(d < fgThreshold){
-					//check if it is a potential background pixel
-					//from stationary object
-					if(bgModel[p].isFg[n]) {
-						conditionalUpdated = true;
-						break;
-					}
-					else {
-						isFg = false;
-						persistenceMap[p] = 0;
-					}
-				}
-			}
+void BackgroundSubtractorIMBS::getFgBand(unsigned int begin, unsigned int end) {
+	const unsigned int bandPixels = end - begin;
+	const uchar* framePlanes[3] = { frameBGR[0].data + begin, frameBGR[1].data + begin, frameBGR[2].data + begin };
+
+	//every pixel starts as a foreground candidate and is refined one bin slab
+	//at a time until it runs out of valid bins or matches a stationary bin
+	memset(pixelState + begin, IMBS_PIXEL_ACTIVE, bandPixels);
+	for(unsigned int n = 0; n < maxBgBins; ++n) {
+		const size_t offset = (size_t)n * numPixels + begin;
+		const uchar* modelPlanes[3] = { model.values[0] + offset, model.values[1] + offset, model.values[2] + offset };
+
+		if(!imbsMatchBin(framePlanes, modelPlanes, model.isValid + offset, model.isFg + offset,
+						 pixelState + begin, bandPixels, n == 0, fgThreshold)) {
+			break;
 		}
-		if(isFg) {
-			if(conditionalUpdated) {
-				fgmask.data[p] = PERSISTENCE_LABEL;
-				persistenceMap[p] += (timestamp - prev_timestamp);
-				if(persistenceMap[p] > persistencePeriod) {
-					for(unsigned int n = 0; n < maxBgBins; ++n) {
-						if(!bgModel[p].isValid[n]) {
-							break;
-						}
-						bgModel[p].isFg[n] = false;
-					}
+	}
+
+	imbsLabelPixels(pixelState + begin, fgmask.data + begin, bandPixels, FOREGROUND_LABEL, PERSISTENCE_LABEL);
+
+	for(unsigned int p = begin; p < end; ++p) {
+		if(pixelState[p] & IMBS_PIXEL_EMPTY) {
+			continue;
+		}
+		if(pixelState[p] & IMBS_PIXEL_BACKGROUND || !(pixelState[p] & IMBS_PIXEL_CONDITIONAL)) {
+			persistenceMap[p] = 0;
+			continue;
+		}
+		persistenceMap[p] += (timestamp - prev_timestamp);
+		if(persistenceMap[p] > persistencePeriod) {
+			for(unsigned int n = 0; n < maxBgBins; ++n) {
+				const size_t m = (size_t)n * numPixels + p;
+				if(!model.isValid[m]) {
+					break;
 				}
-			}
-			else {
-				fgmask.data[p] = FOREGROUND_LABEL;
-				persistenceMap[p] = 0;
+				model.isFg[m] = false;
 			}
 		}
 	}
@@ -587,137 +788,6 @@ void BackgroundSubtractorIMBS::areaThresholding()
 	}
 }
 
-// Create a HSV image from the RGB image using the full 8-bits, since OpenCV only allows Hues up to 180 instead of 255.
-// ref: "http://cs.haifa.ac.il/hagit/courses/ist/Lectures/Demos/ColorApplet2/t_convert.html"
-// Remember to free the generated HSV image.
-Mat BackgroundSubtractorIMBS::convertImageRGBtoHSV(const Mat& imageRGB)
-{
-	float fR, fG, fB;
-	float fH, fS, fV;
-	const float FLOAT_TO_BYTE = 255.0f;
-	const float BYTE_TO_FLOAT = 1.0f / FLOAT_TO_BYTE;
-
-	// Create a blank HSV image
-	Mat imageHSV(imageRGB.size(), CV_8UC3);
-	//if (!imageHSV || imageRGB->depth != 8 || imageRGB->nChannels != 3) {
-		//printf("ERROR in convertImageRGBtoHSV()! Bad input image.\n");
-		//exit(1);
-	//}
-
-	int h = imageRGB.rows;		// Pixel height.
-	int w = imageRGB.cols;		// Pixel width.
-	//int rowSizeRGB = imageRGB->widthStep;	// Size of row in bytes, including extra padding.
-	//char *imRGB = imageRGB->imageData;	// Pointer to the start of the image pixels.
-	//int rowSizeHSV = imageHSV->widthStep;	// Size of row in bytes, including extra padding.
-	//char *imHSV = imageHSV->imageData;	// Pointer to the start of the image pixels.
-	for (int y = 0; y < h; ++y) {
-		for (int x = 0; x < w; ++x) {
-			// Get the RGB pixel components. NOTE that OpenCV stores RGB pixels in B,G,R order.
-			//uchar *pRGB = (uchar*)(imRGB + y*rowSizeRGB + x*3);
-			int bB = imageRGB.at<Vec3b>(y,x)[0]; //*(uchar*)(pRGB+0);	// Blue component
-			int bG = imageRGB.at<Vec3b>(y,x)[1]; //*(uchar*)(pRGB+1);	// Green component
-			int bR = imageRGB.at<Vec3b>(y,x)[2]; //*(uchar*)(pRGB+2);	// Red component
-
-			// Convert from 8-bit integers to floats.
-			fR = bR * BYTE_TO_FLOAT;
-			fG = bG * BYTE_TO_FLOAT;
-			fB = bB * BYTE_TO_FLOAT;
-
-			// Convert from RGB to HSV, using float ranges 0.0 to 1.0.
-			float fDelta;
-			float fMin, fMax;
-			int iMax;
-			// Get the min and max, but use integer comparisons for slight speedup.
-			if (bB < bG) {
-				if (bB < bR) {
-					fMin = fB;
-					if (bR > bG) {
-						iMax = bR;
-						fMax = fR;
-					}
-					else {
-						iMax = bG;
-						fMax = fG;
-					}
-				}
-				else {
-					fMin = fR;
-					fMax = fG;
-					iMax = bG;
-				}
-			}
-			else {
-				if (bG < bR) {
-					fMin = fG;
-					if (bB > bR) {
-						fMax = fB;
-						iMax = bB;
-					}
-					else {
-						fMax = fR;
-						iMax = bR;
-					}
-				}
-				else {
-					fMin = fR;
-					fMax = fB;
-					iMax = bB;
-				}
-			}
-			fDelta = fMax - fMin;
-			fV = fMax;				// Value (Brightness).
-			if (iMax != 0) {			// Make sure its not pure black.
-				fS = fDelta / fMax;		// Saturation.
-				float ANGLE_TO_UNIT = 1.0f / (6.0f * fDelta);	// Make the Hues between 0.0 to 1.0 instead of 6.0
-				if (iMax == bR) {		// between yellow and magenta.
-					fH = (fG - fB) * ANGLE_TO_UNIT;
-				}
-				else if (iMax == bG) {		// between cyan and yellow.
-					fH = (2.0f/6.0f) + ( fB - fR ) * ANGLE_TO_UNIT;
-				}
-				else {				// between magenta and cyan.
-					fH = (4.0f/6.0f) + ( fR - fG ) * ANGLE_TO_UNIT;
-				}
-				// Wrap outlier Hues around the circle.
-				if (fH < 0.0f)
-					fH += 1.0f;
-				if (fH >= 1.0f)
-					fH -= 1.0f;
-			}
-			else {
-				// color is pure Black.
-				fS = 0;
-				fH = 0;	// undefined hue
-			}
-
-			// Convert from floats to 8-bit integers.
-			int bH = (int)(0.5f + fH * 255.0f);
-			int bS = (int)(0.5f + fS * 255.0f);
-			int bV = (int)(0.5f + fV * 255.0f);
-
-			// Clip the values to make sure it fits within the 8bits.
-			if (bH > 255)
-				bH = 255;
-			if (bH < 0)
-				bH = 0;
-			if (bS > 255)
-				bS = 255;
-			if (bS < 0)
-				bS = 0;
-			if (bV > 255)
-				bV = 255;
-			if (bV < 0)
-				bV = 0;
-
-			// Set the HSV pixel components.
-			imageHSV.at<Vec3b>(y, x)[0] = bH;		// H component
-			imageHSV.at<Vec3b>(y, x)[1] = bS;		// S component
-			imageHSV.at<Vec3b>(y, x)[2] = bV;		// V component
-		}
-	}
-	return imageHSV;
-}
-
 void BackgroundSubtractorIMBS::getBackgroundImage(OutputArray backgroundImage) const
 {
     bgImage.copyTo(backgroundImage);        
@@ -725,18 +795,10 @@ void BackgroundSubtractorIMBS::getBackgroundImage(OutputArray backgroundImage) c
 
 void BackgroundSubtractorIMBS::filterFg() {
 
-	unsigned int cnt = 0;
-	for(unsigned int p = 0; p < numPixels; ++p) {
-		if(fgmask.data[p] == (uchar)255) {
-			fgfiltered.data[p] = 255;
-			cnt++;
-		}
-		else {
-			fgfiltered.data[p] = 0;
-		}
-	}
+	fgCount = 0;
+	runStage(&BackgroundSubtractorIMBS::selectFgBand);
 
-	if(cnt > numPixels*0.5) {
+	if(fgCount > numPixels*0.5) {
 		sudden_change = true;
 	}
 
@@ -746,9 +808,32 @@ void BackgroundSubtractorIMBS::filterFg() {
 		cv::morphologyEx(fgfiltered, fgfiltered, cv::MORPH_CLOSE, element3);
 	}
 
+	//the contour pass needs the whole mask, so it stays serial
 	areaThresholding();
 
-	for(unsigned int p = 0; p < numPixels; ++p) {
+	runStage(&BackgroundSubtractorIMBS::restoreLabelsBand);
+
+	fgfiltered.copyTo(fgmask);
+}
+
+void BackgroundSubtractorIMBS::selectFgBand(unsigned int begin, unsigned int end) {
+
+	unsigned int cnt = 0;
+	for(unsigned int p = begin; p < end; ++p) {
+		if(fgmask.data[p] == (uchar)255) {
+			fgfiltered.data[p] = 255;
+			cnt++;
+		}
+		else {
+			fgfiltered.data[p] = 0;
+		}
+	}
+	__sync_fetch_and_add(&fgCount, cnt);
+}
+
+void BackgroundSubtractorIMBS::restoreLabelsBand(unsigned int begin, unsigned int end) {
+
+	for(unsigned int p = begin; p < end; ++p) {
 		if(fgmask.data[p] == PERSISTENCE_LABEL) {
 			fgfiltered.data[p] = PERSISTENCE_LABEL;
 		}
@@ -757,8 +842,63 @@ void BackgroundSubtractorIMBS::filterFg() {
 			fgfiltered.data[p] = 0;
 		}
 	}
+}
 
-	fgfiltered.copyTo(fgmask);
+void BackgroundSubtractorIMBS::setNumThreads(unsigned int numThreads) {
+	if(threadPool != NULL && threadPool->getNumThreads() == numThreads) {
+		return;
+	}
+
+	delete threadPool;
+	threadPool = NULL;
+
+	if(numThreads > 1) {
+		threadPool = new PTracking::ThreadPool(numThreads);
+	}
+}
+
+void BackgroundSubtractorIMBS::setIncrementalUpdate(bool incremental) {
+	incrementalUpdate = incremental;
+	stagingPending = false;
+
+	//the staging model is normally allocated together with the model
+	if(incremental && model.isValid != NULL && stagingModel.isValid == NULL) {
+		allocateSlabs(stagingModel, (size_t)maxBgBins * numPixels);
+	}
+}
+
+void BackgroundSubtractorIMBS::runStage(Stage stage) {
+	runStage(stage, 0, frameSize.height);
+}
+
+void BackgroundSubtractorIMBS::runStage(Stage stage, unsigned int firstRow, unsigned int lastRow) {
+	if(lastRow <= firstRow) {
+		return;
+	}
+	if(threadPool == NULL || lastRow - firstRow <= 1) {
+		(this->*stage)(firstRow * frameSize.width, lastRow * frameSize.width);
+		return;
+	}
+
+	//a few bands per thread, so that idle threads have something to steal
+	StageContext context;
+	context.self = this;
+	context.stage = stage;
+	context.firstRow = firstRow;
+	context.numRows = lastRow - firstRow;
+	context.numBands = std::min(threadPool->getNumThreads() * BANDS_PER_THREAD, context.numRows);
+
+	threadPool->run(context.numBands, runBand, &context);
+}
+
+void BackgroundSubtractorIMBS::runBand(void* context, unsigned int band) {
+	StageContext* c = (StageContext*)context;
+	const unsigned int rows = c->numRows;
+	const unsigned int cols = c->self->frameSize.width;
+	const unsigned int firstRow = c->firstRow + (unsigned int)((unsigned long)rows * band / c->numBands);
+	const unsigned int lastRow = c->firstRow + (unsigned int)((unsigned long)rows * (band + 1) / c->numBands);
+
+	(c->self->*(c->stage))(firstRow * cols, lastRow * cols);
 }
 
 void BackgroundSubtractorIMBS::changeBg() {
@@ -799,18 +939,64 @@ void BackgroundSubtractorIMBS::getBgModel(BgModel bgModel_copy[], int size) {
 	}
 	for(unsigned int p = 0; p < numPixels; ++p) {
 		for(unsigned int n = 0; n < maxBgBins; ++n) {
-			if(!bgModel[p].isValid[n]) {
+			const size_t m = (size_t)n * numPixels + p;
+			if(!model.isValid[m]) {
 				break;
 			}
-			bgModel_copy[p].values[n] = bgModel[p].values[n];
-			bgModel_copy[p].isValid[n] = bgModel[p].isValid[n];
-			bgModel_copy[p].isFg[n] = bgModel[p].isFg[n];
-			bgModel_copy[p].counter[n] = bgModel[p].counter[n];
+			bgModel_copy[p].values[n] = model.value(m);
+			bgModel_copy[p].isValid[n] = model.isValid[m];
+			bgModel_copy[p].isFg[n] = model.isFg[m];
+			bgModel_copy[p].counter[n] = model.counter[m];
 		}
 	}
 }
 
 bool BackgroundSubtractorIMBS::loadBg(const char* filename) {
+	return loadBgSnapshot(filename) || loadBgText(filename);
+}
+
+bool BackgroundSubtractorIMBS::loadBgSnapshot(const char* filename) {
+	IMBSSnapshotMapping mapping;
+	if(!imbsMapSnapshot(filename, mapping)) {
+		return false;
+	}
+	const IMBSSnapshotHeader& header = *mapping.header;
+
+	loadedBg = true;
+	isBackgroundCreated = true;
+
+	cout << endl;
+	cout << "LOADED BG SNAPSHOT" << endl;
+	cout << endl;
+	cout << "INPUT: WIDTH " << header.width << "  HEIGHT " << header.height <<
+		"  FPS " << fps << endl;
+	cout << endl;
+
+	this->frameSize = Size(header.width, header.height);
+	this->frameType = header.frameType;
+	this->numPixels = frameSize.width*frameSize.height;
+
+	//the model is used straight from the mapped file
+	initializeModel(false);
+	maxBgBins = header.numBins;
+	for(int k = 0; k < 3; ++k) {
+		model.values[k] = mapping.slab(IMBS_SNAPSHOT_B + k);
+		model.hsv[k] = mapping.slab(IMBS_SNAPSHOT_H + k);
+	}
+	model.isValid = (bool*)mapping.slab(IMBS_SNAPSHOT_IS_VALID);
+	model.isFg = (bool*)mapping.slab(IMBS_SNAPSHOT_IS_FG);
+	model.counter = mapping.slab(IMBS_SNAPSHOT_COUNTER);
+	model.mapping = mapping;
+
+	if(incrementalUpdate) {
+		allocateSlabs(stagingModel, (size_t)maxBgBins * numPixels);
+	}
+
+	updateBgImage();
+	return true;
+}
+
+bool BackgroundSubtractorIMBS::loadBgText(const char* filename) {
 	string line;
 	ifstream file(filename, ifstream::in);
 	int c = 0;
@@ -854,50 +1040,8 @@ bool BackgroundSubtractorIMBS::loadBg(const char* filename) {
 		this->frameType = frameType;
 		this->numPixels = frameSize.width*frameSize.height;
 
-		persistenceMap = new unsigned int[numPixels];
-		for(unsigned int i = 0; i < numPixels; i++) {
-			persistenceMap[i] = 0;
-		}
+		initializeModel();
 
-		bgBins = new Bins[numPixels];
-		bgModel = new BgModel[numPixels];
-		maxBgBins = numSamples / minBinHeight;
-
-		timestamp = 0.;//ms
-		prev_timestamp = 0.;//ms
-		prev_bg_frame_time = 0;
-		bg_frame_counter = 0;
-		bg_reset = false;
-		prev_area = 0;
-		sudden_change = false;
-
-		SHADOW_LABEL = 80;
-		PERSISTENCE_LABEL = 180;
-		FOREGROUND_LABEL = 255;
-
-		fgmask.create(frameSize, CV_8UC1);
-		fgfiltered.create(frameSize, CV_8UC1);
-		persistenceImage = Mat::zeros(frameSize, CV_8UC1);
-		bgSample.create(frameSize, CV_8UC3);
-		bgImage = Mat::zeros(frameSize, CV_8UC3);
-
-		if(minBinHeight <= 1){
-			minBinHeight = 1;
-		}
-
-		for(unsigned int p = 0; p < numPixels; ++p)
-		{
-			bgBins[p].binValues = new Vec3b[numSamples];
-			bgBins[p].binHeights = new uchar[numSamples];
-			bgBins[p].isFg = new bool[numSamples];
-			
-			bgModel[p].values = new Vec3b[maxBgBins];
-			bgModel[p].isValid = new bool[maxBgBins];
-			bgModel[p].isValid[0] = false;
-			bgModel[p].isFg = new bool[maxBgBins];
-			bgModel[p].counter = new uchar[maxBgBins];
-		}		
-		
 		while(!file.eof()) {
 			getline(file, line);
 
@@ -926,32 +1070,25 @@ bool BackgroundSubtractorIMBS::loadBg(const char* filename) {
 				ss_b >> b;
 				line.erase(0, index+1);
 				
-				//cout << "io" << endl;
-
-				bgModel[c].values[n].val[0] = b;
-				//cout << "io 1" << endl;
-				bgModel[c].values[n].val[1] = g;
-				//cout << "io 2" << endl;
-				bgModel[c].values[n].val[2] = r;
-				//cout << "io 3" << endl;
-				bgModel[c].isValid[n] = true;
-				//cout << "io 4" << endl;
-				bgModel[c].isFg[n] = false;
-				//cout << "io 5" << endl;
-				bgModel[c].counter[n] = minBinHeight;
-				//cout << "io 6" << endl;
+				const size_t m = (size_t)n * numPixels + c;
+				model.values[0][m] = b;
+				model.values[1][m] = g;
+				model.values[2][m] = r;
+				model.isValid[m] = true;
+				model.isFg[m] = false;
+				model.counter[m] = minBinHeight;
 
 				if(n == 0) {
 					int i = c/bgImage.cols;
 					int j = c - i*bgImage.cols;
-					//cout << "i " << i << " j " << j << endl;
-					bgImage.at<Vec3b>(i, j) = bgModel[c].values[0];
+					bgImage.at<Vec3b>(i, j) = model.value(m);
 				}
 				n++;
 			}
 			c++;
 	    }
 	    file.close();
+	    updateModelHSV();
 	    return true;
 	}
 	else {
@@ -32,6 +32,9 @@
 #include <vector>
 #include <fstream>
 
+#include "imbs_snapshot.hpp"
+#include <Utils/ThreadPool.h>
+
 using namespace cv;
 using namespace std;
 
@@ -66,14 +69,41 @@ public:
     //! re-initiaization method
     void initialize(Size frameSize, int frameType);
 	
+	//! loads a background model, either a binary snapshot (mapped in memory) or a text file
 	bool loadBg(const char* filename);
+	//! saves the next background model created as a binary snapshot
 	void saveBg(string* filename);
 
+    //! sets the number of threads used by the per-pixel stages (1 disables the thread pool)
+    void setNumThreads(unsigned int numThreads);
+    //! enables the incremental update of the background model: every sample is
+    //! folded into the bins as it arrives and the new model is built a few rows
+    //! per frame, then swapped with the one in use
+    void setIncrementalUpdate(bool incremental);
+
 private:
+    struct ModelSlabs;
+
     //method for creating the background model
     void createBg(unsigned int bg_sample_number);
     //method for updating the background model
     void updateBg();
+    //method for updating the background model one sample at a time
+    void updateBgIncremental();
+    //method for building rows [firstRow, lastRow) of a model from the bins
+    void finalizeBg(ModelSlabs* target, unsigned int firstRow, unsigned int lastRow);
+    //method for building the next rows of the staging model, swapping it in when complete
+    void finalizeStagingRows(unsigned int rows);
+    //method for finishing up a new background model
+    void completeBg();
+    //method for copying the highest bin of every pixel in the bg image
+    void updateBgImage();
+    //methods for loading a background model from a binary snapshot or a text file
+    bool loadBgSnapshot(const char* filename);
+    bool loadBgText(const char* filename);
+    //method for initializing the model and the images once the frame size is known
+    //(without the model slabs when they are going to be adopted from a snapshot)
+    void initializeModel(bool withModelSlabs = true);
 		//method for computing the foreground mask
     void getFg();
     //method for suppressing shadows and highlights
@@ -84,16 +114,65 @@ private:
     void areaThresholding();
     //method for getting the current time
     double getTimestamp();
-    //method for converting from RGB to HSV
-    Mat convertImageRGBtoHSV(const Mat& imageRGB);
+    //method for caching the HSV value of every background bin
+    void updateModelHSV();
     //method for changing the bg in case of sudden changes 
     void changeBg();
+    //method for allocating the bin-major model slabs
+    void allocateModel(bool withModelSlabs = true);
+    //method for releasing the bin-major model slabs
+    void releaseModel();
+
+    //per-pixel stages, working on the pixels in [begin, end)
+    typedef void (BackgroundSubtractorIMBS::*Stage)(unsigned int begin, unsigned int end);
+    void createBgBand(unsigned int begin, unsigned int end);
+    void finalizeBgBand(unsigned int begin, unsigned int end);
+    void getFgBand(unsigned int begin, unsigned int end);
+    void hsvSuppressionBand(unsigned int begin, unsigned int end);
+    void selectFgBand(unsigned int begin, unsigned int end);
+    void restoreLabelsBand(unsigned int begin, unsigned int end);
+    //method for running a stage over row bands, in parallel if a thread pool is set
+    void runStage(Stage stage);
+    void runStage(Stage stage, unsigned int firstRow, unsigned int lastRow);
+
+    struct StageContext {
+        BackgroundSubtractorIMBS* self;
+        Stage stage;
+        unsigned int firstRow;
+        unsigned int numRows;
+        unsigned int numBands;
+    };
+    static void runBand(void* context, unsigned int band);
+    static const unsigned int BANDS_PER_THREAD = 4;
+
+    //thread pool of numThreads threads for the per-pixel stages (NULL when running on a single thread)
+    PTracking::ThreadPool* threadPool;
+    //sample number processed by createBgBand()
+    unsigned int bgSampleNumber;
+    //number of foreground pixels found by selectFgBand()
+    unsigned int fgCount;
+    //model written by finalizeBgBand()
+    ModelSlabs* finalizeTarget;
+
+    //incremental update of the background model
+    bool incrementalUpdate;
+    //whether the staging model is being built, and whether it closes a sampling cycle
+    bool stagingPending;
+    bool stagingCycleEnd;
+    //next row of the staging model to be built
+    unsigned int stagingRow;
+    //samples needed before a provisional model is published, while no model exists yet
+    static const unsigned int BOOTSTRAP_SAMPLES = 5;
+    //the first model switches to the slower sampling period
+    bool isFirstBg;
 	
 	
 
     //current input RGB frame
     Mat frame;
     vector<Mat> frameBGR;
+    //HSV planes of the current frame (used for shadow suppression)
+    Mat frameHSV[3];
     //frame size
     Size frameSize;
     //frame type
@@ -113,6 +192,8 @@ private:
 	
 	string* bgFilename;
 	bool loadedBg;
+	//writes the background snapshots off the capture thread
+	IMBSSnapshotWriter snapshotWriter;
 	
     //number of fps
     double fps;
@@ -125,14 +206,13 @@ private:
     Mat initialMsgGray;
     Mat initialMsgRGB;
 	
-    //struct for modeling the background values for a single pixel
-    typedef struct {
-	  Vec3b* binValues;
-	  uchar* binHeights;
-	  bool* isFg;
-    } Bins;
-	  
-	Bins* bgBins;
+    //bins collected while sampling the background. Every field is a single
+    //contiguous slab stored bin-major, i.e., indexed as [s * numPixels + p]
+    Vec3b* binValues;
+    uchar* binHeights;
+    bool* binIsFg;
+    //number of bins each slab has room for
+    unsigned int binCapacity;
 public:
     //struct for modeling the background values for the entire frame
 	typedef struct {
@@ -144,7 +224,36 @@ public:
 	
 	bool isBackgroundCreated;
 private:
-	BgModel* bgModel;
+	//background model, stored bin-major as the sampling bins ([n * numPixels + p])
+	struct ModelSlabs {
+		//values, split in one slab per B, G and R channel
+		uchar* values[3];
+		//HSV value of every bin, computed once per model (one slab per H, S and V)
+		uchar* hsv[3];
+		bool* isValid;
+		bool* isFg;
+		uchar* counter;
+		//snapshot the slabs live in, if they have been loaded with loadBg()
+		IMBSSnapshotMapping mapping;
+
+		Vec3b value(size_t m) const {
+			return Vec3b(values[0][m], values[1][m], values[2][m]);
+		}
+		void setValue(size_t m, const Vec3b& value) {
+			values[0][m] = value[0];
+			values[1][m] = value[1];
+			values[2][m] = value[2];
+		}
+	};
+	static void allocateSlabs(ModelSlabs& slabs, size_t slots);
+	static void releaseSlabs(ModelSlabs& slabs);
+
+	//model used for the foreground computation
+	ModelSlabs model;
+	//model being built by the incremental update, swapped with model once complete
+	ModelSlabs stagingModel;
+	//per-pixel scratch state used by the bin-major loops
+	uchar* pixelState;
 
 	//SHADOW SUPPRESSION PARAMETERS
 	float alpha;
@@ -0,0 +1,375 @@
+/*
+ *  IMBS Background Subtraction Library
+ *
+ *  This file imbs_kernels.cpp contains the scalar, SSE2 and AVX2
+ *  versions of the per-pixel kernels used by the IMBS implementation.
+ *
+ */
+
+#include "imbs_kernels.hpp"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define IMBS_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+typedef bool (*MatchBinFn)(const uchar* const[3], const uchar* const[3], const bool*, const bool*, uchar*, size_t, bool, unsigned int);
+typedef void (*LabelPixelsFn)(const uchar*, uchar*, size_t, uchar, uchar);
+
+static inline uchar absDiff(uchar a, uchar b)
+{
+	return a > b ? a - b : b - a;
+}
+
+static bool matchBinScalar(const uchar* const frame[3], const uchar* const model[3],
+						   const bool* isValid, const bool* isFg, uchar* state,
+						   size_t begin, size_t end, bool firstBin, unsigned int fgThreshold)
+{
+	bool pending = false;
+
+	for(size_t p = begin; p < end; ++p) {
+		if(!(state[p] & IMBS_PIXEL_ACTIVE)) {
+			continue;
+		}
+		if(!isValid[p]) {
+			state[p] &= ~IMBS_PIXEL_ACTIVE;
+			if(firstBin) {
+				state[p] |= IMBS_PIXEL_EMPTY;
+			}
+			continue;
+		}
+		unsigned int d = absDiff(model[0][p], frame[0][p]);
+		if(absDiff(model[1][p], frame[1][p]) > d) d = absDiff(model[1][p], frame[1][p]);
+		if(absDiff(model[2][p], frame[2][p]) > d) d = absDiff(model[2][p], frame[2][p]);
+		if(d < fgThreshold) {
+			//a bin from a stationary object ends the scan of the pixel
+			if(isFg[p]) {
+				state[p] = (state[p] & ~IMBS_PIXEL_ACTIVE) | IMBS_PIXEL_CONDITIONAL;
+				continue;
+			}
+			state[p] |= IMBS_PIXEL_BACKGROUND;
+		}
+		pending = true;
+	}
+	return pending;
+}
+
+static void labelPixelsScalar(const uchar* state, uchar* labels, size_t begin, size_t end,
+							  uchar foregroundLabel, uchar persistenceLabel)
+{
+	for(size_t p = begin; p < end; ++p) {
+		if(state[p] & (IMBS_PIXEL_BACKGROUND | IMBS_PIXEL_EMPTY)) {
+			labels[p] = 0;
+		}
+		else {
+			labels[p] = (state[p] & IMBS_PIXEL_CONDITIONAL) ? persistenceLabel : foregroundLabel;
+		}
+	}
+}
+
+static bool matchBinGeneric(const uchar* const frame[3], const uchar* const model[3],
+							const bool* isValid, const bool* isFg, uchar* state,
+							size_t numPixels, bool firstBin, unsigned int fgThreshold)
+{
+	return matchBinScalar(frame, model, isValid, isFg, state, 0, numPixels, firstBin, fgThreshold);
+}
+
+static void labelPixelsGeneric(const uchar* state, uchar* labels, size_t numPixels,
+							   uchar foregroundLabel, uchar persistenceLabel)
+{
+	labelPixelsScalar(state, labels, 0, numPixels, foregroundLabel, persistenceLabel);
+}
+
+#ifdef IMBS_KERNELS_X86
+
+//d < fgThreshold is evaluated as d <= fgThreshold - 1 with saturated
+//arithmetic, so thresholds above 255 simply match every pixel
+static inline char closeLimit(unsigned int fgThreshold)
+{
+	return (char)(fgThreshold > 255 ? 255 : (fgThreshold == 0 ? 0 : fgThreshold - 1));
+}
+
+__attribute__((target("sse2")))
+static bool matchBinSSE2(const uchar* const frame[3], const uchar* const model[3],
+						 const bool* isValid, const bool* isFg, uchar* state,
+						 size_t numPixels, bool firstBin, unsigned int fgThreshold)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i active = _mm_set1_epi8(IMBS_PIXEL_ACTIVE);
+	const __m128i background = _mm_set1_epi8(IMBS_PIXEL_BACKGROUND);
+	const __m128i conditional = _mm_set1_epi8(IMBS_PIXEL_CONDITIONAL);
+	const __m128i empty = _mm_set1_epi8(firstBin ? IMBS_PIXEL_EMPTY : 0);
+	const __m128i limit = _mm_set1_epi8(closeLimit(fgThreshold));
+	const __m128i closeEnabled = fgThreshold == 0 ? zero : _mm_cmpeq_epi8(zero, zero);
+	__m128i pending = zero;
+
+	size_t p = 0;
+	for(; p + 16 <= numPixels; p += 16) {
+		__m128i s = _mm_loadu_si128((const __m128i*)(state + p));
+		const __m128i isActive = _mm_cmpeq_epi8(_mm_and_si128(s, active), active);
+		if(!_mm_movemask_epi8(isActive)) {
+			continue;
+		}
+
+		const __m128i invalid = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(isValid + p)), zero);
+		const __m128i backgroundBin = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(isFg + p)), zero);
+
+		__m128i d = zero;
+		for(int k = 0; k < 3; ++k) {
+			const __m128i f = _mm_loadu_si128((const __m128i*)(frame[k] + p));
+			const __m128i m = _mm_loadu_si128((const __m128i*)(model[k] + p));
+			d = _mm_max_epu8(d, _mm_or_si128(_mm_subs_epu8(f, m), _mm_subs_epu8(m, f)));
+		}
+		const __m128i close = _mm_and_si128(_mm_cmpeq_epi8(_mm_subs_epu8(d, limit), zero), closeEnabled);
+
+		const __m128i invalidActive = _mm_and_si128(isActive, invalid);
+		const __m128i matched = _mm_and_si128(_mm_andnot_si128(invalid, isActive), close);
+		const __m128i matchedConditional = _mm_andnot_si128(backgroundBin, matched);
+		const __m128i matchedBackground = _mm_and_si128(backgroundBin, matched);
+		const __m128i done = _mm_or_si128(invalidActive, matchedConditional);
+
+		s = _mm_andnot_si128(_mm_and_si128(done, active), s);
+		s = _mm_or_si128(s, _mm_and_si128(matchedConditional, conditional));
+		s = _mm_or_si128(s, _mm_and_si128(matchedBackground, background));
+		s = _mm_or_si128(s, _mm_and_si128(invalidActive, empty));
+		_mm_storeu_si128((__m128i*)(state + p), s);
+
+		pending = _mm_or_si128(pending, _mm_andnot_si128(done, isActive));
+	}
+
+	bool anyPending = _mm_movemask_epi8(pending) != 0;
+	if(p < numPixels) {
+		anyPending |= matchBinScalar(frame, model, isValid, isFg, state, p, numPixels, firstBin, fgThreshold);
+	}
+	return anyPending;
+}
+
+__attribute__((target("sse2")))
+static void labelPixelsSSE2(const uchar* state, uchar* labels, size_t numPixels,
+							uchar foregroundLabel, uchar persistenceLabel)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i notForeground = _mm_set1_epi8(IMBS_PIXEL_BACKGROUND | IMBS_PIXEL_EMPTY);
+	const __m128i conditional = _mm_set1_epi8(IMBS_PIXEL_CONDITIONAL);
+	const __m128i fgLabel = _mm_set1_epi8((char)foregroundLabel);
+	const __m128i persistenceLabels = _mm_set1_epi8((char)persistenceLabel);
+
+	size_t p = 0;
+	for(; p + 16 <= numPixels; p += 16) {
+		const __m128i s = _mm_loadu_si128((const __m128i*)(state + p));
+		const __m128i isForeground = _mm_cmpeq_epi8(_mm_and_si128(s, notForeground), zero);
+		const __m128i isPlain = _mm_cmpeq_epi8(_mm_and_si128(s, conditional), zero);
+		const __m128i label = _mm_or_si128(_mm_and_si128(isPlain, fgLabel), _mm_andnot_si128(isPlain, persistenceLabels));
+		_mm_storeu_si128((__m128i*)(labels + p), _mm_and_si128(label, isForeground));
+	}
+	labelPixelsScalar(state, labels, p, numPixels, foregroundLabel, persistenceLabel);
+}
+
+__attribute__((target("avx2")))
+static bool matchBinAVX2(const uchar* const frame[3], const uchar* const model[3],
+						 const bool* isValid, const bool* isFg, uchar* state,
+						 size_t numPixels, bool firstBin, unsigned int fgThreshold)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i active = _mm256_set1_epi8(IMBS_PIXEL_ACTIVE);
+	const __m256i background = _mm256_set1_epi8(IMBS_PIXEL_BACKGROUND);
+	const __m256i conditional = _mm256_set1_epi8(IMBS_PIXEL_CONDITIONAL);
+	const __m256i empty = _mm256_set1_epi8(firstBin ? IMBS_PIXEL_EMPTY : 0);
+	const __m256i limit = _mm256_set1_epi8(closeLimit(fgThreshold));
+	const __m256i closeEnabled = fgThreshold == 0 ? zero : _mm256_cmpeq_epi8(zero, zero);
+	__m256i pending = zero;
+
+	size_t p = 0;
+	for(; p + 32 <= numPixels; p += 32) {
+		__m256i s = _mm256_loadu_si256((const __m256i*)(state + p));
+		const __m256i isActive = _mm256_cmpeq_epi8(_mm256_and_si256(s, active), active);
+		if(!_mm256_movemask_epi8(isActive)) {
+			continue;
+		}
+
+		const __m256i invalid = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(isValid + p)), zero);
+		const __m256i backgroundBin = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(isFg + p)), zero);
+
+		__m256i d = zero;
+		for(int k = 0; k < 3; ++k) {
+			const __m256i f = _mm256_loadu_si256((const __m256i*)(frame[k] + p));
+			const __m256i m = _mm256_loadu_si256((const __m256i*)(model[k] + p));
+			d = _mm256_max_epu8(d, _mm256_or_si256(_mm256_subs_epu8(f, m), _mm256_subs_epu8(m, f)));
+		}
+		const __m256i close = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(d, limit), zero), closeEnabled);
+
+		const __m256i invalidActive = _mm256_and_si256(isActive, invalid);
+		const __m256i matched = _mm256_and_si256(_mm256_andnot_si256(invalid, isActive), close);
+		const __m256i matchedConditional = _mm256_andnot_si256(backgroundBin, matched);
+		const __m256i matchedBackground = _mm256_and_si256(backgroundBin, matched);
+		const __m256i done = _mm256_or_si256(invalidActive, matchedConditional);
+
+		s = _mm256_andnot_si256(_mm256_and_si256(done, active), s);
+		s = _mm256_or_si256(s, _mm256_and_si256(matchedConditional, conditional));
+		s = _mm256_or_si256(s, _mm256_and_si256(matchedBackground, background));
+		s = _mm256_or_si256(s, _mm256_and_si256(invalidActive, empty));
+		_mm256_storeu_si256((__m256i*)(state + p), s);
+
+		pending = _mm256_or_si256(pending, _mm256_andnot_si256(done, isActive));
+	}
+
+	bool anyPending = _mm256_movemask_epi8(pending) != 0;
+	if(p < numPixels) {
+		anyPending |= matchBinScalar(frame, model, isValid, isFg, state, p, numPixels, firstBin, fgThreshold);
+	}
+	return anyPending;
+}
+
+__attribute__((target("avx2")))
+static void labelPixelsAVX2(const uchar* state, uchar* labels, size_t numPixels,
+							uchar foregroundLabel, uchar persistenceLabel)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i notForeground = _mm256_set1_epi8(IMBS_PIXEL_BACKGROUND | IMBS_PIXEL_EMPTY);
+	const __m256i conditional = _mm256_set1_epi8(IMBS_PIXEL_CONDITIONAL);
+	const __m256i fgLabel = _mm256_set1_epi8((char)foregroundLabel);
+	const __m256i persistenceLabels = _mm256_set1_epi8((char)persistenceLabel);
+
+	size_t p = 0;
+	for(; p + 32 <= numPixels; p += 32) {
+		const __m256i s = _mm256_loadu_si256((const __m256i*)(state + p));
+		const __m256i isForeground = _mm256_cmpeq_epi8(_mm256_and_si256(s, notForeground), zero);
+		const __m256i isPlain = _mm256_cmpeq_epi8(_mm256_and_si256(s, conditional), zero);
+		const __m256i label = _mm256_or_si256(_mm256_and_si256(isPlain, fgLabel), _mm256_andnot_si256(isPlain, persistenceLabels));
+		_mm256_storeu_si256((__m256i*)(labels + p), _mm256_and_si256(label, isForeground));
+	}
+	labelPixelsScalar(state, labels, p, numPixels, foregroundLabel, persistenceLabel);
+}
+
+#endif //IMBS_KERNELS_X86
+
+//lookup tables for the RGB to HSV conversion
+struct HSVTables {
+	//saturation byte, indexed by [max * 256 + min]
+	uchar saturation[256 * 256];
+	//1 / (6 * delta), so that the hue fraction is (difference * reciprocal)
+	float hueReciprocal[256];
+
+	HSVTables()
+	{
+		const float BYTE_TO_FLOAT = 1.0f / 255.0f;
+
+		for(int max = 0; max < 256; ++max) {
+			for(int min = 0; min < 256; ++min) {
+				int bS = 0;
+				if(max != 0 && min <= max) {
+					const float fMax = max * BYTE_TO_FLOAT;
+					const float fDelta = fMax - min * BYTE_TO_FLOAT;
+					bS = (int)(0.5f + (fDelta / fMax) * 255.0f);
+					if(bS > 255) bS = 255;
+					if(bS < 0) bS = 0;
+				}
+				saturation[max * 256 + min] = (uchar)bS;
+			}
+		}
+		hueReciprocal[0] = 0.0f;
+		for(int delta = 1; delta < 256; ++delta) {
+			hueReciprocal[delta] = 1.0f / (6.0f * delta);
+		}
+	}
+};
+
+static const HSVTables& hsvTables()
+{
+	static const HSVTables tables;
+	return tables;
+}
+
+void imbsConvertBGRtoHSV(const uchar* const bgr[3], uchar* const hsv[3], size_t numPixels)
+{
+	const HSVTables& tables = hsvTables();
+	const uchar* blue = bgr[0];
+	const uchar* green = bgr[1];
+	const uchar* red = bgr[2];
+
+	for(size_t p = 0; p < numPixels; ++p) {
+		const int b = blue[p];
+		const int g = green[p];
+		const int r = red[p];
+		const int max = std::max(b, std::max(g, r));
+		const int min = std::min(b, std::min(g, r));
+		const int delta = max - min;
+
+		int bH = 0;
+		if(delta != 0) {
+			float fH;
+			if(max == r) {			// between yellow and magenta.
+				fH = (g - b) * tables.hueReciprocal[delta];
+			}
+			else if(max == g) {		// between cyan and yellow.
+				fH = (2.0f/6.0f) + (b - r) * tables.hueReciprocal[delta];
+			}
+			else {					// between magenta and cyan.
+				fH = (4.0f/6.0f) + (r - g) * tables.hueReciprocal[delta];
+			}
+			// Wrap outlier Hues around the circle.
+			if(fH < 0.0f)
+				fH += 1.0f;
+			if(fH >= 1.0f)
+				fH -= 1.0f;
+			bH = (int)(0.5f + fH * 255.0f);
+			if(bH > 255)
+				bH = 255;
+		}
+
+		hsv[0][p] = (uchar)bH;
+		hsv[1][p] = tables.saturation[max * 256 + min];
+		hsv[2][p] = (uchar)max;
+	}
+}
+
+struct Kernels {
+	MatchBinFn matchBin;
+	LabelPixelsFn labelPixels;
+	const char* instructionSet;
+};
+
+static Kernels selectKernels()
+{
+	Kernels kernels = { matchBinGeneric, labelPixelsGeneric, "scalar" };
+#ifdef IMBS_KERNELS_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) {
+		kernels.matchBin = matchBinAVX2;
+		kernels.labelPixels = labelPixelsAVX2;
+		kernels.instructionSet = "avx2";
+	}
+	else if(__builtin_cpu_supports("sse2")) {
+		kernels.matchBin = matchBinSSE2;
+		kernels.labelPixels = labelPixelsSSE2;
+		kernels.instructionSet = "sse2";
+	}
+#endif
+	return kernels;
+}
+
+static const Kernels& kernels()
+{
+	static const Kernels selected = selectKernels();
+	return selected;
+}
+
+bool imbsMatchBin(const uchar* const frame[3], const uchar* const model[3],
+				  const bool* isValid, const bool* isFg, uchar* state,
+				  size_t numPixels, bool firstBin, unsigned int fgThreshold)
+{
+	return kernels().matchBin(frame, model, isValid, isFg, state, numPixels, firstBin, fgThreshold);
+}
+
+void imbsLabelPixels(const uchar* state, uchar* labels, size_t numPixels,
+					 uchar foregroundLabel, uchar persistenceLabel)
+{
+	kernels().labelPixels(state, labels, numPixels, foregroundLabel, persistenceLabel);
+}
+
+const char* imbsKernelsInstructionSet()
+{
+	return kernels().instructionSet;
+}
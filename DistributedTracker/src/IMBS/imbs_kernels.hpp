@@ -0,0 +1,45 @@
+/*
+ *  IMBS Background Subtraction Library
+ *
+ *  This file imbs_kernels.hpp contains the per-pixel kernels used by
+ *  the IMBS implementation in imbs.cpp. Every kernel has a scalar
+ *  version and, on x86, SSE2 and AVX2 versions that are selected at
+ *  runtime according to the capabilities of the CPU.
+ *
+ */
+
+#ifndef __IMBS_KERNELS_HPP__
+#define __IMBS_KERNELS_HPP__
+
+#include <cstddef>
+
+typedef unsigned char uchar;
+
+//per-pixel states used while scanning the bin-major model
+enum {
+	IMBS_PIXEL_ACTIVE = 0x01,		//still looking for a matching bin
+	IMBS_PIXEL_BACKGROUND = 0x02,	//matched a background bin
+	IMBS_PIXEL_CONDITIONAL = 0x04,	//matched a bin from a stationary object
+	IMBS_PIXEL_EMPTY = 0x08			//no valid bin at all
+};
+
+//matches the pixels in [0, numPixels) against the bin slab given by model,
+//isValid and isFg, updating their state. Returns whether at least one pixel
+//still needs to be checked against the next bin.
+bool imbsMatchBin(const uchar* const frame[3], const uchar* const model[3],
+				  const bool* isValid, const bool* isFg, uchar* state,
+				  size_t numPixels, bool firstBin, unsigned int fgThreshold);
+
+//writes the FOREGROUND/PERSISTENCE labels of the pixels whose final state
+//is neither background nor empty, zero otherwise
+void imbsLabelPixels(const uchar* state, uchar* labels, size_t numPixels,
+					 uchar foregroundLabel, uchar persistenceLabel);
+
+//converts BGR planes to 8-bit HSV planes (hue in [0, 255] instead of OpenCV's
+//[0, 180]), using lookup tables for the saturation and the hue divisions
+void imbsConvertBGRtoHSV(const uchar* const bgr[3], uchar* const hsv[3], size_t numPixels);
+
+//name of the instruction set chosen for the kernels ("avx2", "sse2" or "scalar")
+const char* imbsKernelsInstructionSet();
+
+#endif //__IMBS_KERNELS_HPP__
@@ -0,0 +1,185 @@
+/*
+ *  IMBS Background Subtraction Library
+ *
+ *  This file imbs_snapshot.cpp contains the implementation of the binary
+ *  snapshots of the IMBS background model.
+ *
+ */
+
+#include "imbs_snapshot.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//the bool slabs are stored as they are in memory
+typedef char imbs_snapshot_bool_check[sizeof(bool) == 1 ? 1 : -1];
+
+static const uint32_t SNAPSHOT_DATA_ALIGNMENT = 4096;
+
+bool imbsMapSnapshot(const char* filename, IMBSSnapshotMapping& mapping)
+{
+	mapping.address = 0;
+	mapping.size = 0;
+	mapping.header = 0;
+
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(IMBSSnapshotHeader)) {
+		close(fd);
+		return false;
+	}
+
+	//private mapping: the model is updated in place without touching the file
+	void* address = mmap(0, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(address == MAP_FAILED) {
+		return false;
+	}
+
+	const IMBSSnapshotHeader* header = (const IMBSSnapshotHeader*)address;
+	const size_t slabSize = (size_t)header->numBins * header->width * header->height;
+	if(memcmp(header->magic, "IMBS", 4) != 0 ||
+	   header->version != IMBS_SNAPSHOT_VERSION ||
+	   header->numSlabs != IMBS_SNAPSHOT_SLABS ||
+	   header->width <= 0 || header->height <= 0 || header->numBins == 0 ||
+	   header->dataOffset < sizeof(IMBSSnapshotHeader) ||
+	   (size_t)info.st_size < header->dataOffset + IMBS_SNAPSHOT_SLABS * slabSize) {
+		munmap(address, info.st_size);
+		return false;
+	}
+
+	mapping.address = address;
+	mapping.size = info.st_size;
+	mapping.header = header;
+	return true;
+}
+
+void imbsUnmapSnapshot(IMBSSnapshotMapping& mapping)
+{
+	if(mapping.address != 0) {
+		munmap(mapping.address, mapping.size);
+	}
+	mapping.address = 0;
+	mapping.size = 0;
+	mapping.header = 0;
+}
+
+IMBSSnapshotWriter::IMBSSnapshotWriter()
+{
+	started = false;
+	pending = false;
+	stopping = false;
+
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&wakeUp, 0);
+}
+
+IMBSSnapshotWriter::~IMBSSnapshotWriter()
+{
+	if(started) {
+		pthread_mutex_lock(&mutex);
+		stopping = true;
+		pthread_cond_signal(&wakeUp);
+		pthread_mutex_unlock(&mutex);
+
+		pthread_join(thread, 0);
+	}
+
+	pthread_cond_destroy(&wakeUp);
+	pthread_mutex_destroy(&mutex);
+}
+
+void IMBSSnapshotWriter::write(const std::string& filename, const IMBSSnapshotHeader& header,
+							   const uchar* const slabs[IMBS_SNAPSHOT_SLABS])
+{
+	const size_t slabSize = (size_t)header.numBins * header.width * header.height;
+
+	pthread_mutex_lock(&mutex);
+	queued.filename = filename;
+	queued.header = header;
+	memcpy(queued.header.magic, "IMBS", 4);
+	queued.header.version = IMBS_SNAPSHOT_VERSION;
+	queued.header.numSlabs = IMBS_SNAPSHOT_SLABS;
+	queued.header.dataOffset = SNAPSHOT_DATA_ALIGNMENT;
+	queued.data.resize(IMBS_SNAPSHOT_SLABS * slabSize);
+	for(unsigned int i = 0; i < IMBS_SNAPSHOT_SLABS; ++i) {
+		memcpy(&queued.data[i * slabSize], slabs[i], slabSize);
+	}
+	pending = true;
+
+	//the thread is started with the first snapshot
+	if(!started) {
+		started = pthread_create(&thread, 0, writerMain, this) == 0;
+	}
+	pthread_cond_signal(&wakeUp);
+	pthread_mutex_unlock(&mutex);
+
+	if(!started) {
+		writeFile(queued);
+		pending = false;
+	}
+}
+
+void* IMBSSnapshotWriter::writerMain(void* writer)
+{
+	((IMBSSnapshotWriter*)writer)->writerLoop();
+	return 0;
+}
+
+void IMBSSnapshotWriter::writerLoop()
+{
+	pthread_mutex_lock(&mutex);
+	while(true) {
+		while(!pending && !stopping) {
+			pthread_cond_wait(&wakeUp, &mutex);
+		}
+		//a queued snapshot is always written, even when stopping
+		if(!pending) {
+			break;
+		}
+		queued.filename.swap(writing.filename);
+		queued.data.swap(writing.data);
+		writing.header = queued.header;
+		pending = false;
+		pthread_mutex_unlock(&mutex);
+
+		if(!writeFile(writing)) {
+			std::cerr << "IMBS: unable to write the background snapshot " << writing.filename << std::endl;
+		}
+
+		pthread_mutex_lock(&mutex);
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+bool IMBSSnapshotWriter::writeFile(const Snapshot& snapshot)
+{
+	//written aside and renamed, so that a reader never maps a partial snapshot
+	const std::string temporary = snapshot.filename + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if(file == 0) {
+		return false;
+	}
+
+	std::vector<char> header(snapshot.header.dataOffset, 0);
+	memcpy(&header[0], &snapshot.header, sizeof(IMBSSnapshotHeader));
+
+	bool done = fwrite(&header[0], 1, header.size(), file) == header.size() &&
+				fwrite(&snapshot.data[0], 1, snapshot.data.size(), file) == snapshot.data.size();
+	done = fclose(file) == 0 && done;
+
+	if(!done || rename(temporary.c_str(), snapshot.filename.c_str()) != 0) {
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
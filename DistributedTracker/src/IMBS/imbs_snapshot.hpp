@@ -0,0 +1,99 @@
+/*
+ *  IMBS Background Subtraction Library
+ *
+ *  This file imbs_snapshot.hpp contains the binary snapshot format of the
+ *  IMBS background model, a memory-mapped reader and a writer running on
+ *  its own thread.
+ *
+ */
+
+#ifndef __IMBS_SNAPSHOT_HPP__
+#define __IMBS_SNAPSHOT_HPP__
+
+#include <pthread.h>
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+typedef unsigned char uchar;
+
+static const uint32_t IMBS_SNAPSHOT_VERSION = 1;
+
+//slabs stored in a snapshot, in file order. Every slab is numBins * numPixels
+//bytes long and bin-major, exactly as the model in memory
+enum {
+	IMBS_SNAPSHOT_B, IMBS_SNAPSHOT_G, IMBS_SNAPSHOT_R,
+	IMBS_SNAPSHOT_H, IMBS_SNAPSHOT_S, IMBS_SNAPSHOT_V,
+	IMBS_SNAPSHOT_IS_VALID, IMBS_SNAPSHOT_IS_FG, IMBS_SNAPSHOT_COUNTER,
+	IMBS_SNAPSHOT_SLABS
+};
+
+//header at the beginning of a snapshot file; the slabs start at dataOffset,
+//which is page aligned. Values are stored in the byte order of the writer
+struct IMBSSnapshotHeader {
+	char magic[4];			//"IMBS"
+	uint32_t version;
+	int32_t width;
+	int32_t height;
+	int32_t frameType;
+	uint32_t numBins;
+	uint32_t numSlabs;
+	uint32_t dataOffset;
+};
+
+//a snapshot mapped in memory (private, copy-on-write mapping)
+struct IMBSSnapshotMapping {
+	void* address;
+	size_t size;
+	const IMBSSnapshotHeader* header;
+
+	uchar* slab(unsigned int i) const {
+		const size_t slabSize = (size_t)header->numBins * header->width * header->height;
+		return (uchar*)address + header->dataOffset + i * slabSize;
+	}
+};
+
+//maps filename in memory; returns false if it cannot be opened or is not a valid snapshot
+bool imbsMapSnapshot(const char* filename, IMBSSnapshotMapping& mapping);
+void imbsUnmapSnapshot(IMBSSnapshotMapping& mapping);
+
+class IMBSSnapshotWriter
+{
+public:
+    IMBSSnapshotWriter();
+    //! the destructor, which waits for the snapshot being written
+    ~IMBSSnapshotWriter();
+
+    //! copies the slabs and returns, the file is written by the writer thread.
+    //! A snapshot still waiting to be written is replaced by the new one
+    void write(const std::string& filename, const IMBSSnapshotHeader& header,
+               const uchar* const slabs[IMBS_SNAPSHOT_SLABS]);
+
+private:
+    struct Snapshot {
+        std::string filename;
+        IMBSSnapshotHeader header;
+        std::vector<uchar> data;
+    };
+
+    IMBSSnapshotWriter(const IMBSSnapshotWriter&);
+    IMBSSnapshotWriter& operator=(const IMBSSnapshotWriter&);
+
+    static void* writerMain(void* writer);
+    void writerLoop();
+    static bool writeFile(const Snapshot& snapshot);
+
+    pthread_t thread;
+    bool started;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeUp;
+    bool pending;
+    bool stopping;
+
+    //snapshot waiting for the writer, and the one being written
+    Snapshot queued;
+    Snapshot writing;
+};
+
+#endif //__IMBS_SNAPSHOT_HPP__
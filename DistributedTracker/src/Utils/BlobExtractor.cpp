@@ -0,0 +1,207 @@
+#include "BlobExtractor.h"
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+
+void Blob::rowHistogramInColumns(int xBegin, int xEnd, vector<int>& histogram) const
+{
+	histogram.assign(boundingBox.height,0);
+	
+	for (vector<Run>::const_iterator it = runs.begin(); it != runs.end(); ++it)
+	{
+		const int begin = max(it->begin,xBegin);
+		const int end = min(it->end,xEnd);
+		
+		if (begin < end) histogram[it->row - boundingBox.y] += end - begin;
+	}
+}
+
+bool Blob::barycenter(const vector<int>& histogram, int begin, int end, float& value)
+{
+	int whiteCounter = 0;
+	
+	value = 0.0;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		value += histogram[i] * (i - begin);
+		whiteCounter += histogram[i];
+	}
+	
+	if (whiteCounter == 0) return false;
+	
+	value /= whiteCounter;
+	
+	return true;
+}
+
+int BlobExtractor::findRoot(int label)
+{
+	int root = label;
+	
+	while (parents[root] != root) root = parents[root];
+	
+	// Path compression.
+	while (parents[label] != root)
+	{
+		int next = parents[label];
+		
+		parents[label] = root;
+		label = next;
+	}
+	
+	return root;
+}
+
+const vector<Blob>& BlobExtractor::extract(const Mat& mask, int minArea, int maxArea)
+{
+	runs.clear();
+	labels.clear();
+	parents.clear();
+	blobs.clear();
+	
+	int previousRowBegin = 0, previousRowEnd = 0;
+	
+	/// Run-length encoding of the mask, merging every run with the 8-connected runs of the previous row.
+	for (int y = 0; y < mask.rows; ++y)
+	{
+		const uchar* row = mask.ptr<uchar>(y);
+		int currentRowBegin = runs.size();
+		int previous = previousRowBegin;
+		
+		for (int x = 0; x < mask.cols; )
+		{
+			if (row[x] == 0)
+			{
+				++x;
+				
+				continue;
+			}
+			
+			Blob::Run run;
+			
+			run.row = y;
+			run.begin = x;
+			
+			while ((x < mask.cols) && (row[x] != 0)) ++x;
+			
+			run.end = x;
+			
+			int label = parents.size();
+			
+			parents.push_back(label);
+			
+			// Runs of the previous row ending before this one can't touch the following ones either.
+			while ((previous < previousRowEnd) && (runs[previous].end < run.begin)) ++previous;
+			
+			for (int i = previous; (i < previousRowEnd) && (runs[i].begin <= run.end); ++i)
+			{
+				int root = findRoot(labels[i]), ownRoot = findRoot(label);
+				
+				if (root < ownRoot) parents[ownRoot] = root;
+				else if (ownRoot < root) parents[root] = ownRoot;
+			}
+			
+			runs.push_back(run);
+			labels.push_back(label);
+		}
+		
+		previousRowBegin = currentRowBegin;
+		previousRowEnd = runs.size();
+	}
+	
+	/// Area and bounding box of every component.
+	blobIndices.assign(parents.size(),-1);
+	
+	vector<Blob> components;
+	
+	for (size_t i = 0; i < runs.size(); ++i)
+	{
+		int root = findRoot(labels[i]);
+		
+		if (blobIndices[root] == -1)
+		{
+			blobIndices[root] = components.size();
+			components.push_back(Blob());
+			components.back().area = 0;
+			components.back().boundingBox = Rect(runs[i].begin,runs[i].row,0,0);
+		}
+		
+		Blob& blob = components[blobIndices[root]];
+		Rect& boundingBox = blob.boundingBox;
+		
+		blob.area += runs[i].end - runs[i].begin;
+		
+		int right = max(boundingBox.x + boundingBox.width,runs[i].end);
+		
+		boundingBox.x = min(boundingBox.x,runs[i].begin);
+		boundingBox.width = right - boundingBox.x;
+		boundingBox.height = runs[i].row + 1 - boundingBox.y;
+		
+		labels[i] = blobIndices[root];
+	}
+	
+	/// Keeping only the blobs in the area range.
+	vector<int> selected(components.size(),-1);
+	
+	for (size_t i = 0; i < components.size(); ++i)
+	{
+		if ((components[i].area < minArea) || (components[i].area >= maxArea)) continue;
+		
+		selected[i] = blobs.size();
+		blobs.push_back(components[i]);
+	}
+	
+	for (size_t i = 0; i < runs.size(); ++i)
+	{
+		if (selected[labels[i]] != -1) blobs[selected[labels[i]]].runs.push_back(runs[i]);
+	}
+	
+	for (vector<Blob>::iterator it = blobs.begin(); it != blobs.end(); ++it)
+	{
+		summarize(*it);
+	}
+	
+	return blobs;
+}
+
+void BlobExtractor::summarize(Blob& blob) const
+{
+	const Rect& boundingBox = blob.boundingBox;
+	
+	blob.columnHistogram.assign(boundingBox.width,0);
+	blob.rowHistogram.assign(boundingBox.height,0);
+	blob.feetHistogram.assign(boundingBox.width,0);
+	blob.headHistogram.assign(boundingBox.width,0);
+	
+	// Rows of the feet start at (int) (y + 0.8 * height), the ones of the head end before y + height - 0.8 * height.
+	const int feetStart = boundingBox.y + (boundingBox.height * 0.8);
+	const double headEnd = boundingBox.y + boundingBox.height - (boundingBox.height * 0.8);
+	
+	for (vector<Blob::Run>::const_iterator it = blob.runs.begin(); it != blob.runs.end(); ++it)
+	{
+		const bool isFeet = it->row >= feetStart;
+		const bool isHead = it->row < headEnd;
+		
+		blob.rowHistogram[it->row - boundingBox.y] += it->end - it->begin;
+		
+		for (int x = it->begin - boundingBox.x; x < (it->end - boundingBox.x); ++x)
+		{
+			++blob.columnHistogram[x];
+			
+			if (isFeet) ++blob.feetHistogram[x];
+			if (isHead) ++blob.headHistogram[x];
+		}
+	}
+}
+
+void BlobExtractor::draw(Mat& image, const Blob& blob, uchar value)
+{
+	for (vector<Blob::Run>::const_iterator it = blob.runs.begin(); it != blob.runs.end(); ++it)
+	{
+		uchar* row = image.ptr<uchar>(it->row);
+		
+		fill(row + it->begin,row + it->end,value);
+	}
+}
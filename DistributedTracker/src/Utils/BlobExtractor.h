@@ -0,0 +1,70 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+/**
+ * @brief Connected component (8-connectivity) of a foreground mask, summarized while labeling.
+ */
+struct Blob
+{
+	/**
+	 * @brief Horizontal run of white pixels [begin,end) of a row.
+	 */
+	struct Run
+	{
+		int row, begin, end;
+	};
+	
+	/// Runs of the blob, sorted by row.
+	std::vector<Run> runs;
+	
+	cv::Rect boundingBox;
+	int area;
+	
+	/// White pixels of every column of the bounding box.
+	std::vector<int> columnHistogram;
+	
+	/// White pixels of every row of the bounding box.
+	std::vector<int> rowHistogram;
+	
+	/// White pixels of every column in the bottom 20% of the bounding box (feet).
+	std::vector<int> feetHistogram;
+	
+	/// White pixels of every column in the top 20% of the bounding box (head).
+	std::vector<int> headHistogram;
+	
+	/**
+	 * @brief Counts the white pixels of every row of the bounding box within the columns [xBegin,xEnd).
+	 */
+	void rowHistogramInColumns(int xBegin, int xEnd, std::vector<int>& histogram) const;
+	
+	/**
+	 * @brief Computes the barycenter of the columns [begin,end) of a column histogram, relative to begin.
+	 * 
+	 * @return false if there are no white pixels in those columns.
+	 */
+	static bool barycenter(const std::vector<int>& histogram, int begin, int end, float& value);
+};
+
+class BlobExtractor
+{
+	private:
+		std::vector<Blob::Run> runs;
+		std::vector<int> labels, parents, blobIndices;
+		std::vector<Blob> blobs;
+		
+		int findRoot(int label);
+		void summarize(Blob& blob) const;
+		
+	public:
+		/**
+		 * @brief Labels the non-zero pixels of a CV_8UC1 mask with a single scan, keeping the blobs whose area is in [minArea,maxArea).
+		 */
+		const std::vector<Blob>& extract(const cv::Mat& mask, int minArea, int maxArea);
+		
+		/**
+		 * @brief Paints the pixels of a blob on a CV_8UC1 image.
+		 */
+		static void draw(cv::Mat& image, const Blob& blob, uchar value);
+};
@@ -0,0 +1,68 @@
+#include "IntegralHistogram.h"
+#include <Manfield/utils/debugutils.h>
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+using namespace PTracking;
+
+IntegralHistogram::IntegralHistogram() : binShift(0), bins(AppearanceHistogram::BINS), stride(AppearanceHistogram::CHANNELS * bins)
+{
+	while ((bins << binShift) < 256) ++binShift;
+	
+	counts.resize(stride);
+}
+
+void IntegralHistogram::compute(const Mat& image, const Rect& region)
+{
+	this->region = region;
+	
+	columns.assign((region.width + 1) * stride,0);
+	
+	/// Histogram of every column, stored one cell to the right so that the first cell stays zero.
+	for (int y = 0; y < region.height; ++y)
+	{
+		const uchar* pixel = image.ptr<uchar>(region.y + y) + (3 * region.x);
+		int* column = &columns[stride];
+		
+		for (int x = 0; x < region.width; ++x, pixel += 3, column += stride)
+		{
+			++column[pixel[0] >> binShift];
+			++column[bins + (pixel[1] >> binShift)];
+			++column[(2 * bins) + (pixel[2] >> binShift)];
+		}
+	}
+	
+	for (int x = 1; x <= region.width; ++x)
+	{
+		const int* previous = &columns[(x - 1) * stride];
+		int* column = &columns[x * stride];
+		
+		for (int i = 0; i < stride; ++i)
+		{
+			column[i] += previous[i];
+		}
+	}
+}
+
+void IntegralHistogram::getHistograms(const Rect& rect, ObjectSensorReading::Model& model) const
+{
+	/// Only the columns are integrated, any other rectangle would silently get the counts of the whole height.
+	if ((rect.y != region.y) || (rect.height != region.height) || (rect.x < region.x) || ((rect.x + rect.width) > (region.x + region.width)))
+	{
+		ERR("The rectangle [" << rect.x << "," << rect.y << "," << rect.width << "," << rect.height << "] is not a vertical split of the region [" << region.x << ","
+			<< region.y << "," << region.width << "," << region.height << "] of the integral histogram." << endl);
+		
+		return;
+	}
+	
+	const int* left = &columns[(rect.x - region.x) * stride];
+	const int* right = &columns[(rect.x - region.x + rect.width) * stride];
+	
+	for (int i = 0; i < stride; ++i)
+	{
+		counts[i] = right[i] - left[i];
+	}
+	
+	model.histograms = AppearanceHistogram(&counts[0]);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+#include <Core/Filters/ObjectSensorReading.h>
+#include <vector>
+
+/**
+ * @brief Column-wise integral histogram of the three channels of a CV_8UC3 image region, quantized to the bins of PTracking::AppearanceHistogram.
+ *
+ * Once computed, the histogram of any rectangle spanning the whole height of the region (as the vertical splits of a blob do) is obtained in O(bins) instead of O(area).
+ */
+class IntegralHistogram
+{
+	private:
+		/// Cumulative bin counts of the columns before every column, (region.width + 1) cells of 3 * bins counters each.
+		std::vector<int> columns;
+		mutable std::vector<int> counts;
+		cv::Rect region;
+		int binShift, bins, stride;
+		
+	public:
+		IntegralHistogram();
+		
+		/**
+		 * @brief Computes the integral histogram of a region of a CV_8UC3 image.
+		 */
+		void compute(const cv::Mat& image, const cv::Rect& region);
+		
+		/**
+		 * @brief Sets the histograms of a rectangle (image coordinates, inside the region and spanning its whole height) in a model.
+		 *
+		 * Any other rectangle is reported as an error and leaves the model unchanged.
+		 */
+		void getHistograms(const cv::Rect& rect, PTracking::ObjectSensorReading::Model& model) const;
+};
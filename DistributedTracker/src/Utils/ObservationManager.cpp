@@ -2,6 +2,7 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <iostream>
+#include <numeric>
 
 using namespace std;
 using namespace cv;
@@ -9,10 +10,11 @@ using namespace PTracking;
 
 ObservationManager::ObservationManager(Etiseo::CameraModel* cameraModel, const Mat& H, double resolution) : cameraModel(cameraModel), H(H), resolution(resolution) {;}
 
-vector<Rect> ObservationManager::filterBoundingBoxHorizontal(Mat& image, const Rect& boundingBox, int split, float whitePercentage)
+vector<Rect> ObservationManager::filterBoundingBoxHorizontal(const Blob& blob, const Rect& boundingBox, int split, float whitePercentage)
 {
 	vector<Rect> boundingBoxes;
-	int area, counter, height, i, minX, maxX, startBoundingBoxY, step, width;
+	vector<int> whiteRows;
+	int area, counter, height, i, minX, maxX, offset, startBoundingBoxY, step, width;
 	
 	area = ((boundingBox.br().x - boundingBox.tl().x) * (boundingBox.br().y - boundingBox.tl().y)) / split;
 	counter = 0;
@@ -25,6 +27,10 @@ vector<Rect> ObservationManager::filterBoundingBoxHorizontal(Mat& image, const R
 	
 	startBoundingBoxY = boundingBox.tl().y;
 	
+	/// White pixels of every row of the blob within the columns of the bounding box.
+	blob.rowHistogramInColumns(minX,maxX,whiteRows);
+	offset = blob.boundingBox.y;
+	
 	while (i < split)
 	{
 		int minY, maxY;
@@ -32,15 +38,7 @@ vector<Rect> ObservationManager::filterBoundingBoxHorizontal(Mat& image, const R
 		minY = boundingBox.tl().y + (i * step);
 		maxY = minY + step;
 		
-		counter = 0;
-		
-		for (int j = minY; j < maxY; ++j)
-		{
-			for (int k = minX; k < maxX; ++k)
-			{
-				if ((uchar) image.at<uchar>(j,k) == 255) ++counter;
-			}
-		}
+		counter = accumulate(whiteRows.begin() + (minY - offset),whiteRows.begin() + (maxY - offset),0);
 		
 		if ((counter / (float) area) < whitePercentage)
 		{
@@ -78,13 +76,7 @@ vector<Rect> ObservationManager::filterBoundingBoxHorizontal(Mat& image, const R
 	
 	for (vector<Rect>::iterator it = boundingBoxes.begin(); it != boundingBoxes.end(); )
 	{
-		for (int i = it->y; i < (it->y + it->height); ++i)
-		{
-			for (int j = it->x; j < (it->x + it->width); ++j)
-			{
-				if ((uchar) image.at<uchar>(i,j) == 255) ++counter;
-			}
-		}
+		counter = accumulate(whiteRows.begin() + (it->y - offset),whiteRows.begin() + (it->y + it->height - offset),0);
 		
 		if ((counter / ((float) (it->width * it->height))) > 0.4) ++it;
 		else it = boundingBoxes.erase(it);
@@ -93,10 +85,12 @@ vector<Rect> ObservationManager::filterBoundingBoxHorizontal(Mat& image, const R
 	return boundingBoxes;
 }
 
-vector<Rect> ObservationManager::filterBoundingBoxVertical(Mat& image, Rect& boundingBox, int split, float whitePercentage)
+vector<Rect> ObservationManager::filterBoundingBoxVertical(const Blob& blob, int split, float whitePercentage)
 {
+	const Rect& boundingBox = blob.boundingBox;
+	const vector<int>& whiteColumns = blob.columnHistogram;
 	vector<Rect> boundingBoxes;
-	int area, counter, height, i, minY, maxY, startBoundingBoxX, step, width;
+	int area, counter, height, i, minY, maxY, offset, startBoundingBoxX, step, width;
 	
 	area = ((boundingBox.br().x - boundingBox.tl().x) * (boundingBox.br().y - boundingBox.tl().y)) / split;
 	counter = 0;
@@ -106,6 +100,7 @@ vector<Rect> ObservationManager::filterBoundingBoxVertical(Mat& image, Rect& bou
 	width = boundingBox.br().x - boundingBox.tl().x;
 	height = boundingBox.br().y - boundingBox.tl().y;
 	step = width / split;
+	offset = boundingBox.x;
 	
 	startBoundingBoxX = boundingBox.tl().x;
 	
@@ -116,15 +111,7 @@ vector<Rect> ObservationManager::filterBoundingBoxVertical(Mat& image, Rect& bou
 		minX = boundingBox.tl().x + (i * step);
 		maxX = minX + step;
 		
-		counter = 0;
-		
-		for (int j = minY; j < maxY; ++j)
-		{
-			for (int k = minX; k < maxX; ++k)
-			{
-				if ((uchar) image.at<uchar>(j,k) == 255) ++counter;
-			}
-		}
+		counter = accumulate(whiteColumns.begin() + (minX - offset),whiteColumns.begin() + (maxX - offset),0);
 		
 		if ((counter / (float) area) < whitePercentage)
 		{
@@ -162,13 +149,7 @@ vector<Rect> ObservationManager::filterBoundingBoxVertical(Mat& image, Rect& bou
 	
 	for (vector<Rect>::iterator it = boundingBoxes.begin(); it != boundingBoxes.end(); )
 	{
-		for (int i = it->y; i < (it->y + it->height); ++i)
-		{
-			for (int j = it->x; j < (it->x + it->width); ++j)
-			{
-				if ((uchar) image.at<uchar>(i,j) == 255) ++counter;
-			}
-		}
+		counter = accumulate(whiteColumns.begin() + (it->x - offset),whiteColumns.begin() + (it->x + it->width - offset),0);
 		
 		if ((counter / ((float) (it->width * it->height))) > 0.4) ++it;
 		else it = boundingBoxes.erase(it);
@@ -180,18 +161,9 @@ vector<Rect> ObservationManager::filterBoundingBoxVertical(Mat& image, Rect& bou
 ObjectSensorReading ObservationManager::process(Mat frame, Mat fgMask, bool visualTracker)
 {
 	// Filtering out shadows.
-	Mat tmpBinaryImage = fgMask.clone();
+	Mat binaryImage;
 	
-	for (int i = 0; i < tmpBinaryImage.rows; ++i)
-	{
-		for (int j = 0; j < tmpBinaryImage.cols; ++j)
-		{
-			if (tmpBinaryImage.at<uchar>(i,j) <= 80)
-			{
-				tmpBinaryImage.at<uchar>(i,j) = 0;
-			}
-		}
-	}
+	threshold(fgMask,binaryImage,80,255,THRESH_BINARY);
 	
 	ObjectSensorReading visualReading;
 	vector<Rect> boundingBoxes;
@@ -212,207 +184,116 @@ ObjectSensorReading ObservationManager::process(Mat frame, Mat fgMask, bool visu
 	int minArea = 0;
 	int maxArea = 5000;
 	
-	vector < vector<Point> > contours;
-	
 	Mat element3(3,3,CV_8U,Scalar(1));
-	//morphologyEx(tmpBinaryImage,tmpBinaryImage,MORPH_OPEN,element3);
-	morphologyEx(tmpBinaryImage,tmpBinaryImage,MORPH_CLOSE,element3);
+	//morphologyEx(binaryImage,binaryImage,MORPH_OPEN,element3);
+	morphologyEx(binaryImage,binaryImage,MORPH_CLOSE,element3);
 	
-    findContours(tmpBinaryImage,contours,CV_RETR_LIST,CV_CHAIN_APPROX_NONE);
-	vector<vector<Point> > contoursPoly(contours.size());
-	vector<Rect> boundRect(contours.size());
+	/// Area, bounding box and white pixel histograms of every blob, computed in a single scan of the mask.
+	const vector<Blob>& blobs = blobExtractor.extract(binaryImage,minArea,maxArea);
 	
-	tmpBinaryImage = Scalar(0);
+	Mat tmpBinaryImage = Mat::zeros(binaryImage.size(),CV_8UC1);
+	Rect boundingBox;
+	
+	/// The appearance of every observation is taken from a single HSV conversion of the frame.
+	Mat hsvFrame;
+	
+	if (!blobs.empty()) cvtColor(frame,hsvFrame,CV_BGR2HSV);
 	
 	vector<ObjectSensorReading::Observation> obs;
 	
-	for (size_t contourIdx = 0; contourIdx < contours.size(); ++contourIdx)
-    {
-		Moments moms = moments(Mat(contours[contourIdx]));
-		double area = moms.m00;
+	for (vector<Blob>::const_iterator blob = blobs.begin(); blob != blobs.end(); ++blob)
+	{
+		BlobExtractor::draw(tmpBinaryImage,*blob,255);
 		
-        if ((area < minArea) || (area >= maxArea)) continue;
-		else
+		const vector<Rect>& boundingBoxesVertical = filterBoundingBoxVertical(*blob,8,0.2);
+		
+		/// Histograms of the bounding boxes of the blob (full-height column strips) are read from its column-wise integral histogram.
+		if (!boundingBoxesVertical.empty()) integralHistogram.compute(hsvFrame,blob->boundingBox);
+		
+		/// Enabling for TUD-Campus.
+		/*for (vector<Rect>::const_iterator it = boundingBoxesVertical.begin(); it != boundingBoxesVertical.end(); ++it)
 		{
-			approxPolyDP(Mat(contours[contourIdx]),contoursPoly[contourIdx],3,true);
-			boundRect[contourIdx] = boundingRect(Mat(contoursPoly[contourIdx]));
-			drawContours(tmpBinaryImage,contours,contourIdx,Scalar(255),CV_FILLED);
+			const vector<Rect>& boundingBoxesHorizontal = filterBoundingBoxHorizontal(*blob,*it,8,0.1);
 			
-			const vector<Rect>& boundingBoxesVertical = filterBoundingBoxVertical(tmpBinaryImage,boundRect[contourIdx],8,0.2);
-			
-			/// Enabling for TUD-Campus.
-			/*for (vector<Rect>::const_iterator it = boundingBoxesVertical.begin(); it != boundingBoxesVertical.end(); ++it)
+			for (vector<Rect>::const_iterator it2 = boundingBoxesHorizontal.begin(); it2 != boundingBoxesHorizontal.end(); ++it2)
 			{
-				const vector<Rect>& boundingBoxesHorizontal = filterBoundingBoxHorizontal(tmpBinaryImage,*it,8,0.1);
-				
-				for (vector<Rect>::const_iterator it2 = boundingBoxesHorizontal.begin(); it2 != boundingBoxesHorizontal.end(); ++it2)
-				{
-					boundingBoxes.push_back(*it2);
-				}
-			}*/
+				boundingBoxes.push_back(*it2);
+			}
+		}*/
+		
+		for (vector<Rect>::const_iterator it = boundingBoxesVertical.begin(); it != boundingBoxesVertical.end(); ++it)
+		{
+			ObjectSensorReading::Observation observation;
+			
+			boundingBox = *it;
+			
+			const Mat& roi = frame(boundingBox);
+			
+			integralHistogram.getHistograms(boundingBox,observation.model);
+			
+			double imageX, imageHeadX, imageY, imageHeadY;
+			float barycenter, barycenterHead;
+			int offset;
+			
+			/// Columns of the bounding box within the histograms of the blob.
+			offset = boundingBox.tl().x - blob->boundingBox.tl().x;
+			
+			/// Calculating center of the feet.
+			if (!Blob::barycenter(blob->feetHistogram,offset,offset + roi.cols,barycenter)) continue;
+			
+			if (barycenter == 0.0) continue;
+			
+			barycenter += boundingBox.tl().x;
 			
-			for (vector<Rect>::const_iterator it = boundingBoxesVertical.begin(); it != boundingBoxesVertical.end(); ++it)
+			imageX = barycenter;
+			imageY = (int) boundingBox.br().y;
+			
+			circle(tmpBinaryImage,Point(imageX,imageY),6,cvScalar(180),2);
+			
+			/// Calculating center of the head.
+			if (!Blob::barycenter(blob->headHistogram,offset,offset + roi.cols,barycenterHead)) continue;
+			
+			if (barycenterHead == 0.0) continue;
+			
+			barycenterHead += boundingBox.tl().x;
+			
+			imageHeadX = barycenterHead;
+			imageHeadY = (int) boundingBox.tl().y + (((int) boundingBox.br().y - (int) boundingBox.tl().y) / 2);
+			
+			circle(tmpBinaryImage,Point(imageHeadX,imageHeadY),6,cvScalar(0),2);
+			
+			double imageXGoogle, imageHeadXGoogle, imageYGoogle, imageHeadYGoogle;
+			
+			if (visualTracker)
 			{
-				ObjectSensorReading::Observation observation;
-				int counter;
-				uchar hue, saturation, value;
-				
-				boundRect[contourIdx] = *it;
-				counter = 0;
-				
-				const Mat& roi = frame(boundRect[contourIdx]);
-				
-				Mat hsvRoi;
-				
-				cvtColor(roi,hsvRoi,CV_BGR2HSV);
-				
-				for (int y = 0; y < hsvRoi.rows; ++y)
-				{
-					for (int x = 0; x < hsvRoi.cols; ++x)
-					{
-						hue = (uchar) hsvRoi.data[y * hsvRoi.step + x];
-						saturation = (uchar) hsvRoi.data[y * hsvRoi.step + x + 1];
-						value = (uchar) hsvRoi.data[y * hsvRoi.step + x + 2];
-						
-						observation.model.histograms[0][hue]++;
-						observation.model.histograms[1][saturation]++;
-						observation.model.histograms[2][value]++;
-						
-						++counter;
-					}
-				}
-				
-				for (int i = 0; i < ObjectSensorReading::Model::HISTOGRAM_VECTOR_LENGTH; ++i)
-				{
-					observation.model.histograms[0][i] /= counter;
-					observation.model.histograms[1][i] /= counter;
-					observation.model.histograms[2][i] /= counter;
-				}
-				
-				double imageX, imageHeadX, imageY, imageHeadY;
-				float barycenter, barycenterHead;
-				int whiteBins[roi.cols];
-				int endX, endY, index, whiteCounter;
-				
-				endX = boundRect[contourIdx].tl().x + roi.cols;
-				endY = boundRect[contourIdx].tl().y + roi.rows;
-				
-				for (int i = 0; i < roi.cols; ++i)
-				{
-					whiteBins[i] = 0;
-				}
-				
-				index = 0;
-				whiteCounter = 0;
-				
-				/// Calculating center of the feet.
-				for (int x = boundRect[contourIdx].tl().x; x < endX; ++x, ++index)
-				{
-					for (int y = (boundRect[contourIdx].tl().y + (roi.rows * 0.8)); y < endY; ++y)
-					{
-						if (((int) tmpBinaryImage.at<uchar>(y,x)) == 255)
-						{
-							whiteBins[index] += 1;
-							++whiteCounter;
-						}
-					}
-				}
-				
-				if (whiteCounter == 0) continue;
-				
-				barycenter = 0.0;
-				
-				for (int i = 0; i < roi.cols; ++i)
-				{
-					barycenter += (whiteBins[i] * i);
-				}
-				
-				barycenter /= whiteCounter;
+				imageXGoogle = imageX;
+				imageYGoogle = imageY;
 				
-				if (barycenter == 0.0) continue;
+				imageHeadXGoogle = imageHeadX;
+				imageHeadYGoogle = imageHeadY;
 				
-				barycenter += boundRect[contourIdx].tl().x;
-				
-				imageX = barycenter;
-				imageY = (int) boundRect[contourIdx].br().y;
-				
-				circle(tmpBinaryImage,Point(imageX,imageY),6,cvScalar(180),2);
-				
-				for (int i = 0; i < roi.cols; ++i)
-				{
-					whiteBins[i] = 0;
-				}
-				
-				index = 0;
-				whiteCounter = 0;
-				
-				/// Calculating center of the head.
-				for (int x = boundRect[contourIdx].tl().x; x < endX; ++x, ++index)
-				{
-					for (int y = boundRect[contourIdx].tl().y; y < (endY - (roi.rows * 0.8)); ++y)
-					{
-						if (((int) tmpBinaryImage.at<uchar>(y,x)) == 255)
-						{
-							whiteBins[index] += 1;
-							++whiteCounter;
-						}
-					}
-				}
-				
-				if (whiteCounter == 0) continue;
-				
-				barycenterHead = 0.0;
-				
-				for (int i = 0; i < roi.cols; ++i)
-				{
-					barycenterHead += (whiteBins[i] * i);
-				}
-				
-				barycenterHead /= whiteCounter;
-				
-				if (barycenterHead == 0.0) continue;
-				
-				barycenterHead += boundRect[contourIdx].tl().x;
-				
-				imageHeadX = barycenterHead;
-				imageHeadY = (int) boundRect[contourIdx].tl().y + (((int) boundRect[contourIdx].br().y - (int) boundRect[contourIdx].tl().y) / 2);
-				
-				circle(tmpBinaryImage,Point(imageHeadX,imageHeadY),6,cvScalar(0),2);
-				
-				double imageXGoogle, imageHeadXGoogle, imageYGoogle, imageHeadYGoogle;
-				
-				if (visualTracker)
-				{
-					imageXGoogle = imageX;
-					imageYGoogle = imageY;
-					
-					imageHeadXGoogle = imageHeadX;
-					imageHeadYGoogle = imageHeadY;
-					
-					resolution = 1;
-				}
-				else
-				{
-					imageXGoogle = (H.at<double>(0,0) * imageX + H.at<double>(0,1) * imageY + H.at<double>(0,2)) / (H.at<double>(2,0) * imageX + H.at<double>(2,1) * imageY + H.at<double>(2,2));
-					imageYGoogle = (H.at<double>(1,0) * imageX + H.at<double>(1,1) * imageY + H.at<double>(1,2)) / (H.at<double>(2,0) * imageX + H.at<double>(2,1) * imageY + H.at<double>(2,2));
-					
-					imageHeadXGoogle = (H.at<double>(0,0) * imageHeadX + H.at<double>(0,1) * imageHeadY + H.at<double>(0,2)) / (H.at<double>(2,0) * imageHeadX + H.at<double>(2,1) * imageHeadY + H.at<double>(2,2));
-					imageHeadYGoogle = (H.at<double>(1,0) * imageHeadX + H.at<double>(1,1) * imageHeadY + H.at<double>(1,2)) / (H.at<double>(2,0) * imageHeadX + H.at<double>(2,1) * imageHeadY + H.at<double>(2,2));
-				}
-				
-				rectangle(tmpBinaryImage,boundRect[contourIdx].tl(),boundRect[contourIdx].br(),CV_RGB(190,190,190),1,8,0);
-				
-				observation.observation.rho = sqrt(pow(imageXGoogle * resolution,2) + pow(imageYGoogle * resolution,2));
-				observation.observation.theta = atan2(imageYGoogle * resolution,imageXGoogle * resolution);
-				observation.head.x = imageHeadXGoogle * resolution;
-				observation.head.y = imageHeadYGoogle * resolution;
-				observation.model.barycenter = barycenter;
-				observation.model.boundingBox = make_pair(PTracking::Point2f(boundRect[contourIdx].tl().x - barycenter,-roi.rows),PTracking::Point2f(roi.cols + boundRect[contourIdx].tl().x - barycenter,0));
-				observation.model.height = (int) boundRect[contourIdx].br().y - (int) boundRect[contourIdx].tl().y;
-				observation.model.width = (int) boundRect[contourIdx].br().x - (int) boundRect[contourIdx].tl().x;
+				resolution = 1;
+			}
+			else
+			{
+				imageXGoogle = (H.at<double>(0,0) * imageX + H.at<double>(0,1) * imageY + H.at<double>(0,2)) / (H.at<double>(2,0) * imageX + H.at<double>(2,1) * imageY + H.at<double>(2,2));
+				imageYGoogle = (H.at<double>(1,0) * imageX + H.at<double>(1,1) * imageY + H.at<double>(1,2)) / (H.at<double>(2,0) * imageX + H.at<double>(2,1) * imageY + H.at<double>(2,2));
 				
-				obs.push_back(observation);
+				imageHeadXGoogle = (H.at<double>(0,0) * imageHeadX + H.at<double>(0,1) * imageHeadY + H.at<double>(0,2)) / (H.at<double>(2,0) * imageHeadX + H.at<double>(2,1) * imageHeadY + H.at<double>(2,2));
+				imageHeadYGoogle = (H.at<double>(1,0) * imageHeadX + H.at<double>(1,1) * imageHeadY + H.at<double>(1,2)) / (H.at<double>(2,0) * imageHeadX + H.at<double>(2,1) * imageHeadY + H.at<double>(2,2));
 			}
+			
+			rectangle(tmpBinaryImage,boundingBox.tl(),boundingBox.br(),CV_RGB(190,190,190),1,8,0);
+			
+			observation.observation.setCartesian(PTracking::Point2f(imageXGoogle * resolution,imageYGoogle * resolution));
+			observation.head.x = imageHeadXGoogle * resolution;
+			observation.head.y = imageHeadYGoogle * resolution;
+			observation.model.barycenter = barycenter;
+			observation.model.boundingBox = make_pair(PTracking::Point2f(boundingBox.tl().x - barycenter,-roi.rows),PTracking::Point2f(roi.cols + boundingBox.tl().x - barycenter,0));
+			observation.model.height = (int) boundingBox.br().y - (int) boundingBox.tl().y;
+			observation.model.width = (int) boundingBox.br().x - (int) boundingBox.tl().x;
+			
+			obs.push_back(observation);
 		}
 	}
 	
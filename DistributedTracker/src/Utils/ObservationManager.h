@@ -4,6 +4,8 @@
 #include <CameraModel/cameraModel.h>
 #include <CameraModel/xmlUtil.h>
 #include <Core/Filters/ObjectSensorReading.h>
+#include "BlobExtractor.h"
+#include "IntegralHistogram.h"
 
 class ObservationManager
 {
@@ -11,9 +13,11 @@ class ObservationManager
 		Etiseo::CameraModel* cameraModel;
 		cv::Mat H;
 		double resolution;
+		BlobExtractor blobExtractor;
+		IntegralHistogram integralHistogram;
 		
-		std::vector<cv::Rect> filterBoundingBoxHorizontal(cv::Mat&,const cv::Rect&,int,float);
-		std::vector<cv::Rect> filterBoundingBoxVertical(cv::Mat&,cv::Rect&,int,float);
+		std::vector<cv::Rect> filterBoundingBoxHorizontal(const Blob&,const cv::Rect&,int,float);
+		std::vector<cv::Rect> filterBoundingBoxVertical(const Blob&,int,float);
 		
 	public:
 		ObservationManager(Etiseo::CameraModel*,const cv::Mat&,double);
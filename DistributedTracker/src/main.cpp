@@ -69,6 +69,8 @@ Mat Pinv(4,4,DataType<double>::type);
 Mat Kinect2World(4,4,DataType<double>::type);
 double fps, resolution;
 int agentId = -100, keyboard;
+unsigned int imbsThreads = 1;
+bool imbsIncrementalUpdate = false;
 bool slow;
 bool opticalTracker;
 
@@ -127,6 +129,12 @@ void configure(const string& filename, const string& homography, const string& d
 		key = "opticalTracker";
 		
 		opticalTracker = fCfg.value(section,key);
+		
+		key = "imbsThreads";
+		imbsThreads = (int) fCfg.value(section,key,1);
+		
+		key = "imbsIncrementalUpdate";
+		imbsIncrementalUpdate = fCfg.value(section,key,false);
 	}
 	catch (...)
 	{
@@ -262,6 +270,8 @@ void processVideo(char* videoFilename, const string& dataset, ObservationManager
 	fps = capture.get(5);
 	
 	pIMBS = new BackgroundSubtractorIMBS(fps);
+	pIMBS->setNumThreads(imbsThreads);
+	pIMBS->setIncrementalUpdate(imbsIncrementalUpdate);
 	
 	if (load_bg)
 	{
@@ -466,6 +476,8 @@ void processImages(char* firstFrameFilename, const string& dataset, ObservationM
 	BackgroundSubtractorIMBS* pIMBS;
 	
 	pIMBS = new BackgroundSubtractorIMBS(fps);
+	pIMBS->setNumThreads(imbsThreads);
+	pIMBS->setIncrementalUpdate(imbsIncrementalUpdate);
 	
 	if (load_bg)
 	{
@@ -1300,6 +1312,8 @@ int main(int argc, char* argv[])
 		BackgroundSubtractorIMBS* pIMBS;
 		
 		pIMBS = new BackgroundSubtractorIMBS(fps);
+		pIMBS->setNumThreads(imbsThreads);
+		pIMBS->setIncrementalUpdate(imbsIncrementalUpdate);
 		
 		ObservationManager* observationManager = new ObservationManager(0,H,resolution);
 		
@@ -0,0 +1,61 @@
+#include "Clusterizer.h"
+#include <Utils/Utils.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace PTracking
+{
+	void Clusterizer::clusterize(PoseParticleVector& particleVector, float qualityThreshold)
+	{
+		const int size = particleVector.size();
+		int clusterNumber, unclustered;
+		
+		labels.assign(size,-1);
+		
+		clusterNumber = assignClusters(particleVector,qualityThreshold);
+		
+		/// Counting sort of the particles by cluster, the unclustered ones go after the last cluster.
+		offsets.assign(clusterNumber + 1,0);
+		
+		for (int i = 0; i < size; ++i)
+		{
+			if (labels[i] >= 0) ++offsets[labels[i] + 1];
+		}
+		
+		for (int i = 0; i < clusterNumber; ++i) offsets[i + 1] += offsets[i];
+		
+		clusters.resize(clusterNumber);
+		
+		for (int i = 0; i < clusterNumber; ++i)
+		{
+			clusters[i].begin = offsets[i];
+			clusters[i].end = offsets[i + 1];
+		}
+		
+		unclustered = offsets[clusterNumber];
+		destinations.resize(size);
+		
+		for (int i = 0; i < size; ++i)
+		{
+			destinations[i] = (labels[i] >= 0) ? offsets[labels[i]]++ : unclustered++;
+		}
+		
+		/// Applying the permutation one cycle at a time, every swap puts a particle in its final position.
+		for (int i = 0; i < size; ++i)
+		{
+			while (destinations[i] != i)
+			{
+				const int destination = destinations[i];
+				
+				swap(particleVector[i],particleVector[destination]);
+				swap(destinations[i],destinations[destination]);
+			}
+		}
+		
+		for (vector<ClusterRange>::iterator it = clusters.begin(); it != clusters.end(); ++it)
+		{
+			it->centroid = Utils::calculateCentroid(particleVector,it->begin,it->end);
+		}
+	}
+}
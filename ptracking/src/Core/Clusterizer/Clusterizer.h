@@ -6,6 +6,36 @@
 
 namespace PTracking
 {
+	/**
+	 * @struct ClusterRange
+	 * 
+	 * @brief Struct that represents a cluster as a range of contiguous particles of the clusterized vector.
+	 */
+	struct ClusterRange
+	{
+		/**
+		 * @brief index of the first particle of the cluster.
+		 */
+		int begin;
+		
+		/**
+		 * @brief index past the last particle of the cluster.
+		 */
+		int end;
+		
+		/**
+		 * @brief centroid of the cluster.
+		 */
+		Point2of centroid;
+		
+		/**
+		 * @brief Function that returns the number of particles of the cluster.
+		 * 
+		 * @return the number of particles of the cluster.
+		 */
+		inline int size() const { return end - begin; }
+	};
+	
 	/**
 	 * @class Clusterizer
 	 * 
@@ -13,11 +43,37 @@ namespace PTracking
 	 */
 	class Clusterizer
 	{
+		private:
+			/**
+			 * @brief vector representing the range and the centroid of each cluster.
+			 */
+			std::vector<ClusterRange> clusters;
+			
+			/**
+			 * @brief position of every particle once the vector is sorted by cluster.
+			 */
+			std::vector<int> destinations;
+			
+			/**
+			 * @brief first free position of every cluster while sorting the vector.
+			 */
+			std::vector<int> offsets;
+			
 		protected:
 			/**
-			 * @brief vector representing the particles and the centroid of each cluster.
+			 * @brief cluster of every particle, -1 for the particles that do not belong to any cluster.
 			 */
-			std::vector<std::pair<PoseParticleVector,Point2of> > clusters;
+			std::vector<int> labels;
+			
+			/**
+			 * @brief Pure virtual function that assigns the particles to the clusters, filling \a labels.
+			 * 
+			 * @param particleVector reference to the particles' vector that have to be clusterized.
+			 * @param qualityThreshold maximum radius of a cluster.
+			 * 
+			 * @return the number of clusters, numbered from 0 in the order they have to be returned.
+			 */
+			virtual int assignClusters(const PoseParticleVector& particleVector, float qualityThreshold) = 0;
 			
 		public:
 			/**
@@ -26,19 +82,24 @@ namespace PTracking
 			virtual ~Clusterizer() {;}
 			
 			/**
-			 * @brief Pure virtual function that clusterizes a vector of particles creating a set of clusters with a maximum radius given in input.
+			 * @brief Function that clusterizes a vector of particles creating a set of clusters with a maximum radius given in input.
+			 * 
+			 * The vector is permuted in place so that the particles of every cluster are contiguous, in the order of the clusters, followed by the particles
+			 * that do not belong to any cluster. The relative order of the particles inside a cluster is preserved.
 			 * 
 			 * @param particleVector reference to the particles' vector that have to be clusterized.
 			 * @param qualityThreshold maximum radius of a cluster.
 			 */
-			virtual void clusterize(const PoseParticleVector& particleVector, float qualityThreshold) = 0;
+			void clusterize(PoseParticleVector& particleVector, float qualityThreshold);
 			
 			/**
 			 * @brief Function that returns the vector of clusters.
 			 * 
-			 * @return the vector of clusters created.
+			 * The ranges refer to the vector given to the last call of clusterize() and are valid until it is reordered.
+			 * 
+			 * @return a constant reference to the vector of clusters created.
 			 */
-			inline std::vector<std::pair<PoseParticleVector,Point2of> > getClusters() const { return clusters; }
+			inline const std::vector<ClusterRange>& getClusters() const { return clusters; }
 			
 			/**
 			 * @brief Function that, if redefined, returns the number of clusters \a k used by the clustering algorithm to clusterize the particles.
@@ -0,0 +1,166 @@
+#include "GridClusterizer.h"
+#include <algorithm>
+#include <math.h>
+#include <queue>
+
+using namespace std;
+
+namespace PTracking
+{
+	namespace
+	{
+		/**
+		 * @brief Functor ordering the particles by cell (row-major) and then by index.
+		 */
+		struct CellOrder
+		{
+			const vector<int>& cellX;
+			const vector<int>& cellY;
+			
+			CellOrder(const vector<int>& cellX, const vector<int>& cellY) : cellX(cellX), cellY(cellY) {;}
+			
+			bool operator() (int i, int j) const
+			{
+				if (cellY[i] != cellY[j]) return cellY[i] < cellY[j];
+				if (cellX[i] != cellX[j]) return cellX[i] < cellX[j];
+				
+				return i < j;
+			}
+		};
+		
+		int cellCoordinate(float value, float cellSize)
+		{
+			const double cell = floor(value / cellSize);
+			
+			return (int) max(min(cell,(double) (1 << 30)),(double) -(1 << 30));
+		}
+	}
+	
+	GridClusterizer::GridClusterizer() : particles(0), qualityThreshold(0.0) {;}
+	
+	GridClusterizer::~GridClusterizer() {;}
+	
+	int GridClusterizer::assignClusters(const PoseParticleVector& particleVector, float qualityThreshold)
+	{
+		const int size = particleVector.size();
+		vector<int> neighbours, removedNeighbours;
+		int clusterNumber = 0;
+		
+		particles = &particleVector;
+		this->qualityThreshold = qualityThreshold;
+		
+		/// Particles are close when their squared distance is below the threshold, hence cells as large as its square root.
+		const float cellSize = (qualityThreshold > 0.0) ? sqrt(qualityThreshold) : 1.0;
+		
+		cellX.resize(size);
+		cellY.resize(size);
+		particlesByCell.resize(size);
+		
+		for (int i = 0; i < size; ++i)
+		{
+			cellX[i] = cellCoordinate(particleVector[i].pose.pose.x,cellSize);
+			cellY[i] = cellCoordinate(particleVector[i].pose.pose.y,cellSize);
+			particlesByCell[i] = i;
+		}
+		
+		sort(particlesByCell.begin(),particlesByCell.end(),CellOrder(cellX,cellY));
+		
+		clustered.assign(size,false);
+		neighbourCounters.resize(size);
+		
+		/// Size of the candidate cluster of every particle, the biggest one is chosen with the smallest index on ties as QTClusterizer does.
+		priority_queue<pair<int,int> > candidates;
+		
+		for (int i = 0; i < size; ++i)
+		{
+			findNeighbours(i,neighbours);
+			
+			neighbourCounters[i] = neighbours.size();
+			candidates.push(make_pair(neighbourCounters[i],-i));
+		}
+		
+		while (!candidates.empty())
+		{
+			const int count = candidates.top().first, index = -candidates.top().second;
+			
+			candidates.pop();
+			
+			/// Outdated entry.
+			if (clustered[index] || (count != neighbourCounters[index])) continue;
+			
+			findNeighbours(index,neighbours);
+			
+			for (vector<int>::const_iterator it = neighbours.begin(); it != neighbours.end(); ++it)
+			{
+				clustered[*it] = true;
+				labels[*it] = clusterNumber;
+			}
+			
+			++clusterNumber;
+			
+			/// The remaining particles close to the clustered ones lose them from their candidate cluster.
+			for (vector<int>::const_iterator it = neighbours.begin(); it != neighbours.end(); ++it)
+			{
+				findNeighbours(*it,removedNeighbours);
+				
+				for (vector<int>::const_iterator it2 = removedNeighbours.begin(); it2 != removedNeighbours.end(); ++it2)
+				{
+					if (*it2 == *it) continue;
+					
+					--neighbourCounters[*it2];
+					candidates.push(make_pair(neighbourCounters[*it2],-*it2));
+				}
+			}
+		}
+		
+		particles = 0;
+		
+		return clusterNumber;
+	}
+	
+	void GridClusterizer::findNeighbours(int index, vector<int>& neighbours) const
+	{
+		const PoseParticle& particle = (*particles)[index];
+		
+		neighbours.clear();
+		
+		for (int y = cellY[index] - 1; y <= cellY[index] + 1; ++y)
+		{
+			/// The three cells of a row are contiguous in particlesByCell.
+			const int end = lowerBound(cellX[index] + 2,y);
+			
+			for (int i = lowerBound(cellX[index] - 1,y); i < end; ++i)
+			{
+				const int candidate = particlesByCell[i];
+				
+				if (clustered[candidate] && (candidate != index)) continue;
+				
+				const float dx = particle.pose.pose.x - (*particles)[candidate].pose.pose.x, dy = particle.pose.pose.y - (*particles)[candidate].pose.pose.y;
+				
+				if ((candidate == index) || (((dx * dx) + (dy * dy)) < qualityThreshold)) neighbours.push_back(candidate);
+			}
+		}
+		
+		/// Same order of the particles in the cluster as QTClusterizer.
+		sort(neighbours.begin(),neighbours.end());
+	}
+	
+	int GridClusterizer::lowerBound(int x, int y) const
+	{
+		int first = 0, count = particlesByCell.size();
+		
+		while (count > 0)
+		{
+			const int step = count / 2, particle = particlesByCell[first + step];
+			
+			if ((cellY[particle] < y) || ((cellY[particle] == y) && (cellX[particle] < x)))
+			{
+				first += step + 1;
+				count -= step + 1;
+			}
+			else count = step;
+		}
+		
+		return first;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../Clusterizer.h"
+
+namespace PTracking
+{
+	/**
+	 * @class GridClusterizer
+	 * 
+	 * @brief Class that implements the QT-Clustering algorithm on a grid of cells as large as the cluster radius.
+	 * 
+	 * It produces the same clusters as QTClusterizer, but the neighbours of a particle are looked for only in the 3x3 cells around it and the size of every candidate
+	 * cluster is updated incrementally when the particles of a cluster are removed, instead of rebuilding all the candidate clusters at every step.
+	 */
+	class GridClusterizer : public Clusterizer
+	{
+		private:
+			/**
+			 * @brief cell of every particle.
+			 */
+			std::vector<int> cellX, cellY;
+			
+			/**
+			 * @brief number of not yet clustered particles close to every particle (including itself).
+			 */
+			std::vector<int> neighbourCounters;
+			
+			/**
+			 * @brief indexes of the particles sorted by cell (row-major).
+			 */
+			std::vector<int> particlesByCell;
+			
+			/**
+			 * @brief true for the particles already assigned to a cluster.
+			 */
+			std::vector<bool> clustered;
+			
+			/**
+			 * @brief pointer to the particles being clusterized.
+			 */
+			const PoseParticleVector* particles;
+			
+			/**
+			 * @brief maximum squared distance between two particles of a cluster.
+			 */
+			float qualityThreshold;
+			
+			/**
+			 * @brief Function that finds the position in particlesByCell of the first particle whose cell is not before a given one.
+			 * 
+			 * @param x column of the cell.
+			 * @param y row of the cell.
+			 * 
+			 * @return the position found.
+			 */
+			int lowerBound(int x, int y) const;
+			
+			/**
+			 * @brief Function that finds the not yet clustered particles close to a given one.
+			 * 
+			 * @param index index of the particle.
+			 * @param neighbours reference to the vector where the indexes of the neighbours (including the particle itself) are stored.
+			 */
+			void findNeighbours(int index, std::vector<int>& neighbours) const;
+			
+		protected:
+			/**
+			 * @brief Function that assigns the particles to the clusters, finding at every step the biggest cluster with a maximum radius given in input.
+			 * 
+			 * @param particleVector reference to the particles' vector that have to be clusterized.
+			 * @param qualityThreshold maximum radius of a cluster (compared with squared distances, as QTClusterizer does).
+			 * 
+			 * @return the number of clusters.
+			 */
+			int assignClusters(const PoseParticleVector& particleVector, float qualityThreshold);
+			
+		public:
+			/**
+			 * @brief Empty constructor.
+			 */
+			GridClusterizer();
+			
+			/**
+			 * @brief Destructor.
+			 */
+			~GridClusterizer();
+	};
+}
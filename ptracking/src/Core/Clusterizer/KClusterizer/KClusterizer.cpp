@@ -1,27 +1,75 @@
 #include "KClusterizer.h"
 #include <Utils/Utils.h>
+#include <algorithm>
 #include <float.h>
 
 using namespace std;
 
 namespace PTracking
 {
+	namespace
+	{
+		/**
+		 * @brief Functor ordering the indexes of a vector of particles by x and then by y.
+		 */
+		struct XOrder
+		{
+			const PoseParticleVector& particles;
+			
+			XOrder(const PoseParticleVector& particles) : particles(particles) {;}
+			
+			bool operator() (int i, int j) const
+			{
+				if (particles[i].pose.pose.x != particles[j].pose.pose.x) return particles[i].pose.pose.x < particles[j].pose.pose.x;
+				
+				return particles[i].pose.pose.y < particles[j].pose.pose.y;
+			}
+		};
+		
+		/// Twice the signed area of the triangle (a,b,c), positive if counterclockwise.
+		inline float cross(const PoseParticle& a, const PoseParticle& b, const PoseParticle& c)
+		{
+			return ((b.pose.pose.x - a.pose.pose.x) * (c.pose.pose.y - a.pose.pose.y)) - ((b.pose.pose.y - a.pose.pose.y) * (c.pose.pose.x - a.pose.pose.x));
+		}
+		
+		inline float squaredDistance(const PoseParticle& a, const PoseParticle& b)
+		{
+			return ((a.pose.pose.x - b.pose.pose.x) * (a.pose.pose.x - b.pose.pose.x)) + ((a.pose.pose.y - b.pose.pose.y) * (a.pose.pose.y - b.pose.pose.y));
+		}
+		
+		Point2of calculateCentroid(const PoseParticleVector& particles, const vector<int>& indexes)
+		{
+			Point2of centroid;
+			
+			for (vector<int>::const_iterator it = indexes.begin(); it != indexes.end(); ++it)
+			{
+				centroid.x += particles[*it].pose.pose.x;
+				centroid.y += particles[*it].pose.pose.y;
+			}
+			
+			if (indexes.size() > 0)
+			{
+				centroid.x /= indexes.size();
+				centroid.y /= indexes.size();
+			}
+			
+			return centroid;
+		}
+	}
+	
 	KClusterizer::KClusterizer(int maxClusters) : kpoints(maxClusters), maxClusters(maxClusters) {;}
 	
 	KClusterizer::~KClusterizer() {;}
 	
-	void KClusterizer::clusterize(const PoseParticleVector& particleVector, float qualityThreshold)
+	int KClusterizer::assignClusters(const PoseParticleVector& particleVector, float qualityThreshold)
 	{
-		multimap<int,PoseParticleVector> outliersMapping;
-		map<float,Cluster> cluster;
-		vector<pair<PoseParticleVector,Point2of> > clustersToBeAdded;
+		vector<Cluster> cluster;
+		vector<vector<int> > clusters, clustersToBeAdded, outliersMapping;
 		vector<Point2of> allCentroids;
-		vector<int> outliers;
-		PoseParticleVector particles;
+		vector<int> outliers, part1, part2;
 		float distance, temp;
-		int closeClusterNumber, clusterIndex, i, j, kint, size;
+		int closeClusterNumber, clusterIndex, i, j, size;
 		
-		clusters.clear();
 		kpoints.reset();
 		
 		for (PoseParticleVector::const_iterator it = particleVector.begin(); it != particleVector.end(); it++)
@@ -29,78 +77,47 @@ namespace PTracking
 			if (isFarFromAll(*it,qualityThreshold)) kpoints.push(*it);
 		}
 		
-		kint = 0;
-		
+		/// One bucket for each k-point, in the order of the priority buffer.
 		for (PriorityBuffer<PoseParticle>::const_iterator cit = kpoints.begin(); cit != kpoints.end(); ++cit)
 		{
-			float index = (cit->second.pose.pose.x * 100000.0) + (cit->second.pose.pose.y * 50000.0) + cit->second.pose.pose.theta;
-			
 			Cluster c;
 			
 			c.k = cit->second;
-			cluster[index] = c;
+			cluster.push_back(c);
 		}
 		
 		i = 0;
 		
 		for (PoseParticleVector::const_iterator it = particleVector.begin(); it != particleVector.end(); ++it, ++i)
 		{
-			int count;
 			bool found;
 			
-			count = 0;
 			found = false;
+			j = 0;
 			
-			for (PriorityBuffer<PoseParticle>::const_iterator pit = kpoints.begin(); (!found) && (pit != kpoints.end()); ++pit)
+			for (PriorityBuffer<PoseParticle>::const_iterator pit = kpoints.begin(); (!found) && (pit != kpoints.end()); ++pit, ++j)
 			{
 				if (!isFarFrom(pit->second,*it,qualityThreshold))
 				{
-					float index = (pit->second.pose.pose.x * 100000.0) + (pit->second.pose.pose.y * 50000.0) + pit->second.pose.pose.theta;
-					
-					cluster[index].indices.push_back(i);
+					cluster[j].indices.push_back(i);
 					found = true;
 				}
-				
-				count++;
 			}
 			
 			if (!found) outliers.push_back(i);
 		}
 		
-		kint = 0;
-		
-		for (map<float,Cluster>::iterator it = cluster.begin(); it != cluster.end(); ++it, ++kint)
+		for (vector<Cluster>::const_iterator it = cluster.begin(); it != cluster.end(); ++it)
 		{
-			float count, cSum, rSum, sSum;
-			
-			rSum = 0.0;
-			cSum = 0.0;
-			sSum = 0.0;
-			count = 0.0;
-			
-			particles.clear();
-			
-			for (vector<int>::const_iterator vit = it->second.indices.begin(); vit != it->second.indices.end(); ++vit, ++count)
+			if (it->indices.size() > 0)
 			{
-				const PoseParticle& p = particleVector[(*vit)];
-				
-				rSum += sqrt((p.pose.pose.x * p.pose.pose.x) + (p.pose.pose.y * p.pose.pose.y));
-				cSum += cos(p.pose.pose.theta);
-				sSum += sin(p.pose.pose.theta);
-				
-				particles.push_back(p);
-			}
-			
-			if (particles.size() > 0)
-			{
-				clusters.push_back(make_pair(particles,Utils::calculateCentroid(particles)));
+				clusters.push_back(it->indices);
+				allCentroids.push_back(calculateCentroid(particleVector,it->indices));
 			}
 		}
 		
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); ++it)
-		{
-			allCentroids.push_back(it->second);
-		}
+		/// The outliers are grouped by their closest centroid.
+		outliersMapping.resize(max(allCentroids.size(),(size_t) 1));
 		
 		i = 0;
 		size = outliers.size();
@@ -126,92 +143,152 @@ namespace PTracking
 				++j;
 			}
 			
-			++i;
-			
-			const multimap<int,PoseParticleVector>::iterator& outlierMapping = outliersMapping.find(clusterIndex);
+			outliersMapping[clusterIndex].push_back(outliers.at(i));
 			
-			if (outlierMapping == outliersMapping.end())
-			{
-				PoseParticleVector v;
-				
-				v.push_back(outlier);
-				
-				outliersMapping.insert(make_pair(clusterIndex,v));
-			}
-			else outlierMapping->second.push_back(outlier);
+			++i;
 		}
 		
-		for (multimap<int,PoseParticleVector>::iterator it = outliersMapping.begin(); it != outliersMapping.end(); ++it)
+		for (vector<vector<int> >::const_iterator it = outliersMapping.begin(); it != outliersMapping.end(); ++it)
 		{
-			if (it->second.size() >= MIN_SIZE_CLUSTER_AFTER_SPLITTING)
-			{
-				clusters.push_back(make_pair(it->second,Utils::calculateCentroid(it->second)));
-			}
+			if (it->size() >= MIN_SIZE_CLUSTER_AFTER_SPLITTING) clusters.push_back(*it);
 		}
 		
-		i = 0;
-		
 		/// Analyzing whether a cluster is non Gaussian. If so, it will splitted into 2 clusters.
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); ++i)
+		for (vector<vector<int> >::iterator it = clusters.begin(); it != clusters.end(); )
 		{
-			PoseParticle p1, p2;
+			int first, second;
 			
-			distance = FLT_MIN;
+			distance = findFarthestPair(particleVector,*it,first,second);
 			
-			for (PoseParticleVector::const_iterator it2 = it->first.begin(); it2 != it->first.end(); ++it2)
-			{
-				for (PoseParticleVector::const_iterator it3 = it->first.begin(); it3 != it->first.end(); ++it3)
-				{
-					temp = sqrt(((it2->pose.pose.x - it3->pose.pose.x) * (it2->pose.pose.x - it3->pose.pose.x)) + ((it2->pose.pose.y - it3->pose.pose.y) * (it2->pose.pose.y - it3->pose.pose.y)));
-					
-					if (temp > distance)
-					{
-						p1 = *it2;
-						p2 = *it3;
-						distance = temp;
-					}
-				}
-			}
+			const PoseParticle& p1 = particleVector.at(first);
+			const PoseParticle& p2 = particleVector.at(second);
 			
 			if (distance > qualityThreshold)
 			{
-				PoseParticleVector part1, part2;
 				float temp2;
 				
-				for (PoseParticleVector::const_iterator it2 = it->first.begin(); it2 != it->first.end(); ++it2)
+				part1.clear();
+				part2.clear();
+				
+				for (vector<int>::const_iterator it2 = it->begin(); it2 != it->end(); ++it2)
 				{
-					temp = sqrt(((it2->pose.pose.x - p1.pose.pose.x) * (it2->pose.pose.x - p1.pose.pose.x)) + ((it2->pose.pose.y - p1.pose.pose.y) * (it2->pose.pose.y - p1.pose.pose.y)));
-					temp2 = sqrt(((it2->pose.pose.x - p2.pose.pose.x) * (it2->pose.pose.x - p2.pose.pose.x)) + ((it2->pose.pose.y - p2.pose.pose.y) * (it2->pose.pose.y - p2.pose.pose.y)));
+					const PoseParticle& p = particleVector[*it2];
+					
+					temp = sqrt(((p.pose.pose.x - p1.pose.pose.x) * (p.pose.pose.x - p1.pose.pose.x)) + ((p.pose.pose.y - p1.pose.pose.y) * (p.pose.pose.y - p1.pose.pose.y)));
+					temp2 = sqrt(((p.pose.pose.x - p2.pose.pose.x) * (p.pose.pose.x - p2.pose.pose.x)) + ((p.pose.pose.y - p2.pose.pose.y) * (p.pose.pose.y - p2.pose.pose.y)));
 					
 					if ((temp < temp2) && (temp < (0.5 * qualityThreshold))) part1.push_back(*it2);
 					else if (temp2 < (0.5 * qualityThreshold)) part2.push_back(*it2);
 				}
 				
-				if (part1.size() >= MIN_SIZE_CLUSTER_AFTER_SPLITTING) clustersToBeAdded.push_back(make_pair(part1,Utils::calculateCentroid(part1)));
-				if (part2.size() >= MIN_SIZE_CLUSTER_AFTER_SPLITTING) clustersToBeAdded.push_back(make_pair(part2,Utils::calculateCentroid(part2)));
+				if (part1.size() >= MIN_SIZE_CLUSTER_AFTER_SPLITTING) clustersToBeAdded.push_back(part1);
+				if (part2.size() >= MIN_SIZE_CLUSTER_AFTER_SPLITTING) clustersToBeAdded.push_back(part2);
 				
 				it = clusters.erase(it);
 			}
 			else ++it;
 		}
 		
-		for (vector<pair<PoseParticleVector,Point2of> >::const_iterator it = clustersToBeAdded.begin(); it != clustersToBeAdded.end(); ++it)
+		clusters.insert(clusters.end(),clustersToBeAdded.begin(),clustersToBeAdded.end());
+		
+		allCentroids.clear();
+		
+		for (vector<vector<int> >::const_iterator it = clusters.begin(); it != clusters.end(); ++it)
 		{
-			clusters.push_back(*it);
+			allCentroids.push_back(calculateCentroid(particleVector,*it));
 		}
 		
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); )
+		for (i = 0; i < (int) clusters.size(); )
 		{
 			closeClusterNumber = 0;
 			
-			for (vector<pair<PoseParticleVector,Point2of> >::iterator it2 = clusters.begin(); it2 != clusters.end(); ++it2)
+			for (vector<Point2of>::const_iterator it = allCentroids.begin(); it != allCentroids.end(); ++it)
 			{
-				if (Utils::isTargetNear(it->second,it2->second,0.3 * qualityThreshold)) ++closeClusterNumber;
+				if (Utils::isTargetNear(allCentroids[i],*it,0.3 * qualityThreshold)) ++closeClusterNumber;
 			}
 			
-			if (closeClusterNumber > 1) it = clusters.erase(it);
-			else ++it;
+			if (closeClusterNumber > 1)
+			{
+				clusters.erase(clusters.begin() + i);
+				allCentroids.erase(allCentroids.begin() + i);
+			}
+			else ++i;
+		}
+		
+		i = 0;
+		
+		for (vector<vector<int> >::const_iterator it = clusters.begin(); it != clusters.end(); ++it, ++i)
+		{
+			for (vector<int>::const_iterator it2 = it->begin(); it2 != it->end(); ++it2) labels[*it2] = i;
+		}
+		
+		return clusters.size();
+	}
+	
+	float KClusterizer::findFarthestPair(const PoseParticleVector& particles, const vector<int>& indexes, int& first, int& second) const
+	{
+		const int size = indexes.size();
+		float maxDistance;
+		int h, lower;
+		
+		first = second = (size > 0) ? indexes.front() : 0;
+		
+		if (size < 2) return 0.0;
+		
+		sortedIndexes.assign(indexes.begin(),indexes.end());
+		
+		sort(sortedIndexes.begin(),sortedIndexes.end(),XOrder(particles));
+		
+		/// Andrew's monotone chain, dropping collinear points.
+		hull.resize(2 * size);
+		h = 0;
+		
+		for (int i = 0; i < size; ++i)
+		{
+			while ((h >= 2) && (cross(particles[hull[h - 2]],particles[hull[h - 1]],particles[sortedIndexes[i]]) <= 0)) --h;
+			
+			hull[h++] = sortedIndexes[i];
 		}
+		
+		lower = h + 1;
+		
+		for (int i = size - 2; i >= 0; --i)
+		{
+			while ((h >= lower) && (cross(particles[hull[h - 2]],particles[hull[h - 1]],particles[sortedIndexes[i]]) <= 0)) --h;
+			
+			hull[h++] = sortedIndexes[i];
+		}
+		
+		/// The first point is repeated at the end.
+		--h;
+		
+		first = hull[0];
+		second = hull[(h > 1) ? 1 : 0];
+		maxDistance = squaredDistance(particles[first],particles[second]);
+		
+		/// Rotating calipers: for every edge of the hull, the farthest vertex moves forward monotonically.
+		for (int i = 0, j = 1; (h > 2) && (i < h); ++i)
+		{
+			const int next = (i + 1) % h;
+			
+			while (cross(particles[hull[i]],particles[hull[next]],particles[hull[(j + 1) % h]]) > cross(particles[hull[i]],particles[hull[next]],particles[hull[j]])) j = (j + 1) % h;
+			
+			if (squaredDistance(particles[hull[i]],particles[hull[j]]) > maxDistance)
+			{
+				first = hull[i];
+				second = hull[j];
+				maxDistance = squaredDistance(particles[first],particles[second]);
+			}
+			
+			if (squaredDistance(particles[hull[next]],particles[hull[j]]) > maxDistance)
+			{
+				first = hull[next];
+				second = hull[j];
+				maxDistance = squaredDistance(particles[first],particles[second]);
+			}
+		}
+		
+		return sqrt(maxDistance);
 	}
 	
 	bool KClusterizer::isFarFrom(const PoseParticle& p1, const PoseParticle& p2, float qualityThreshold) const
@@ -45,11 +45,33 @@ namespace PTracking
 			 */
 			PriorityBuffer<PoseParticle> kpoints;
 			
+			/**
+			 * @brief indexes of the particles sorted along the x axis, used to build the convex hull of a cluster.
+			 */
+			mutable std::vector<int> sortedIndexes;
+			
+			/**
+			 * @brief indexes of the particles on the convex hull of a cluster, in counterclockwise order.
+			 */
+			mutable std::vector<int> hull;
+			
 			/**
 			 * @brief value of the current number of clusters \a k used during the clustering phase.
 			 */
 			int maxClusters;
 			
+			/**
+			 * @brief Function that finds the farthest pair of particles of a cluster, using the rotating calipers on its convex hull.
+			 * 
+			 * @param particles reference to the particles' vector being clusterized.
+			 * @param indexes reference to the indexes of the particles of the cluster.
+			 * @param first reference to the index of the first particle of the pair.
+			 * @param second reference to the index of the second particle of the pair.
+			 * 
+			 * @return the distance between the two particles (the diameter of the cluster).
+			 */
+			float findFarthestPair(const PoseParticleVector& particles, const std::vector<int>& indexes, int& first, int& second) const;
+			
 			/**
 			 * @brief Function that checks if two particles are far each other within a maximum threshold distance.
 			 * 
@@ -71,6 +93,17 @@ namespace PTracking
 			 */
 			bool isFarFromAll(const PoseParticle& p, float qualityThreshold) const;
 			
+		protected:
+			/**
+			 * @brief Function that assigns the particles to the clusters having a maximum radius given in input.
+			 * 
+			 * @param particleVector reference to the particles' vector that have to be clusterized.
+			 * @param qualityThreshold maximum radius of a cluster.
+			 * 
+			 * @return the number of clusters.
+			 */
+			int assignClusters(const PoseParticleVector& particleVector, float qualityThreshold);
+			
 		public:
 			/**
 			 * @brief Constructor that takes the desired maximum number of clusters as initialization value.
@@ -86,14 +119,6 @@ namespace PTracking
 			 */
 			~KClusterizer();
 			
-			/**
-			 * @brief Function that clusterizes a vector of particles creating a set of clusters with a maximum radius given in input.
-			 * 
-			 * @param particleVector reference to the particles' vector that have to be clusterized.
-			 * @param qualityThreshold maximum radius of a cluster.
-			 */
-			void clusterize(const PoseParticleVector& particleVector, float qualityThreshold);
-			
 			/**
 			 * @brief Function that returns the number of clusters \a k used by the clustering algorithm to clusterize the particles.
 			 * 
@@ -9,75 +9,63 @@ namespace PTracking
 	
 	QTClusterizer::~QTClusterizer() {;}
 	
-	void QTClusterizer::clusterize(const PoseParticleVector& particleVector, float qualityThreshold)
+	int QTClusterizer::assignClusters(const PoseParticleVector& particleVector, float qualityThreshold)
 	{
-		vector<vector<pair<PoseParticle,int> > > allCandidateClusters;
-		vector<pair<PoseParticle,int> > candidateCluster;
-		vector<int> indexParticlesToEliminate;
-		PoseParticleVector particles;
-		int i, index, j, particlesErased, size;
+		vector<vector<int> > allCandidateClusters;
+		vector<int> candidateCluster, particles;
+		int clusterNumber, j, size;
 		
-		clusters.clear();
+		clusterNumber = 0;
+		size = particleVector.size();
 		
-		particles = particleVector;
+		/// Indexes of the particles not yet clustered.
+		particles.resize(size);
+		
+		for (int i = 0; i < size; ++i) particles[i] = i;
 		
 		while (particles.size() > 0)
 		{
 			allCandidateClusters.clear();
 			
-			for (PoseParticleVector::iterator it = particles.begin(); it != particles.end(); it++)
+			for (vector<int>::const_iterator it = particles.begin(); it != particles.end(); it++)
 			{
-				index = 0;
-				
 				candidateCluster.clear();
 				
-				for (PoseParticleVector::iterator it2 = particles.begin(); it2 != particles.end(); it2++, index++)
+				for (unsigned int i = 0; i < particles.size(); ++i)
 				{
-					if (isNear(*it,*it2,qualityThreshold))
+					if (isNear(particleVector[*it],particleVector[particles[i]],qualityThreshold))
 					{
-						candidateCluster.push_back(make_pair(*it2,index));
+						candidateCluster.push_back(i);
 					}
 				}
 				
 				allCandidateClusters.push_back(candidateCluster);
 			}
 			
-			indexParticlesToEliminate.clear();
+			const vector<int>& biggestCluster = getBiggestCluster(allCandidateClusters);
 			
-			const PoseParticleVector& biggestCluster = getBiggestCluster(allCandidateClusters,indexParticlesToEliminate);
+			for (vector<int>::const_iterator it = biggestCluster.begin(); it != biggestCluster.end(); it++)
+			{
+				labels[particles[*it]] = clusterNumber;
+			}
 			
-			clusters.push_back(make_pair(biggestCluster,Utils::calculateCentroid(biggestCluster)));
+			++clusterNumber;
 			
-			i = 0;
 			j = 0;
-			index = indexParticlesToEliminate.front();
-			size = indexParticlesToEliminate.size();
-			particlesErased = 0;
 			
-			for (PoseParticleVector::iterator it = particles.begin(); it != particles.end(); )
+			for (vector<int>::const_iterator it = particles.begin(); it != particles.end(); it++)
 			{
-				if (i != index)
-				{
-					it++;
-					i++;
-				}
-				else
-				{
-					it = particles.erase(it);
-					
-					particlesErased++;
-					j++;
-					
-					if (j < size) index = indexParticlesToEliminate.at(j) - particlesErased;
-					else break;
-				}
+				if (labels[*it] < 0) particles[j++] = *it;
 			}
+			
+			particles.resize(j);
 		}
+		
+		return clusterNumber;
 	}
 	
-	PoseParticleVector QTClusterizer::getBiggestCluster(const vector<vector<pair<PoseParticle,int> > >& allCandidateClusters, vector<int>& indexParticlesToEliminate) const
+	const vector<int>& QTClusterizer::getBiggestCluster(const vector<vector<int> >& allCandidateClusters) const
 	{
-		PoseParticleVector choosenCluster;
 		unsigned int maxSize;
 		int i, index;
 		
@@ -85,7 +73,7 @@ namespace PTracking
 		index = 0;
 		maxSize = 0;
 		
-		for (vector<vector<pair<PoseParticle,int> > >::const_iterator it = allCandidateClusters.begin(); it != allCandidateClusters.end(); it++, i++)
+		for (vector<vector<int> >::const_iterator it = allCandidateClusters.begin(); it != allCandidateClusters.end(); it++, i++)
 		{
 			if (it->size() > maxSize)
 			{
@@ -94,15 +82,7 @@ namespace PTracking
 			}
 		}
 		
-		const vector<pair<PoseParticle,int> >& candidateCluster = allCandidateClusters.at(index);
-		
-		for (vector<pair<PoseParticle,int> >::const_iterator it = candidateCluster.begin(); it != candidateCluster.end(); it++)
-		{
-			choosenCluster.push_back(it->first);
-			indexParticlesToEliminate.push_back(it->second);
-		}
-		
-		return choosenCluster;
+		return allCandidateClusters.at(index);
 	}
 	
 	bool QTClusterizer::isNear(const PoseParticle& p1, const PoseParticle& p2, float qualityThreshold) const
@@ -15,12 +15,11 @@ namespace PTracking
 			/**
 			 * @brief Function that finds the biggest cluster obtained after the clusterization phase.
 			 * 
-			 * @param allCandidateClusters reference to the vector of clusters obtained.
-			 * @param indexParticlesToEliminate reference to a vector containing the indexes of particles to be deleted, once found the biggest cluster.
+			 * @param allCandidateClusters reference to the vector of clusters obtained, each one containing the positions of its particles among the not yet clustered ones.
 			 * 
-			 * @return the particles representing the biggest cluster.
+			 * @return a constant reference to the biggest cluster.
 			 */
-			PoseParticleVector getBiggestCluster(const std::vector<std::vector<std::pair<PoseParticle,int> > >& allCandidateClusters, std::vector<int>& indexParticlesToEliminate) const;
+			const std::vector<int>& getBiggestCluster(const std::vector<std::vector<int> >& allCandidateClusters) const;
 			
 			/**
 			 * @brief Function that checks if two particles are close each other within a maximum threshold distance.
@@ -33,6 +32,17 @@ namespace PTracking
 			 */
 			bool isNear(const PoseParticle& p1, const PoseParticle& p2, float qualityThreshold) const;
 			
+		protected:
+			/**
+			 * @brief Function that assigns the particles to the clusters, finding at every step the biggest cluster with a maximum radius given in input.
+			 * 
+			 * @param particleVector reference to the particles' vector that have to be clusterized.
+			 * @param qualityThreshold maximum radius of a cluster.
+			 * 
+			 * @return the number of clusters.
+			 */
+			int assignClusters(const PoseParticleVector& particleVector, float qualityThreshold);
+			
 		public:
 			/**
 			 * @brief Empty constructor.
@@ -43,13 +53,5 @@ namespace PTracking
 			 * @brief Destructor.
 			 */
 			~QTClusterizer();
-			
-			/**
-			 * @brief Function that clusterizes a vector of particles creating a set of clusters with a maximum radius given in input.
-			 * 
-			 * @param particleVector reference to the particles' vector that have to be clusterized.
-			 * @param qualityThreshold maximum radius of a cluster.
-			 */
-			void clusterize(const PoseParticleVector& particleVector, float qualityThreshold);
 	};
 }
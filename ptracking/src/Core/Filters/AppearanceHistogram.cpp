@@ -0,0 +1,46 @@
+#include "AppearanceHistogram.h"
+#include <math.h>
+
+namespace PTracking
+{
+	AppearanceHistogram::AppearanceHistogram(const int* counts)
+	{
+		Data* bins = new Data;
+		
+		for (int c = 0; c < CHANNELS; ++c)
+		{
+			const int* channelCounts = counts + (c * BINS);
+			int total = 0;
+			
+			for (int i = 0; i < BINS; ++i) total += channelCounts[i];
+			
+			for (int i = 0; i < BINS; ++i)
+			{
+				bins->amplitudes[c][i] = (total == 0) ? 0 : (uint16_t) (sqrt(channelCounts[i] / (float) total) * ONE + 0.5f);
+			}
+		}
+		
+		data.reset(bins);
+	}
+	
+	void AppearanceHistogram::bhattacharyyaCoefficients(const AppearanceHistogram& other, float coefficients[CHANNELS]) const
+	{
+		if (empty() || other.empty())
+		{
+			for (int c = 0; c < CHANNELS; ++c) coefficients[c] = 0.0;
+			
+			return;
+		}
+		
+		for (int c = 0; c < CHANNELS; ++c)
+		{
+			const uint16_t* a = data->amplitudes[c];
+			const uint16_t* b = other.data->amplitudes[c];
+			uint32_t dot = 0;
+			
+			for (int i = 0; i < BINS; ++i) dot += (uint32_t) a[i] * b[i];
+			
+			coefficients[c] = dot / ((float) ONE * ONE);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <stdint.h>
+
+/**
+ * @brief number of bins of every channel of an appearance histogram (it has to divide 256).
+ */
+#ifndef PTRACKING_HISTOGRAM_BINS
+#	define PTRACKING_HISTOGRAM_BINS 32
+#endif
+
+namespace PTracking
+{
+	/**
+	 * @class AppearanceHistogram
+	 * 
+	 * @brief Class that represents the color histograms (one per channel) of an observation/estimation in a compact form.
+	 * 
+	 * Every bin stores the square root of its frequency as a 15-bit fixed point number, so that the Bhattacharyya coefficient is just a dot product.
+	 * The bins are stored out-of-line and shared among copies, since they never change once built.
+	 */
+	class AppearanceHistogram
+	{
+		public:
+			/**
+			 * @brief number of channels of the histogram.
+			 */
+			static const int CHANNELS = 3;
+			
+			/**
+			 * @brief number of bins of every channel.
+			 */
+			static const int BINS = PTRACKING_HISTOGRAM_BINS;
+			
+			/**
+			 * @brief fixed point value representing 1.
+			 */
+			static const int ONE = 32767;
+			
+			/**
+			 * @brief Empty constructor, building an empty histogram.
+			 */
+			AppearanceHistogram() {;}
+			
+			/**
+			 * @brief Constructor that builds the histogram out of the bin counts of every channel, stored as counts[channel * BINS + bin].
+			 * 
+			 * @param counts pointer to the bin counts, normalized independently for every channel.
+			 */
+			explicit AppearanceHistogram(const int* counts);
+			
+			/**
+			 * @brief Function that computes the Bhattacharyya coefficients of every channel between this histogram and another one.
+			 * 
+			 * @param other reference to the other histogram.
+			 * @param coefficients Bhattacharyya coefficients of every channel (zero if either histogram is empty).
+			 */
+			void bhattacharyyaCoefficients(const AppearanceHistogram& other, float coefficients[CHANNELS]) const;
+			
+			/**
+			 * @brief Function that checks whether the histogram has been built.
+			 * 
+			 * @return true if the histogram is empty, false otherwise.
+			 */
+			inline bool empty() const { return data.get() == 0; }
+			
+			/**
+			 * @brief Function that returns the bins of a channel, as square roots of the frequencies in fixed point.
+			 * 
+			 * @param channel channel of the bins.
+			 * 
+			 * @return a pointer to the BINS values of the channel, 0 if the histogram is empty.
+			 */
+			inline const uint16_t* amplitudes(int channel) const { return (data.get() == 0) ? 0 : data->amplitudes[channel]; }
+			
+		private:
+			/**
+			 * @brief Struct representing the bins of the histogram.
+			 */
+			struct Data
+			{
+				uint16_t amplitudes[CHANNELS][BINS];
+			};
+			
+			/**
+			 * @brief bins of the histogram, shared among all the copies.
+			 */
+			boost::shared_ptr<const Data> data;
+	};
+}
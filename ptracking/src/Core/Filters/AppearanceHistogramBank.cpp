@@ -0,0 +1,161 @@
+#include "AppearanceHistogramBank.h"
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#	define PTRACKING_BANK_X86 1
+#	include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace PTracking
+{
+	namespace
+	{
+		/// Every bin is at most AppearanceHistogram::ONE and the square roots of the frequencies have unit norm, hence no dot product overflows an int32.
+		typedef void (*DotProductsFn)(const int16_t*, const int16_t*, unsigned int, int, int32_t*);
+		
+		void dotProductsScalar(const int16_t* query, const int16_t* bank, unsigned int count, int channelStride, int32_t* dots)
+		{
+			for (unsigned int i = 0; i < count * AppearanceHistogram::CHANNELS; ++i, bank += channelStride)
+			{
+				const int16_t* q = query + ((i % AppearanceHistogram::CHANNELS) * channelStride);
+				int32_t dot = 0;
+				
+				for (int j = 0; j < channelStride; ++j) dot += (int32_t) q[j] * bank[j];
+				
+				dots[i] = dot;
+			}
+		}
+
+#ifdef PTRACKING_BANK_X86
+		__attribute__((target("sse2")))
+		void dotProductsSSE2(const int16_t* query, const int16_t* bank, unsigned int count, int channelStride, int32_t* dots)
+		{
+			for (unsigned int i = 0; i < count * AppearanceHistogram::CHANNELS; ++i, bank += channelStride)
+			{
+				const int16_t* q = query + ((i % AppearanceHistogram::CHANNELS) * channelStride);
+				__m128i sum = _mm_setzero_si128();
+				
+				for (int j = 0; j < channelStride; j += 8)
+				{
+					sum = _mm_add_epi32(sum,_mm_madd_epi16(_mm_loadu_si128((const __m128i*) (q + j)),_mm_loadu_si128((const __m128i*) (bank + j))));
+				}
+				
+				sum = _mm_add_epi32(sum,_mm_shuffle_epi32(sum,_MM_SHUFFLE(1,0,3,2)));
+				sum = _mm_add_epi32(sum,_mm_shuffle_epi32(sum,_MM_SHUFFLE(2,3,0,1)));
+				
+				dots[i] = _mm_cvtsi128_si32(sum);
+			}
+		}
+		
+		__attribute__((target("avx2")))
+		void dotProductsAVX2(const int16_t* query, const int16_t* bank, unsigned int count, int channelStride, int32_t* dots)
+		{
+			for (unsigned int i = 0; i < count * AppearanceHistogram::CHANNELS; ++i, bank += channelStride)
+			{
+				const int16_t* q = query + ((i % AppearanceHistogram::CHANNELS) * channelStride);
+				__m256i sum = _mm256_setzero_si256();
+				
+				for (int j = 0; j < channelStride; j += 16)
+				{
+					sum = _mm256_add_epi32(sum,_mm256_madd_epi16(_mm256_loadu_si256((const __m256i*) (q + j)),_mm256_loadu_si256((const __m256i*) (bank + j))));
+				}
+				
+				__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),_mm256_extracti128_si256(sum,1));
+				
+				half = _mm_add_epi32(half,_mm_shuffle_epi32(half,_MM_SHUFFLE(1,0,3,2)));
+				half = _mm_add_epi32(half,_mm_shuffle_epi32(half,_MM_SHUFFLE(2,3,0,1)));
+				
+				dots[i] = _mm_cvtsi128_si32(half);
+			}
+		}
+#endif
+
+		struct DotProducts
+		{
+			DotProductsFn function;
+			const char* instructionSet;
+		};
+		
+		DotProducts selectDotProducts()
+		{
+			DotProducts dotProducts = { dotProductsScalar, "scalar" };
+
+#ifdef PTRACKING_BANK_X86
+			__builtin_cpu_init();
+			
+			if (__builtin_cpu_supports("avx2"))
+			{
+				dotProducts.function = dotProductsAVX2;
+				dotProducts.instructionSet = "avx2";
+			}
+			else if (__builtin_cpu_supports("sse2"))
+			{
+				dotProducts.function = dotProductsSSE2;
+				dotProducts.instructionSet = "sse2";
+			}
+#endif
+
+			return dotProducts;
+		}
+		
+		const DotProducts& dotProducts()
+		{
+			static const DotProducts selected = selectDotProducts();
+			
+			return selected;
+		}
+	}
+	
+	void AppearanceHistogramBank::add(const AppearanceHistogram& histogram)
+	{
+		amplitudes.resize(amplitudes.size() + STRIDE);
+		
+		pack(histogram,&amplitudes[amplitudes.size() - STRIDE]);
+	}
+	
+	void AppearanceHistogramBank::bhattacharyyaCoefficients(const AppearanceHistogram& histogram, vector<float>& coefficients) const
+	{
+		const unsigned int count = size();
+		
+		coefficients.resize(count * AppearanceHistogram::CHANNELS);
+		
+		if (count == 0) return;
+		
+		query.resize(STRIDE);
+		dots.resize(coefficients.size());
+		
+		pack(histogram,&query[0]);
+		
+		dotProducts().function(&query[0],&amplitudes[0],count,CHANNEL_STRIDE,&dots[0]);
+		
+		for (unsigned int i = 0; i < coefficients.size(); ++i)
+		{
+			coefficients[i] = dots[i] / ((float) AppearanceHistogram::ONE * AppearanceHistogram::ONE);
+		}
+	}
+	
+	const char* AppearanceHistogramBank::instructionSet()
+	{
+		return dotProducts().instructionSet;
+	}
+	
+	void AppearanceHistogramBank::pack(const AppearanceHistogram& histogram, int16_t* destination)
+	{
+		/// An empty histogram is all zeros, hence all its coefficients are zero.
+		fill(destination,destination + STRIDE,0);
+		
+		if (histogram.empty()) return;
+		
+		for (int c = 0; c < AppearanceHistogram::CHANNELS; ++c)
+		{
+			copy(histogram.amplitudes(c),histogram.amplitudes(c) + AppearanceHistogram::BINS,destination + (c * CHANNEL_STRIDE));
+		}
+	}
+	
+	void AppearanceHistogramBank::set(unsigned int index, const AppearanceHistogram& histogram)
+	{
+		pack(histogram,&amplitudes[index * STRIDE]);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AppearanceHistogram.h"
+#include <vector>
+
+namespace PTracking
+{
+	/**
+	 * @class AppearanceHistogramBank
+	 * 
+	 * @brief Class that stores a bank of appearance histograms packed contiguously, so that a histogram can be compared against all of them at once.
+	 * 
+	 * The bins of every channel are padded with zeros to a multiple of 16, and the dot products are computed with SSE2 or AVX2 (selected at runtime) on x86.
+	 */
+	class AppearanceHistogramBank
+	{
+		private:
+			/**
+			 * @brief number of padded bins of every channel.
+			 */
+			static const int CHANNEL_STRIDE = (AppearanceHistogram::BINS + 15) & ~15;
+			
+			/**
+			 * @brief number of padded bins of every histogram.
+			 */
+			static const int STRIDE = AppearanceHistogram::CHANNELS * CHANNEL_STRIDE;
+			
+			/**
+			 * @brief padded bins of all the histograms of the bank.
+			 */
+			std::vector<int16_t> amplitudes;
+			
+			/**
+			 * @brief padded bins of the histogram being compared against the bank.
+			 */
+			mutable std::vector<int16_t> query;
+			
+			/**
+			 * @brief dot products of the last comparison.
+			 */
+			mutable std::vector<int32_t> dots;
+			
+			/**
+			 * @brief Function that copies the bins of a histogram in the padded layout of the bank.
+			 * 
+			 * @param histogram reference to the histogram to be copied.
+			 * @param destination pointer to the STRIDE padded bins.
+			 */
+			static void pack(const AppearanceHistogram& histogram, int16_t* destination);
+			
+		public:
+			/**
+			 * @brief Function that adds a histogram at the end of the bank.
+			 * 
+			 * @param histogram reference to the histogram to be added.
+			 */
+			void add(const AppearanceHistogram& histogram);
+			
+			/**
+			 * @brief Function that computes the Bhattacharyya coefficients of every channel between a histogram and all the ones of the bank.
+			 * 
+			 * @param histogram reference to the histogram to be compared.
+			 * @param coefficients Bhattacharyya coefficients, stored as coefficients[index * CHANNELS + channel] (zero if either histogram is empty).
+			 */
+			void bhattacharyyaCoefficients(const AppearanceHistogram& histogram, std::vector<float>& coefficients) const;
+			
+			/**
+			 * @brief Function that replaces a histogram of the bank.
+			 * 
+			 * @param index index of the histogram to be replaced.
+			 * @param histogram reference to the new histogram.
+			 */
+			void set(unsigned int index, const AppearanceHistogram& histogram);
+			
+			/**
+			 * @brief Function that returns the number of histograms of the bank.
+			 * 
+			 * @return the number of histograms of the bank.
+			 */
+			inline unsigned int size() const { return amplitudes.size() / STRIDE; }
+			
+			/**
+			 * @brief Function that returns the name of the instruction set used to compare the histograms.
+			 * 
+			 * @return "avx2", "sse2" or "scalar".
+			 */
+			static const char* instructionSet();
+	};
+}
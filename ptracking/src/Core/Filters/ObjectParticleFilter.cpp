@@ -1,4 +1,5 @@
 #include "ObjectParticleFilter.h"
+#include "../Clusterizer/GridClusterizer/GridClusterizer.h"
 #include "../Clusterizer/KClusterizer/KClusterizer.h"
 #include "../Clusterizer/QTClusterizer/QTClusterizer.h"
 #include "../SensorModels/BasicSensorModel.h"
@@ -19,7 +20,94 @@ using manfield::SensorModel;
 
 namespace PTracking
 {
-	ObjectParticleFilter::ObjectParticleFilter(const string& type) : ParticleFilter(type), clusterizer(0), maxIdentityNumber(0) {;}
+	namespace
+	{
+		/**
+		 * @brief Context of the prediction of the targets, every target owns a block of particlesPerTarget particles.
+		 */
+		struct PredictionTask
+		{
+			PoseParticleVector* particles;
+			const vector<pair<int,PointWithVelocity> >* targets;
+			uint64_t seed;
+			unsigned int particlesPerTarget;
+			float sigmaPosition, sigmaTheta;
+			float a, b, c, d, deltaX, deltaY, deltaTheta;
+		};
+		
+		/**
+		 * @brief Context of the normalization of the clusters.
+		 */
+		struct NormalizationTask
+		{
+			PoseParticleVector* particles;
+			const vector<ClusterRange>* clusters;
+		};
+		
+		void moveParticles(const PredictionTask& task, PoseParticleVector::iterator begin, PoseParticleVector::iterator end)
+		{
+			for (PoseParticleVector::iterator it = begin; it != end; ++it)
+			{
+				/// Runge-Kutta approximation.
+				it->pose.pose.x += (task.deltaX * task.a) + (task.deltaY * task.b);
+				it->pose.pose.y += (task.deltaX * task.c) + (task.deltaY * task.d);
+				it->pose.pose.theta = Utils::angNormPiSig(it->pose.pose.theta + task.deltaTheta);
+			}
+		}
+		
+		void predictTarget(void* context, unsigned int index)
+		{
+			const PredictionTask& task = *static_cast<const PredictionTask*>(context);
+			const pair<int,PointWithVelocity>& target = (*task.targets)[index];
+			const PoseParticleVector::iterator& begin = task.particles->begin() + (index * task.particlesPerTarget);
+			const PoseParticleVector::iterator& end = begin + task.particlesPerTarget;
+			
+			/// The noise of a target depends only on the seed, the prediction step and its identity, not on the thread predicting it.
+			Random random(task.seed ^ (((uint64_t) target.first) * 0x9E3779B97F4A7C15ULL));
+			
+			fill(begin,end,PoseParticle(target.second,1.0));
+			
+			/// Adding Gaussian noise.
+			Utils::addGaussianNoise(begin,end,task.sigmaPosition,task.sigmaTheta,random);
+			
+			moveParticles(task,begin,end);
+		}
+		
+		void normalizeCluster(void* context, unsigned int index)
+		{
+			const NormalizationTask& task = *static_cast<const NormalizationTask*>(context);
+			const PoseParticleVector::iterator& begin = task.particles->begin() + (*task.clusters)[index].begin;
+			const PoseParticleVector::iterator& end = task.particles->begin() + (*task.clusters)[index].end;
+			float totalWeight;
+			
+			totalWeight = 0.0;
+			
+			/// Calculation of total weight of the particles of cluster.
+			for (PoseParticleVector::iterator it = begin; it != end; it++)
+			{
+				totalWeight += it->weight;
+			}
+			
+			/// No particle of the cluster is close to an observation (e.g. gated likelihood), a uniform weight avoids 0/0 reaching the resampler and the sort.
+			if (!(totalWeight > 0.0))
+			{
+				for (PoseParticleVector::iterator it = begin; it != end; it++)
+				{
+					it->weight = 1.0 / (end - begin);
+				}
+				
+				return;
+			}
+			
+			/// Normalize weight of the particles of cluster.
+			for (PoseParticleVector::iterator it = begin; it != end; it++)
+			{
+				it->weight /= totalWeight;
+			}
+		}
+	}
+	
+	ObjectParticleFilter::ObjectParticleFilter(const string& type) : ParticleFilter(type), clusterizer(0), essThreshold(1.0), threadPool(&ThreadPool::serial()), randomSeed(0), predictions(0), maxIdentityNumber(0) {;}
 	
 	ObjectParticleFilter::~ObjectParticleFilter()
 	{
@@ -28,6 +116,7 @@ namespace PTracking
 	
 	void ObjectParticleFilter::addParticlesInInterestingPoints(ObjectSensorReading& readings)
 	{
+		Random random = getRandom(PromotionStream);
 		float distance, minDistance;
 		int clusterIndex, counterIndex;
 		bool associated;
@@ -49,10 +138,10 @@ namespace PTracking
 			counterIndex = 0;
 			associated = false;
 			
-			for (vector<pair<PoseParticleVector,Point2of> >::iterator it2 = clusters.begin(); it2 != clusters.end(); ++it2, ++counterIndex)
+			for (vector<ClusterRange>::const_iterator it2 = clusters.begin(); it2 != clusters.end(); ++it2, ++counterIndex)
 			{
-				distance = sqrt(((it->observation.getCartesian().x - it2->second.x) * (it->observation.getCartesian().x - it2->second.x)) +
-								((it->observation.getCartesian().y - it2->second.y) * (it->observation.getCartesian().y - it2->second.y)));
+				distance = sqrt(((it->observation.getCartesian().x - it2->centroid.x) * (it->observation.getCartesian().x - it2->centroid.x)) +
+								((it->observation.getCartesian().y - it2->centroid.y) * (it->observation.getCartesian().y - it2->centroid.y)));
 				
 				/// A cluster does not have to be already associated to an observation.
 				if ((distance < minDistance) && (observationsMapping.find(counterIndex) == observationsMapping.end()))
@@ -68,10 +157,10 @@ namespace PTracking
 				observeNeeded = true;
 				++numberOfObservationAssociatedAndPromoted;
 				
-				observationsMapping.insert(make_pair(clusterIndex,make_pair(*it,clusters.at(clusterIndex).second)));
+				observationsMapping.insert(make_pair(clusterIndex,make_pair(*it,clusters.at(clusterIndex).centroid)));
 				
 #ifdef DEBUG_MODE
-				WARN("Associated observation [" << it->observation.getCartesian().x << "," << it->observation.getCartesian().y << "] to cluster [" << clusters.at(clusterIndex).second.x << "," << clusters.at(clusterIndex).second.y << "]" << endl);
+				WARN("Associated observation [" << it->observation.getCartesian().x << "," << it->observation.getCartesian().y << "] to cluster [" << clusters.at(clusterIndex).centroid.x << "," << clusters.at(clusterIndex).centroid.y << "]" << endl);
 #endif
 			}
 			
@@ -157,15 +246,8 @@ namespace PTracking
 					fill_n(back_inserter(particlesNewPromotedObservation),getparticleNumber() * (((numberOfObservationAssociatedAndPromoted == 0) && (clusters.size() == 0)) ? 1.0 : 0.05),
 										 PoseParticle(pointWithVelocity,1.0));
 					
-					for (PoseParticleVector::iterator it2 = particlesNewPromotedObservation.begin(); it2 != particlesNewPromotedObservation.end(); ++it2)
-					{
-						/// Adding Gaussian noise.
-						Point2of noise(Utils::sampleGaussianSigma(m_params.sr0),Utils::sampleGaussianSigma(m_params.sr0),Utils::sampleGaussianSigma(m_params.st0));
-						
-						it2->pose.pose.x += noise.x;
-						it2->pose.pose.y += noise.y;
-						it2->pose.pose.theta = Utils::angNormPiSig(it2->pose.pose.theta + noise.theta);
-					}
+					/// Adding Gaussian noise, seeded so that a fixed random seed gives the same run.
+					Utils::addGaussianNoise(particlesNewPromotedObservation.begin(),particlesNewPromotedObservation.end(),m_params.sr0,m_params.st0,random);
 					
 					m_params.m_particles.insert(m_params.m_particles.end(),particlesNewPromotedObservation.begin(),particlesNewPromotedObservation.end());
 					
@@ -284,7 +366,7 @@ namespace PTracking
 				
 				ObjectSensorReading::Observation groupEstimation;
 				
-				groupEstimation.observation = PolarPoint(atan2(heightMax,barycenter),Point2f(barycenter,heightMax).mod());
+				groupEstimation.observation = PolarPoint(Point2f(barycenter,heightMax));
 				groupEstimation.model.barycenter = barycenter;
 				groupEstimation.model.height = heightMax - heightMin;
 				groupEstimation.model.width = widthMax - widthMin;
@@ -313,23 +395,38 @@ namespace PTracking
 		}
 	}
 	
-	pair<bool,float> ObjectParticleFilter::areModelsSimilar(const ObjectSensorReading::Model& observationModel, const ObjectSensorReading::Model& storedModel) const
+	pair<int,float> ObjectParticleFilter::findMostSimilarModel(const ObjectSensorReading::Model& observationModel) const
 	{
-		float bhattacharyyaCoefficients[3] = { 0.0, 0.0, 0.0 };
-		float bhattacharyyaDistance;
+		vector<float> bhattacharyyaCoefficients;
+		float bhattacharyyaDistance, minBhattacharyyaDistance;
+		int index;
 		
-		for (int i = 0; i < ObjectSensorReading::Model::HISTOGRAM_VECTOR_LENGTH; ++i)
-		{
-			bhattacharyyaCoefficients[0] += sqrt(observationModel.histograms[0][i] * storedModel.histograms[0][i]);
-			bhattacharyyaCoefficients[1] += sqrt(observationModel.histograms[1][i] * storedModel.histograms[1][i]);
-			bhattacharyyaCoefficients[2] += sqrt(observationModel.histograms[2][i] * storedModel.histograms[2][i]);
-		}
+		targetHistograms.bhattacharyyaCoefficients(observationModel.histograms,bhattacharyyaCoefficients);
 		
-		bhattacharyyaDistance = 0.0;
+		minBhattacharyyaDistance = FLT_MAX;
+		index = -1;
 		
-		for (int i = 0; i < 3; ++i) bhattacharyyaDistance += ((3.0 - i) / 6.0) * sqrt(1 - bhattacharyyaCoefficients[i]);
+		for (unsigned int i = 0; i < targetModels.size(); ++i)
+		{
+			const float* coefficients = &bhattacharyyaCoefficients[i * AppearanceHistogram::CHANNELS];
+			
+			bhattacharyyaDistance = 0.0;
+			
+			/// Fixed point rounding can bring a coefficient slightly above 1.
+			for (int j = 0; j < 3; ++j) bhattacharyyaDistance += ((3.0 - j) / 6.0) * sqrt(max(1 - coefficients[j],0.0f));
+			
+			if ((bhattacharyyaDistance < 0.35) && (bhattacharyyaDistance < minBhattacharyyaDistance))
+			{
+				/// Checking if the re-identification was unique. It could happen that two different objects are re-identified with the same model.
+				if (estimatedTargetModelsWithIdentity.find(targetModels.at(i).second) == estimatedTargetModelsWithIdentity.end())
+				{
+					minBhattacharyyaDistance = bhattacharyyaDistance;
+					index = i;
+				}
+			}
+		}
 		
-		return make_pair(bhattacharyyaDistance < 0.35,bhattacharyyaDistance);
+		return make_pair(index,minBhattacharyyaDistance);
 	}
 	
 	bool ObjectParticleFilter::checkFilterForReinitialization()
@@ -361,6 +458,7 @@ namespace PTracking
 		
 		if (strcasecmp(clusteringAlgorithm.c_str(),"KClusterizer") == 0) clusterizer = new KClusterizer(1);
 		else if (strcasecmp(clusteringAlgorithm.c_str(),"QTClusterizer") == 0) clusterizer = new QTClusterizer();
+		else if (strcasecmp(clusteringAlgorithm.c_str(),"GridClusterizer") == 0) clusterizer = new GridClusterizer();
 		
 		return true;
 	}
@@ -393,6 +491,12 @@ namespace PTracking
 			key = "opticalTracker";
 			opticalTracker = fCfg.value(section,key);
 			
+			key = "parallelTargets";
+			threadPool = (bool) fCfg.value(section,key) ? &ThreadPool::shared() : &ThreadPool::serial();
+			
+			key = "randomSeed";
+			randomSeed = fCfg.value(section,key);
+			
 			key = "timeToWaitBeforeDeleting";
 			timeToWaitBeforeDeleting = fCfg.value(section,key);
 			
@@ -444,6 +548,8 @@ namespace PTracking
 		
 		m_sensorModel->configure(filename,new BasicSensor(filterName));
 		
+		static_cast<BasicSensorModel*>(m_sensorModel)->setThreadPool(*threadPool);
+		
 		BasicSensorMap* basicSensorMap = new BasicSensorMap();
 		
 		try
@@ -500,8 +606,35 @@ namespace PTracking
 			exit(-1);
 		}
 		
+		try
+		{
+			section = "resampling";
+			
+			key = "method";
+			temp = string(fCfg.value(section,key));
+			
+			if (strcasecmp(temp.c_str(),"systematic") == 0) resampler.setMethod(Resampler::Systematic);
+			else if (strcasecmp(temp.c_str(),"residual") == 0) resampler.setMethod(Resampler::Residual);
+			else
+			{
+				ERR("Unknown resampling method '" << temp << "'. Exiting..." << endl);
+				
+				exit(-1);
+			}
+			
+			key = "essThreshold";
+			essThreshold = fCfg.value(section,key);
+		}
+		catch (...)
+		{
+			ERR("Not existing value '" << section << "/" << key << "'. Exiting..." << endl);
+			
+			exit(-1);
+		}
+		
 		if (strcasecmp(clusteringAlgorithm.c_str(),"KClusterizer") == 0) clusterizer = new KClusterizer(1);
 		else if (strcasecmp(clusteringAlgorithm.c_str(),"QTClusterizer") == 0) clusterizer = new QTClusterizer();
+		else if (strcasecmp(clusteringAlgorithm.c_str(),"GridClusterizer") == 0) clusterizer = new GridClusterizer();
 		
 		Point2f p;
 		ifstream ifs;
@@ -542,28 +675,43 @@ namespace PTracking
 		DEBUG("\tTime to wait before deleting: " << timeToWaitBeforeDeleting << " ms" << endl);
 		WARN("\tTime to wait before promoting: " << timeToWaitBeforePromoting << " ms" << endl);
 		INFO("\tCloseness object threshold (in " << (opticalTracker ? "pixels" : "meters") << "): " << closenessThreshold << endl);
+		DEBUG("\tResampling: " << ((resampler.getMethod() == Resampler::Residual) ? "residual" : "systematic") << ", effective sample size threshold " << essThreshold << endl);
+		INFO("\tParallel targets: " << threadPool->getNumThreads() << " thread" << ((threadPool->getNumThreads() > 1) ? "s" : "") << ", random seed " << randomSeed << endl);
 		ERR("******************************************************" << endl << endl);
 	}
 	
 	void ObjectParticleFilter::normalizeWeight()
 	{
-		float totalWeight;
+		NormalizationTask task = { &m_params.m_particles, &clusters };
+		
+		threadPool->run(clusters.size(),normalizeCluster,&task);
 		
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); it++)
+		/// The particles outside the clusters (never clusterized or belonging to a discarded cluster) are normalized as a single group, so that the
+		/// sort and the truncation in observe() compare weights on the same scale.
+		clusteredParticles.assign(m_params.m_particles.size(),0);
+		
+		for (vector<ClusterRange>::const_iterator it = clusters.begin(); it != clusters.end(); ++it)
 		{
-			totalWeight = 0.0;
+			fill(clusteredParticles.begin() + it->begin,clusteredParticles.begin() + it->end,1);
+		}
+		
+		float totalWeight = 0.0;
+		int unclustered = 0;
+		
+		for (unsigned int i = 0; i < m_params.m_particles.size(); ++i)
+		{
+			if (clusteredParticles[i]) continue;
 			
-			/// Calculation of total weight of the particles of cluster.
-			for (PoseParticleVector::iterator it2 = it->first.begin(); it2 != it->first.end(); it2++)
-			{
-				totalWeight += it2->weight;
-			}
+			totalWeight += m_params.m_particles[i].weight;
+			++unclustered;
+		}
+		
+		for (unsigned int i = 0; i < m_params.m_particles.size(); ++i)
+		{
+			if (clusteredParticles[i]) continue;
 			
-			/// Normalize weight of the particles of cluster.
-			for (PoseParticleVector::iterator it2 = it->first.begin(); it2 != it->first.end(); it2++)
-			{
-				it2->weight /= totalWeight;
-			}
+			if (totalWeight > 0.0) m_params.m_particles[i].weight /= totalWeight;
+			else m_params.m_particles[i].weight = 1.0 / unclustered;
 		}
 		
 		m_params.m_maxParticle.weight = 0.0;
@@ -629,8 +777,7 @@ namespace PTracking
 					{
 						const PointWithVelocity& newPose = Utils::estimatedPosition(it->second.first.observation.getCartesian(),it->second.first.model.velocity,dt);
 						
-						it->second.first.observation.rho = sqrt((newPose.pose.x * newPose.pose.x) + (newPose.pose.y * newPose.pose.y));
-						it->second.first.observation.theta = atan2(newPose.pose.y,newPose.pose.x);
+						it->second.first.observation.setCartesian(Point2f(newPose.pose.x,newPose.pose.y));
 					}
 					
 					++it;
@@ -671,11 +818,12 @@ namespace PTracking
 			}
 		}
 		
+		/// The particles are grouped by cluster in place, every cluster is a range of m_particles until they are sorted by weight below.
 		clusterizer->clusterize(m_params.m_particles,(opticalTracker) ? 20 : 0.45);
 		clusters = clusterizer->getClusters();
 		
 		/// Sort in decreasing order.
-		sort(clusters.begin(),clusters.end(),Utils::comparePairPoint2of);
+		sort(clusters.begin(),clusters.end(),Utils::compareClusterRange);
 		
 		updateTargetIdentity(readings);
 		
@@ -694,9 +842,9 @@ namespace PTracking
 		
 		i = 1;
 		
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); ++it, ++i)
+		for (vector<ClusterRange>::iterator it = clusters.begin(); it != clusters.end(); ++it, ++i)
 		{
-			DEBUG("Cluster (" << i << ") -> [" << it->second.x << "," << it->second.y << "]" << endl);
+			DEBUG("Cluster (" << i << ") -> [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 		}
 		
 		ERR("########################################################" << endl);
@@ -714,8 +862,10 @@ namespace PTracking
 	
 	void ObjectParticleFilter::predict(const Point2of& newRobotPose, const Point2of& oldRobotPose, const Timestamp& initialTimestamp, const Timestamp& current)
 	{
+		vector<pair<int,PointWithVelocity> > targets;
+		PredictionTask task;
 		Point2f velocity;
-		float a, b, c, d, deltaX, deltaY, deltaTheta, deltaTheta2;
+		float deltaTheta2;
 		unsigned int bestParticlesEachCluster;
 		
 		bestParticlesEachCluster = 0;
@@ -724,8 +874,6 @@ namespace PTracking
 		if (estimatedTargetModelsWithIdentity.size() > 0)
 		{
 			bestParticlesEachCluster = getparticleNumber() / estimatedTargetModelsWithIdentity.size();
-			
-			m_params.m_particles.clear();
 		}
 		
 		/// Because the timestamps are in milliseconds.
@@ -752,25 +900,38 @@ namespace PTracking
 				velocity.y = 0.0;
 			}
 			
-			const PointWithVelocity& newPose = Utils::estimatedPosition(it->second.first.observation.getCartesian(),velocity,dt);
-			
-			PoseParticleVector part;
-			
-			fill_n(back_inserter(part),bestParticlesEachCluster,PoseParticle(newPose,1.0));
+			targets.push_back(make_pair(it->first,Utils::estimatedPosition(it->second.first.observation.getCartesian(),velocity,dt)));
+		}
+		
+		/// I am considering the robot's movement too. So, the particles are moved coherently.
+		task.deltaX = cos(-newRobotPose.theta) * (newRobotPose.x - oldRobotPose.x) - sin(-newRobotPose.theta) * (newRobotPose.y - oldRobotPose.y);
+		task.deltaY = sin(-newRobotPose.theta) * (newRobotPose.x - oldRobotPose.x) + cos(-newRobotPose.theta) * (newRobotPose.y - oldRobotPose.y);
+		task.deltaTheta = Utils::angNormPiSig(newRobotPose.theta - oldRobotPose.theta);
+		deltaTheta2 = task.deltaTheta / 2;
+		
+		task.a = cos(oldRobotPose.theta + deltaTheta2);
+		task.b = cos(M_PI / 2 + oldRobotPose.theta + deltaTheta2);
+		
+		task.c = sin(oldRobotPose.theta + deltaTheta2);
+		task.d = sin(M_PI / 2 + oldRobotPose.theta + deltaTheta2);
+		
+		task.particles = &m_params.m_particles;
+		task.targets = &targets;
+		task.seed = (((uint64_t) randomSeed) << 32) ^ predictions++;
+		task.particlesPerTarget = bestParticlesEachCluster;
+		task.sigmaPosition = m_params.sr0;
+		task.sigmaTheta = m_params.st0;
+		
+		if (!targets.empty())
+		{
+			/// Every target owns a block of the particles, hence the targets are predicted concurrently.
+			m_params.m_particles.resize(targets.size() * bestParticlesEachCluster);
 			
-			for (PoseParticleVector::iterator it2 = part.begin(); it2 != part.end(); ++it2)
-			{
-				/// Adding Gaussian noise.
-				Point2of noise(Utils::sampleGaussianSigma(m_params.sr0),Utils::sampleGaussianSigma(m_params.sr0),Utils::sampleGaussianSigma(m_params.st0));
-				
-				it2->pose.pose.x += noise.x;
-				it2->pose.pose.y += noise.y;
-				it2->pose.pose.theta = Utils::angNormPiSig(it2->pose.pose.theta + noise.theta);
-				
-				m_params.m_particles.push_back(*it2);
-			}
+			threadPool->run(targets.size(),predictTarget,&task);
 		}
+		else moveParticles(task,m_params.m_particles.begin(),m_params.m_particles.end());
 		
+		/// The copied particles have already been moved.
 		if (m_params.m_particles.size() < getparticleNumber())
 		{
 			unsigned int difference;
@@ -780,26 +941,6 @@ namespace PTracking
 			for (unsigned int j = 0; j < difference; j++) m_params.m_particles.push_back(m_params.m_particles.at(j));
 		}
 		
-		/// I am considering the robot's movement too. So, the particles are moved coherently.
-		deltaX = cos(-newRobotPose.theta) * (newRobotPose.x - oldRobotPose.x) - sin(-newRobotPose.theta) * (newRobotPose.y - oldRobotPose.y);
-		deltaY = sin(-newRobotPose.theta) * (newRobotPose.x - oldRobotPose.x) + cos(-newRobotPose.theta) * (newRobotPose.y - oldRobotPose.y);
-		deltaTheta = Utils::angNormPiSig(newRobotPose.theta - oldRobotPose.theta);
-		deltaTheta2 = deltaTheta / 2;
-		
-		a = cos(oldRobotPose.theta + deltaTheta2);
-		b = cos(M_PI / 2 + oldRobotPose.theta + deltaTheta2);
-		
-		c = sin(oldRobotPose.theta + deltaTheta2);
-		d = sin(M_PI / 2 + oldRobotPose.theta + deltaTheta2);
-		
-		for (PoseParticleVector::iterator it = m_params.m_particles.begin(); it != m_params.m_particles.end(); ++it)
-		{
-			/// Runge-Kutta approximation.
-			it->pose.pose.x += (deltaX * a) + (deltaY * b);
-			it->pose.pose.y += (deltaX * c) + (deltaY * d);
-			it->pose.pose.theta = Utils::angNormPiSig(it->pose.pose.theta + deltaTheta);
-		}
-		
 		/// Adding some noise to the estimations because when no targets are detected this leads to increase their deviation standard.
 		for (map<int,pair<ObjectSensorReading::Observation,Point2f> >::iterator it = estimatedTargetModelsWithIdentity.begin(); it != estimatedTargetModelsWithIdentity.end(); ++it)
 		{
@@ -811,13 +952,14 @@ namespace PTracking
 	
 	void ObjectParticleFilter::resample()
 	{
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); ++it)
+		Random random = getRandom(ResamplingStream);
+		
+		for (vector<ClusterRange>::const_iterator it = clusters.begin(); it != clusters.end(); ++it)
 		{
-			vector<int> indexes;
+			/// The weights of the cluster are still well spread, resampling would only lose diversity.
+			if (Resampler::effectiveSampleSize(m_params.m_particles,it->begin,it->end) > (essThreshold * it->size())) continue;
 			
-			indexes.reserve(2 * it->first.size());
-			::resample(indexes,it->first);
-			repeatIndexes(it->first,indexes,it->first);
+			resampler.resample(m_params.m_particles,it->begin,it->end,random);
 		}
 	}
 	
@@ -861,10 +1003,10 @@ namespace PTracking
 		i = 0;
 		
 		/// Removing clusters that do not have a close observation (due to particles' convergence).
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); ++it, ++i)
+		for (vector<ClusterRange>::iterator it = clusters.begin(); it != clusters.end(); ++it, ++i)
 		{
 #ifdef DEBUG_MODE
-			ERR("Analyzing cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+			ERR("Analyzing cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 			
 			minDistance = FLT_MAX;
@@ -873,7 +1015,7 @@ namespace PTracking
 			{
 				const Point2f& o = it2->observation.getCartesian();
 				
-				distance = sqrt(((it->second.x - o.x) * (it->second.x - o.x)) + ((it->second.y - o.y) * (it->second.y - o.y)));
+				distance = sqrt(((it->centroid.x - o.x) * (it->centroid.x - o.x)) + ((it->centroid.y - o.y) * (it->centroid.y - o.y)));
 				
 				if (distance < minDistance)
 				{
@@ -886,7 +1028,7 @@ namespace PTracking
 			if (minDistance < closenessThreshold)
 			{
 #ifdef DEBUG_MODE
-				WARN("Cluster [" << it->second.x << "," << it->second.y << "] associated to observation (" << associatedObservation.x << "," << associatedObservation.y << ")" << endl);
+				WARN("Cluster [" << it->centroid.x << "," << it->centroid.y << "] associated to observation (" << associatedObservation.x << "," << associatedObservation.y << ")" << endl);
 #endif
 			}
 			else
@@ -898,7 +1040,7 @@ namespace PTracking
 				{
 					const Point2f& o = it2->second.first.observation.getCartesian();
 					
-					distance = sqrt(((it->second.x - o.x) * (it->second.x - o.x)) + ((it->second.y - o.y) * (it->second.y - o.y)));
+					distance = sqrt(((it->centroid.x - o.x) * (it->centroid.x - o.x)) + ((it->centroid.y - o.y) * (it->centroid.y - o.y)));
 					
 					if (distance < minDistance)
 					{
@@ -913,7 +1055,7 @@ namespace PTracking
 					const map<int,Timestamp>::iterator& estimationTime = estimationsUpdateTime.find(index);
 					
 #ifdef DEBUG_MODE
-					INFO("Found estimation [" << index << "] close to the cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+					INFO("Found estimation [" << index << "] close to the cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 					
 					if (estimationTime != estimationsUpdateTime.end())
@@ -922,7 +1064,7 @@ namespace PTracking
 						if ((currentTimestamp - estimationTime->second.getMsFromMidnight()) > timeToWaitBeforeDeleting)
 						{
 #ifdef DEBUG_MODE
-							DEBUG("Deleting cluster: [" << it->second.x << "," << it->second.y << "], time = " << (currentTimestamp - estimationTime->second.getMsFromMidnight()) << " ms" << endl);
+							DEBUG("Deleting cluster: [" << it->centroid.x << "," << it->centroid.y << "], time = " << (currentTimestamp - estimationTime->second.getMsFromMidnight()) << " ms" << endl);
 #endif
 							
 							deletingClusters.push_back(i);
@@ -930,7 +1072,7 @@ namespace PTracking
 						else
 						{
 #ifdef DEBUG_MODE
-							WARN("Keeping cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+							WARN("Keeping cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 							
 							/// We consider this estimation as valid since it is close to the pending cluster.
@@ -941,20 +1083,19 @@ namespace PTracking
 							
 							if ((fabs(est.first.model.velocity.x) <= modelLinearVelocity) && (fabs(est.first.model.velocity.y) <= modelLinearVelocity))
 							{
-								const PointWithVelocity& newPose = Utils::estimatedPosition(it->second,est.first.model.velocity,dt);
+								const PointWithVelocity& newPose = Utils::estimatedPosition(it->centroid,est.first.model.velocity,dt);
 								
-								it->second.x = newPose.pose.x;
-								it->second.y = newPose.pose.y;
+								it->centroid.x = newPose.pose.x;
+								it->centroid.y = newPose.pose.y;
 								
-								est.first.observation.rho = sqrt((newPose.pose.x * newPose.pose.x) + (newPose.pose.y * newPose.pose.y));
-								est.first.observation.theta = atan2(newPose.pose.y,newPose.pose.x);
+								est.first.observation.setCartesian(Point2f(newPose.pose.x,newPose.pose.y));
 							}
 						}
 					}
 					else
 					{
 #ifdef DEBUG_MODE
-						INFO("Keeping cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+						INFO("Keeping cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 						
 						/// We consider this estimation as valid since it is close to the pending cluster.
@@ -965,20 +1106,19 @@ namespace PTracking
 						
 						if ((fabs(est.first.model.velocity.x) <= modelLinearVelocity) && (fabs(est.first.model.velocity.y) <= modelLinearVelocity))
 						{
-							const PointWithVelocity& newPose = Utils::estimatedPosition(it->second,est.first.model.velocity,dt);
+							const PointWithVelocity& newPose = Utils::estimatedPosition(it->centroid,est.first.model.velocity,dt);
 							
-							it->second.x = newPose.pose.x;
-							it->second.y = newPose.pose.y;
+							it->centroid.x = newPose.pose.x;
+							it->centroid.y = newPose.pose.y;
 							
-							est.first.observation.rho = sqrt((newPose.pose.x * newPose.pose.x) + (newPose.pose.y * newPose.pose.y));
-							est.first.observation.theta = atan2(newPose.pose.y,newPose.pose.x);
+							est.first.observation.setCartesian(Point2f(newPose.pose.x,newPose.pose.y));
 						}
 					}
 				}
 				else
 				{
 #ifdef DEBUG_MODE
-					WARN("Deleting cluster without observations: [" << it->second.x << "," << it->second.y << "]" << endl);
+					WARN("Deleting cluster without observations: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 					
 					deletingClusters.push_back(i);
@@ -988,10 +1128,10 @@ namespace PTracking
 		
 		clusterIndex = 0;
 		
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); ++it, ++clusterIndex)
+		for (vector<ClusterRange>::iterator it = clusters.begin(); it != clusters.end(); ++it, ++clusterIndex)
 		{
 #ifdef DEBUG_MODE
-			DEBUG("Analyzing cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+			DEBUG("Analyzing cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 			
 			const vector<int>::const_iterator& pendingCluster = find(pendingClusters.begin(),pendingClusters.end(),clusterIndex);
@@ -1000,7 +1140,7 @@ namespace PTracking
 			if (pendingCluster != pendingClusters.end())
 			{
 #ifdef DEBUG_MODE
-				DEBUG("Pending cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+				DEBUG("Pending cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 				
 				continue;
@@ -1012,7 +1152,7 @@ namespace PTracking
 			if (deletingCluster != deletingClusters.end())
 			{
 #ifdef DEBUG_MODE
-				DEBUG("Deleting cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+				DEBUG("Deleting cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 				
 				continue;
@@ -1030,7 +1170,7 @@ namespace PTracking
 				
 				const Point2f& estimation = it2->second.first.observation.getCartesian();
 				
-				distance = sqrt(((it->second.x - estimation.x) * (it->second.x - estimation.x)) + ((it->second.y - estimation.y) * (it->second.y - estimation.y)));
+				distance = sqrt(((it->centroid.x - estimation.x) * (it->centroid.x - estimation.x)) + ((it->centroid.y - estimation.y) * (it->centroid.y - estimation.y)));
 				
 				if (distance < minDistance)
 				{
@@ -1052,7 +1192,7 @@ namespace PTracking
 				const map<int,pair<ObjectSensorReading::Observation,Point2f> >::iterator& estimation = estimatedTargetModelsWithIdentity.find(index);
 				
 #ifdef DEBUG_MODE
-				ERR("Updating estimation (" << index << ") close to cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+				ERR("Updating estimation (" << index << ") close to cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 				
 				found = false;
@@ -1184,11 +1324,10 @@ namespace PTracking
 							}
 						}
 						
-						estimation->second.first.observation.rho = it->second.mod();
-						estimation->second.first.observation.theta = atan2(it->second.y,it->second.x);
+						estimation->second.first.observation.setCartesian(Point2f(it->centroid.x,it->centroid.y));
 						estimation->second.first.head.x = obsMapping->second.first.head.x;
 						estimation->second.first.head.y = obsMapping->second.first.head.y;
-						estimation->second.first.sigma = Utils::calculateSigmaParticles(it->first,it->second);
+						estimation->second.first.sigma = Utils::calculateSigmaParticles(m_params.m_particles,it->begin,it->end,it->centroid);
 						estimation->second.second = estimation->second.first.sigma;
 						
 						model.barycenter = obsMapping->second.first.model.barycenter;
@@ -1199,12 +1338,7 @@ namespace PTracking
 						model.height = (estimation->second.first.model.height * 3 + obsMapping->second.first.model.height) / 4;
 						model.width = (estimation->second.first.model.width * 3 + obsMapping->second.first.model.width) / 4;
 						
-						for (int i = 0; i < ObjectSensorReading::Model::HISTOGRAM_VECTOR_LENGTH; ++i)
-						{
-							model.histograms[0][i] = obsMapping->second.first.model.histograms[0][i];
-							model.histograms[1][i] = obsMapping->second.first.model.histograms[1][i];
-							model.histograms[2][i] = obsMapping->second.first.model.histograms[2][i];
-						}
+						model.histograms = obsMapping->second.first.model.histograms;
 						
 						/// Checking if we were able to calculate the displacement.
 						if ((newMovement.x != FLT_MIN) || multipleObjectsTooCloseEachOther)
@@ -1230,8 +1364,7 @@ namespace PTracking
 								
 								const PointWithVelocity& newPose = Utils::estimatedPosition(estimation->second.first.observation.getCartesian(),instantVelocity,dt);
 								
-								estimation->second.first.observation.rho = sqrt((newPose.pose.x * newPose.pose.x) + (newPose.pose.y * newPose.pose.y));
-								estimation->second.first.observation.theta = atan2(newPose.pose.y,newPose.pose.x);
+								estimation->second.first.observation.setCartesian(Point2f(newPose.pose.x,newPose.pose.y));
 							}
 							else
 							{
@@ -1284,11 +1417,12 @@ namespace PTracking
 						
 						estimation->second.first.model = model;
 						
-						for (vector<pair<ObjectSensorReading::Model,int> >::iterator it2 = targetModels.begin(); it2 != targetModels.end(); ++it2)
+						for (unsigned int i = 0; i < targetModels.size(); ++i)
 						{
-							if (it2->second == estimation->first)
+							if (targetModels.at(i).second == estimation->first)
 							{
-								it2->first = model;
+								targetModels.at(i).first = model;
+								targetHistograms.set(i,model.histograms);
 								
 								break;
 							}
@@ -1312,8 +1446,7 @@ namespace PTracking
 						
 						const PointWithVelocity& newPose = Utils::estimatedPosition(estimation->second.first.observation.getCartesian(),estimation->second.first.model.velocity,dt);
 						
-						estimation->second.first.observation.rho = sqrt((newPose.pose.x * newPose.pose.x) + (newPose.pose.y * newPose.pose.y));
-						estimation->second.first.observation.theta = atan2(newPose.pose.y,newPose.pose.x);
+						estimation->second.first.observation.setCartesian(Point2f(newPose.pose.x,newPose.pose.y));
 					}
 					
 					const map<int,Timestamp>::iterator& estimationTime = estimationsUpdateTime.find(index);
@@ -1326,8 +1459,7 @@ namespace PTracking
 				{
 					const PointWithVelocity& newPose = Utils::estimatedPosition(estimation->second.first.observation.getCartesian(),estimation->second.first.model.velocity,dt);
 					
-					estimation->second.first.observation.rho = sqrt((newPose.pose.x * newPose.pose.x) + (newPose.pose.y * newPose.pose.y));
-					estimation->second.first.observation.theta = atan2(newPose.pose.y,newPose.pose.x);
+					estimation->second.first.observation.setCartesian(Point2f(newPose.pose.x,newPose.pose.y));
 				}
 				
 				estimationsValid.push_back(index);
@@ -1343,7 +1475,7 @@ namespace PTracking
 				{
 					const Point2f& o = it2->observation.getCartesian();
 					
-					distance = sqrt(((it->second.x - o.x) * (it->second.x - o.x)) + ((it->second.y - o.y) * (it->second.y - o.y)));
+					distance = sqrt(((it->centroid.x - o.x) * (it->centroid.x - o.x)) + ((it->centroid.y - o.y) * (it->centroid.y - o.y)));
 					
 					if (distance < minDistance)
 					{
@@ -1356,12 +1488,11 @@ namespace PTracking
 				if (minDistance < closenessThreshold)
 				{
 #ifdef DEBUG_MODE
-					ERR("New estimation [" << it->second.x << "," << it->second.y << "] close to cluster: [" << it->second.x << "," << it->second.y << "]" << endl);
+					ERR("New estimation [" << it->centroid.x << "," << it->centroid.y << "] close to cluster: [" << it->centroid.x << "," << it->centroid.y << "]" << endl);
 #endif
 					
 					ObjectSensorReading::Observation target;
 					ObjectSensorReading::Model model;
-					float minBhattacharyyaDistance;
 					int targetIdentity;
 					
 					/// A new observation has been promoted and it is not contained into the observation mapping.
@@ -1369,34 +1500,14 @@ namespace PTracking
 					
 					model = obs.at(index).model;
 					
-					target.observation = PolarPoint(atan2(it->second.y,it->second.x),it->second.mod());
+					target.observation = PolarPoint(Point2f(it->centroid.x,it->centroid.y));
 					target.head = obs.at(index).head;
-					target.sigma = Utils::calculateSigmaParticles(it->first,it->second);
+					target.sigma = Utils::calculateSigmaParticles(m_params.m_particles,it->begin,it->end,it->centroid);
 					
 					/// Observation used and no longer needed.
 					obs.erase(obs.begin() + index);
 					
-					minBhattacharyyaDistance = FLT_MAX;
-					index = -1;
-					i = 0;
-					
-					for (vector<pair<ObjectSensorReading::Model,int> >::const_iterator it2 = targetModels.begin(); it2 != targetModels.end(); ++it2, ++i)
-					{
-						pair<bool,float> bhattacharyyaComparison = areModelsSimilar(model,it2->first);
-						
-						if (bhattacharyyaComparison.first)
-						{
-							if (bhattacharyyaComparison.second < minBhattacharyyaDistance)
-							{
-								/// Checking if the re-identification was unique. It could happen that two different objects are re-identified with the same model.
-								if (estimatedTargetModelsWithIdentity.find(it2->second) == estimatedTargetModelsWithIdentity.end())
-								{
-									minBhattacharyyaDistance = bhattacharyyaComparison.second;
-									index = i;
-								}
-							}
-						}
-					}
+					index = findMostSimilarModel(model).first;
 					
 					/// An existing model has been found.
 					if (index != -1)
@@ -1404,12 +1515,7 @@ namespace PTracking
 						/// Since the re-identification has been successfully, we can just get the identity and the color histogram since all the other information are no longer valid.
 						target.model = model;
 						
-						for (int i = 0; i < ObjectSensorReading::Model::HISTOGRAM_VECTOR_LENGTH; ++i)
-						{
-							target.model.histograms[0][i] = targetModels.at(index).first.histograms[0][i];
-							target.model.histograms[1][i] = targetModels.at(index).first.histograms[1][i];
-							target.model.histograms[2][i] = targetModels.at(index).first.histograms[2][i];
-						}
+						target.model.histograms = targetModels.at(index).first.histograms;
 						
 						targetIdentity = targetModels.at(index).second;
 						
@@ -1419,6 +1525,7 @@ namespace PTracking
 							targetIdentity = ++maxIdentityNumber;
 							
 							targetModels.push_back(make_pair(target.model,targetIdentity));
+							targetHistograms.add(target.model.histograms);
 						}
 					}
 					else
@@ -1427,6 +1534,7 @@ namespace PTracking
 						targetIdentity = ++maxIdentityNumber;
 						
 						targetModels.push_back(make_pair(target.model,targetIdentity));
+						targetHistograms.add(target.model.histograms);
 					}
 					
 					estimatedTargetModelsWithIdentity.insert(make_pair(targetIdentity,make_pair(target,target.sigma)));
@@ -1440,7 +1548,7 @@ namespace PTracking
 		i = 0;
 		
 		/// Deleting clusters.
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); ++i)
+		for (vector<ClusterRange>::iterator it = clusters.begin(); it != clusters.end(); ++i)
 		{
 			const vector<int>::const_iterator& deletingCluster = find(deletingClusters.begin(),deletingClusters.end(),i);
 			
@@ -1528,8 +1636,7 @@ namespace PTracking
 					{
 						const PointWithVelocity& newPose = Utils::estimatedPosition(it->second.first.observation.getCartesian(),it->second.first.model.velocity,dt);
 						
-						it->second.first.observation.rho = sqrt((newPose.pose.x * newPose.pose.x) + (newPose.pose.y * newPose.pose.y));
-						it->second.first.observation.theta = atan2(newPose.pose.y,newPose.pose.x);
+						it->second.first.observation.setCartesian(Point2f(newPose.pose.x,newPose.pose.y));
 					}
 					
 					++it;
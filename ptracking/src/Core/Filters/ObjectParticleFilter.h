@@ -1,6 +1,10 @@
 #pragma once
 
+#include "AppearanceHistogramBank.h"
 #include "ObjectSensorReading.h"
+#include "Resampler.h"
+#include <Utils/Random.h>
+#include <Utils/ThreadPool.h>
 #include <Utils/Timestamp.h>
 #include <Manfield/filters/particlefilter.h>
 
@@ -21,6 +25,17 @@ namespace PTracking
 	 */
 	class ObjectParticleFilter : public manfield::ParticleFilter
 	{
+		public:
+			/**
+			 * @brief Enumerator representing the streams of random numbers drawn in a step, besides the noise of the prediction.
+			 */
+			enum RandomStream
+			{
+				PromotionStream = 1,
+				ResamplingStream,
+				SamplingStream
+			};
+			
 		private:
 			/**
 			 * @brief map of estimations having both an identity and a model performed by the agent.
@@ -47,6 +62,11 @@ namespace PTracking
 			 */
 			std::vector<std::pair<ObjectSensorReading::Model,int> > targetModels;
 			
+			/**
+			 * @brief bank of the histograms of targetModels (same order), used to compare an observation against all of them at once.
+			 */
+			AppearanceHistogramBank targetHistograms;
+			
 			/**
 			 * @brief vector of pending observations.
 			 */
@@ -62,6 +82,36 @@ namespace PTracking
 			 */
 			Clusterizer* clusterizer;
 			
+			/**
+			 * @brief resampler of the clusters.
+			 */
+			Resampler resampler;
+			
+			/**
+			 * @brief flags of the particles belonging to a cluster, used to normalize the remaining ones.
+			 */
+			std::vector<char> clusteredParticles;
+			
+			/**
+			 * @brief effective sample size, as a fraction of the particles of a cluster, above which the cluster is not resampled (1 resamples at every step).
+			 */
+			float essThreshold;
+			
+			/**
+			 * @brief pool predicting and normalizing the targets concurrently (the serial pool unless parallelTargets is enabled).
+			 */
+			ThreadPool* threadPool;
+			
+			/**
+			 * @brief seed of the noise added to the particles in the prediction step and of the other random numbers drawn by the filter (see getRandom()).
+			 */
+			unsigned int randomSeed;
+			
+			/**
+			 * @brief number of prediction steps performed, used together with randomSeed to seed the noise of every target.
+			 */
+			unsigned long predictions;
+			
 			/**
 			 * @brief timestamp of the last time when the target's number should be decreased.
 			 */
@@ -150,14 +200,13 @@ namespace PTracking
 			void applyGroupTracking();
 			
 			/**
-			 * @brief Function that checks if two models are similar.
+			 * @brief Function that finds the model of the bank most similar to the one of an observation, skipping the ones whose identity is currently estimated.
 			 * 
 			 * @param observationModel reference to the model of the observation.
-			 * @param storedModel reference to a model already present in the bank of models.
 			 * 
-			 * @return \b true if the models are similar, \b false otherwise.
+			 * @return the index in targetModels of the most similar model (-1 if no model is similar enough) and its Bhattacharyya distance.
 			 */
-			std::pair<bool,float> areModelsSimilar(const ObjectSensorReading::Model& observationModel, const ObjectSensorReading::Model& storedModel) const;
+			std::pair<int,float> findMostSimilarModel(const ObjectSensorReading::Model& observationModel) const;
 			
 			/**
 			 * @brief Function that checks whether a re-initialization of the particle filter is needed.
@@ -247,6 +296,15 @@ namespace PTracking
 			 */
 			inline const BasicSensor& getSensor() const { return *static_cast<const BasicSensor*>(ParticleFilter::getSensor()); }
 			
+			/**
+			 * @brief Function that returns a generator depending only on the random seed, on the number of prediction steps performed and on a stream.
+			 * 
+			 * @param stream stream of random numbers, so that the generators of the same step are different.
+			 * 
+			 * @return a generator of the current step.
+			 */
+			inline Random getRandom(RandomStream stream) const { return Random((((uint64_t) randomSeed) << 32) ^ predictions ^ (((uint64_t) stream) * 0xD1B54A32D192ED03ULL)); }
+			
 			/**
 			 * @brief Function that creates the new likelihood distribution using the observations gathered from the agent's sensors.
 			 * 
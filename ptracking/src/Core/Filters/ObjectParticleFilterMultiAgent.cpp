@@ -1,4 +1,5 @@
 #include "ObjectParticleFilterMultiAgent.h"
+#include "../Clusterizer/GridClusterizer/GridClusterizer.h"
 #include "../Clusterizer/KClusterizer/KClusterizer.h"
 #include "../Clusterizer/QTClusterizer/QTClusterizer.h"
 #include "../SensorMaps/BasicSensorMap.h"
@@ -165,6 +166,7 @@ ObjectParticleFilterMultiAgent::ObjectParticleFilterMultiAgent(const string& typ
 		
 		if (strcasecmp(clusteringAlgorithm.c_str(),"KClusterizer") == 0) clusterizer = new KClusterizer(1);
 		else if (strcasecmp(clusteringAlgorithm.c_str(),"QTClusterizer") == 0) clusterizer = new QTClusterizer();
+		else if (strcasecmp(clusteringAlgorithm.c_str(),"GridClusterizer") == 0) clusterizer = new GridClusterizer();
 		
 		Point2f p;
 		ifstream ifs;
@@ -364,8 +366,7 @@ ObjectParticleFilterMultiAgent::ObjectParticleFilterMultiAgent(const string& typ
 				
 				ObjectSensorReading::Observation globalEstimation;
 				
-				globalEstimation.observation.rho = sqrt((globalEstimationX * globalEstimationX) + (globalEstimationY * globalEstimationY));
-				globalEstimation.observation.theta = atan2(globalEstimationY,globalEstimationX);
+				globalEstimation.observation.setCartesian(Point2f(globalEstimationX,globalEstimationY));
 				globalEstimation.head.x = globalEstimationHeadX;
 				globalEstimation.head.y = globalEstimationHeadY;
 				globalEstimation.sigma = Point2f(allSigmaX / estimationsToBeFused.size(), allSigmaY / estimationsToBeFused.size());
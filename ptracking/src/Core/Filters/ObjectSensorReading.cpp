@@ -33,8 +33,7 @@ namespace PTracking
 			{
 				const Point2of& result = Utils::convertRelative2Global(Point2of(x,y,0.0),observationsAgentPose);
 				
-				targetPoints[i].observation.rho = result.mod();
-				targetPoints[i].observation.theta = atan2(result.y,result.x);
+				targetPoints[i].observation.setCartesian(Point2f(result.x,result.y));
 				
 				observations.push_back(targetPoints[i]);
 			}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Sensors/BasicSensor.h"
+#include "AppearanceHistogram.h"
 #include <Utils/Point2of.h>
 #include <Utils/PolarPoint.h>
 #include <ThirdParty/GMapping/sensor/sensor_base/sensorreading.h>
@@ -23,11 +24,6 @@ namespace PTracking
 			 */
 			struct Model
 			{
-				/**
-				 * @brief length of the histogram vector.
-				 */
-				static const int HISTOGRAM_VECTOR_LENGTH = 256;
-				
 				/**
 				 * @brief boundingBox of the observation/estimation.
 				 */
@@ -49,9 +45,9 @@ namespace PTracking
 				int barycenter;
 				
 				/**
-				 * @brief histograms of the observation/estimation.
+				 * @brief histograms of the observation/estimation, shared among the copies of the model.
 				 */
-				float histograms[3][HISTOGRAM_VECTOR_LENGTH];
+				AppearanceHistogram histograms;
 				
 				/**
 				 * @brief averaged velocity of the estimation.
@@ -63,38 +59,7 @@ namespace PTracking
 				 */
 				Point2f velocity;
 				
-				Model() : barycenter(-1)
-				{
-					for (int i = 0; i < ObjectSensorReading::Model::HISTOGRAM_VECTOR_LENGTH; ++i)
-					{
-						histograms[0][i] = 0;
-						histograms[1][i] = 0;
-						histograms[2][i] = 0;
-					}
-				}
-				
-				Model& operator= (const Model& other)
-				{
-					boundingBox = other.boundingBox;
-					width = other.width;
-					height = other.height;
-					barycenter = other.barycenter;
-					
-					for (int i = 0; i < HISTOGRAM_VECTOR_LENGTH; ++i)
-					{
-						histograms[0][i] = other.histograms[0][i];
-						histograms[1][i] = other.histograms[1][i];
-						histograms[2][i] = other.histograms[2][i];
-					}
-					
-					averagedVelocity.x = other.averagedVelocity.x;
-					averagedVelocity.y = other.averagedVelocity.y;
-					
-					velocity.x = other.velocity.x;
-					velocity.y = other.velocity.y;
-					
-					return *this;
-				}
+				Model() : barycenter(-1) {;}
 			};
 			
 			/**
@@ -1,4 +1,5 @@
 #include "ObjectSensorReadingMultiAgent.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -28,4 +29,21 @@ namespace PTracking
 	{
 		sensor = s;
 	}
+	
+	void ObjectSensorReadingMultiAgent::swap(ObjectSensorReadingMultiAgent& other)
+	{
+		std::swap(m_sensor,other.m_sensor);
+		std::swap(m_time,other.m_time);
+		std::swap(observationMultiAgent.port,other.observationMultiAgent.port);
+		std::swap(observationMultiAgent.timestamp,other.observationMultiAgent.timestamp);
+		std::swap(sensor,other.sensor);
+		
+		observationMultiAgent.address.swap(other.observationMultiAgent.address);
+		observationMultiAgent.estimationsWithModels.swap(other.observationMultiAgent.estimationsWithModels);
+	}
+	
+	void ObjectSensorReadingMultiAgent::swapEstimationsWithModels(map<int,pair<ObjectSensorReading::Observation,Point2f> >& estimationsWithModels)
+	{
+		observationMultiAgent.estimationsWithModels.swap(estimationsWithModels);
+	}
 }
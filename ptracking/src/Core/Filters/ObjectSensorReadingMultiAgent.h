@@ -111,6 +111,20 @@ namespace PTracking
 			 */
 			void setSensor(const BasicSensor& s);
 			
+			/**
+			 * @brief Function that exchanges the content of the reading with another one, without copying the estimations.
+			 * 
+			 * @param other reference to the other reading.
+			 */
+			void swap(ObjectSensorReadingMultiAgent& other);
+			
+			/**
+			 * @brief Function that exchanges the estimations performed by the team of agents with the ones given in input, without copying them.
+			 * 
+			 * @param estimationsWithModels reference to the new estimations, it gets the previous ones.
+			 */
+			void swapEstimationsWithModels(std::map<int,std::pair<ObjectSensorReading::Observation,Point2f> >& estimationsWithModels);
+			
 		private:
 			/**
 			 * @brief estimations performed by an agent.
@@ -122,4 +136,12 @@ namespace PTracking
 			 */
 			BasicSensor sensor;
 	};
+	
+	/**
+	 * @brief Function that exchanges the content of two readings, found by argument-dependent lookup (e.g. by SpscQueue).
+	 * 
+	 * @param first reference to the first reading.
+	 * @param second reference to the second reading.
+	 */
+	inline void swap(ObjectSensorReadingMultiAgent& first, ObjectSensorReadingMultiAgent& second) { first.swap(second); }
 }
@@ -0,0 +1,111 @@
+#include "Resampler.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace PTracking
+{
+	Resampler::Resampler(Method method) : method(method) {;}
+	
+	float Resampler::effectiveSampleSize(const PoseParticleVector& particles, int begin, int end)
+	{
+		float sum = 0.0, sumOfSquares = 0.0;
+		
+		for (int i = begin; i < end; ++i)
+		{
+			sum += particles[i].weight;
+			sumOfSquares += particles[i].weight * particles[i].weight;
+		}
+		
+		return (sumOfSquares > 0.0) ? ((sum * sum) / sumOfSquares) : 0.0;
+	}
+	
+	void Resampler::resample(PoseParticleVector& particles, int begin, int end, Random& random)
+	{
+		const int size = end - begin;
+		float total = 0.0;
+		
+		if (size <= 0) return;
+		
+		weights.resize(size);
+		
+		for (int i = 0; i < size; ++i)
+		{
+			weights[i] = particles[begin + i].weight;
+			total += weights[i];
+		}
+		
+		/// Also false for a NaN total.
+		if (!(total > 0.0)) return;
+		
+		counts.assign(size,0);
+		
+		if (method == Residual)
+		{
+			int samples = size;
+			
+			/// Deterministic copies first, then the remaining samples are drawn systematically from the fractional parts.
+			for (int i = 0; i < size; ++i)
+			{
+				const float expected = (weights[i] * size) / total;
+				
+				counts[i] = min((int) expected,samples);
+				samples -= counts[i];
+				weights[i] = expected - counts[i];
+			}
+			
+			total = 0.0;
+			
+			for (int i = 0; i < size; ++i) total += weights[i];
+			
+			if ((samples > 0) && (total > 0.0)) systematic(total,samples,random);
+		}
+		else systematic(total,size,random);
+		
+		/// The extra copies of every particle overwrite, in order, the particles that have not been drawn.
+		int discarded = 0;
+		
+		for (int i = 0; i < size; ++i)
+		{
+			for (int copies = 1; copies < counts[i]; ++copies)
+			{
+				while (counts[discarded] != 0) ++discarded;
+				
+				particles[begin + discarded] = particles[begin + i];
+				
+				/// Not drawn anymore, but filled.
+				counts[discarded] = -1;
+			}
+		}
+	}
+	
+	void Resampler::systematic(float total, int samples, Random& random)
+	{
+		const int size = weights.size();
+		const float interval = total / samples;
+		float cumulative = 0.0, target = interval * random.uniform();
+		int drawn = 0;
+		
+		for (int i = 0; (i < size) && (drawn < samples); ++i)
+		{
+			cumulative += weights[i];
+			
+			while ((drawn < samples) && (target < cumulative))
+			{
+				++counts[i];
+				++drawn;
+				target += interval;
+			}
+		}
+		
+		/// Rounding may leave the last samples beyond the cumulative weight.
+		for (int i = size - 1; (drawn < samples) && (i >= 0); --i)
+		{
+			if (weights[i] > 0.0)
+			{
+				counts[i] += samples - drawn;
+				drawn = samples;
+			}
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Manfield/filters/gmlocalizer/structs.h>
+#include <Utils/Random.h>
+#include <vector>
+
+namespace PTracking
+{
+	/**
+	 * @class Resampler
+	 * 
+	 * @brief Class that resamples a range of particles in place, with the systematic or the residual scheme.
+	 * 
+	 * Both schemes compute the number of copies of every particle in O(n) from the weights. The surviving particles stay where they are and the extra copies
+	 * overwrite the discarded ones, so the particles are gathered in a single pass without any temporary particle vector.
+	 */
+	class Resampler
+	{
+		public:
+			/**
+			 * @brief Enumerator representing the resampling schemes.
+			 */
+			enum Method
+			{
+				Systematic = 0,
+				Residual
+			};
+			
+		private:
+			/**
+			 * @brief weights of the particles being resampled (residual weights for the residual scheme).
+			 */
+			std::vector<float> weights;
+			
+			/**
+			 * @brief number of copies of every particle.
+			 */
+			std::vector<int> counts;
+			
+			/**
+			 * @brief resampling scheme.
+			 */
+			Method method;
+			
+			/**
+			 * @brief Function that draws samples with the systematic scheme, adding the copies of every particle to counts.
+			 * 
+			 * @param total sum of the weights.
+			 * @param samples number of samples to be drawn.
+			 * @param random generator drawing the offset of the samples.
+			 */
+			void systematic(float total, int samples, Random& random);
+			
+		public:
+			/**
+			 * @brief Constructor that takes the resampling scheme as initialization value.
+			 * 
+			 * @param method resampling scheme.
+			 */
+			Resampler(Method method = Systematic);
+			
+			/**
+			 * @brief Function that computes the effective sample size of a range of particles, (sum w)^2 / sum w^2.
+			 * 
+			 * @param particles reference to the vector of particles.
+			 * @param begin index of the first particle of the range.
+			 * @param end index past the last particle of the range.
+			 * 
+			 * @return the effective sample size, between 1 and the number of particles (0 if all the weights are 0).
+			 */
+			static float effectiveSampleSize(const PoseParticleVector& particles, int begin, int end);
+			
+			/**
+			 * @brief Function that returns the resampling scheme.
+			 * 
+			 * @return the resampling scheme.
+			 */
+			inline Method getMethod() const { return method; }
+			
+			/**
+			 * @brief Function that resamples a range of particles in place, keeping their number.
+			 * 
+			 * The order of the particles in the range is not preserved and the weights are copied together with the particles.
+			 * 
+			 * @param particles reference to the vector of particles.
+			 * @param begin index of the first particle of the range.
+			 * @param end index past the last particle of the range.
+			 * @param random generator drawing the samples (the one of the calling thread by default).
+			 */
+			void resample(PoseParticleVector& particles, int begin, int end, Random& random = Random::local());
+			
+			/**
+			 * @brief Function that updates the resampling scheme.
+			 * 
+			 * @param method new resampling scheme.
+			 */
+			inline void setMethod(Method method) { this->method = method; }
+	};
+}
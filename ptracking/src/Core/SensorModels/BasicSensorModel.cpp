@@ -1,14 +1,251 @@
 #include "BasicSensorModel.h"
 #include <Manfield/configfile/configfile.h>
 #include <Manfield/utils/debugutils.h>
+#include <algorithm>
+#include <float.h>
+#include <math.h>
 #include <stdlib.h>
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#	define PTRACKING_LIKELIHOOD_X86 1
+#	include <immintrin.h>
+#endif
+
 using namespace std;
 using namespace GMapping;
 
 namespace PTracking
 {
-	BasicSensorModel::BasicSensorModel(const string& type) : SensorModel(type), linearVelocity(modelLinearVelocity) {;}
+	namespace
+	{
+		/// Computes sum exp(-d / sigmaRho) over the observations closer than sqrt(cutoffSquared) for every particle.
+		typedef void (*LikelihoodsFn)(const float*, const float*, unsigned int, const float*, const float*, unsigned int, float, float, float*);
+		
+		/// 2^t evaluated as 2^n * 2^f, with n = round(t) and a degree 5 polynomial for 2^f, f in [-0.5,0.5]. Zero below 2^-126.
+		inline float fastExp2(float t)
+		{
+			if (t < -126.0f) return 0.0;
+			
+			const int n = (int) floor(t + 0.5f);
+			const float f = t - n;
+			float p;
+			
+			p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f + f * (0.00961812911f + f * 0.00133335581f))));
+			
+			union { float value; int bits; } scale;
+			
+			scale.bits = (n + 127) << 23;
+			
+			return p * scale.value;
+		}
+		
+		void likelihoodsExact(const float* x, const float* y, unsigned int numParticles, const float* observationsX, const float* observationsY, unsigned int numObservations, float sigmaRho, float cutoffSquared, float* likelihoods)
+		{
+			for (unsigned int i = 0; i < numParticles; ++i)
+			{
+				float l = 0.0;
+				
+				for (unsigned int j = 0; j < numObservations; ++j)
+				{
+					const float squaredDistance = ((x[i] - observationsX[j]) * (x[i] - observationsX[j])) + ((y[i] - observationsY[j]) * (y[i] - observationsY[j]));
+					
+					if (squaredDistance <= cutoffSquared) l += exp(-sqrt(squaredDistance) / sigmaRho);
+				}
+				
+				likelihoods[i] = l;
+			}
+		}
+		
+		/// exp(-d / sigmaRho) = 2^t, t = -d * scale, with scale = log2(e) / sigmaRho.
+		void likelihoodsScalar(const float* x, const float* y, unsigned int numParticles, const float* observationsX, const float* observationsY, unsigned int numObservations, float sigmaRho, float cutoffSquared, float* likelihoods)
+		{
+			const float scale = M_LOG2E / sigmaRho;
+			
+			for (unsigned int i = 0; i < numParticles; ++i)
+			{
+				float l = 0.0;
+				
+				for (unsigned int j = 0; j < numObservations; ++j)
+				{
+					const float dx = x[i] - observationsX[j], dy = y[i] - observationsY[j];
+					const float squaredDistance = (dx * dx) + (dy * dy);
+					
+					if (squaredDistance <= cutoffSquared) l += fastExp2(-sqrt(squaredDistance) * scale);
+				}
+				
+				likelihoods[i] = l;
+			}
+		}
+		
+#ifdef PTRACKING_LIKELIHOOD_X86
+		__attribute__((target("sse2")))
+		inline __m128 fastExp2SSE2(__m128 t)
+		{
+			const __m128 underflow = _mm_cmplt_ps(t,_mm_set1_ps(-126.0f));
+			const __m128i n = _mm_cvtps_epi32(_mm_max_ps(t,_mm_set1_ps(-126.0f)));
+			const __m128 f = _mm_sub_ps(t,_mm_cvtepi32_ps(n));
+			__m128 p;
+			
+			p = _mm_add_ps(_mm_set1_ps(0.00961812911f),_mm_mul_ps(f,_mm_set1_ps(0.00133335581f)));
+			p = _mm_add_ps(_mm_set1_ps(0.0555041087f),_mm_mul_ps(f,p));
+			p = _mm_add_ps(_mm_set1_ps(0.240226507f),_mm_mul_ps(f,p));
+			p = _mm_add_ps(_mm_set1_ps(0.693147181f),_mm_mul_ps(f,p));
+			p = _mm_add_ps(_mm_set1_ps(1.0f),_mm_mul_ps(f,p));
+			p = _mm_mul_ps(p,_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n,_mm_set1_epi32(127)),23)));
+			
+			return _mm_andnot_ps(underflow,p);
+		}
+		
+		__attribute__((target("sse2")))
+		void likelihoodsSSE2(const float* x, const float* y, unsigned int numParticles, const float* observationsX, const float* observationsY, unsigned int numObservations, float sigmaRho, float cutoffSquared, float* likelihoods)
+		{
+			const __m128 negativeScale = _mm_set1_ps(-M_LOG2E / sigmaRho), cutoff = _mm_set1_ps(cutoffSquared);
+			unsigned int i = 0;
+			
+			for (; i + 4 <= numParticles; i += 4)
+			{
+				const __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i);
+				__m128 l = _mm_setzero_ps();
+				
+				for (unsigned int j = 0; j < numObservations; ++j)
+				{
+					const __m128 dx = _mm_sub_ps(px,_mm_set1_ps(observationsX[j]));
+					const __m128 dy = _mm_sub_ps(py,_mm_set1_ps(observationsY[j]));
+					
+					const __m128 squaredDistance = _mm_add_ps(_mm_mul_ps(dx,dx),_mm_mul_ps(dy,dy));
+					
+					l = _mm_add_ps(l,_mm_and_ps(_mm_cmple_ps(squaredDistance,cutoff),fastExp2SSE2(_mm_mul_ps(_mm_sqrt_ps(squaredDistance),negativeScale))));
+				}
+				
+				_mm_storeu_ps(likelihoods + i,l);
+			}
+			
+			likelihoodsScalar(x + i,y + i,numParticles - i,observationsX,observationsY,numObservations,sigmaRho,cutoffSquared,likelihoods + i);
+		}
+		
+		__attribute__((target("avx2,fma")))
+		inline __m256 fastExp2AVX2(__m256 t)
+		{
+			const __m256 underflow = _mm256_cmp_ps(t,_mm256_set1_ps(-126.0f),_CMP_LT_OQ);
+			const __m256i n = _mm256_cvtps_epi32(_mm256_max_ps(t,_mm256_set1_ps(-126.0f)));
+			const __m256 f = _mm256_sub_ps(t,_mm256_cvtepi32_ps(n));
+			__m256 p;
+			
+			p = _mm256_fmadd_ps(f,_mm256_set1_ps(0.00133335581f),_mm256_set1_ps(0.00961812911f));
+			p = _mm256_fmadd_ps(f,p,_mm256_set1_ps(0.0555041087f));
+			p = _mm256_fmadd_ps(f,p,_mm256_set1_ps(0.240226507f));
+			p = _mm256_fmadd_ps(f,p,_mm256_set1_ps(0.693147181f));
+			p = _mm256_fmadd_ps(f,p,_mm256_set1_ps(1.0f));
+			p = _mm256_mul_ps(p,_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n,_mm256_set1_epi32(127)),23)));
+			
+			return _mm256_andnot_ps(underflow,p);
+		}
+		
+		__attribute__((target("avx2,fma")))
+		void likelihoodsAVX2(const float* x, const float* y, unsigned int numParticles, const float* observationsX, const float* observationsY, unsigned int numObservations, float sigmaRho, float cutoffSquared, float* likelihoods)
+		{
+			const __m256 negativeScale = _mm256_set1_ps(-M_LOG2E / sigmaRho), cutoff = _mm256_set1_ps(cutoffSquared);
+			unsigned int i = 0;
+			
+			for (; i + 8 <= numParticles; i += 8)
+			{
+				const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+				__m256 l = _mm256_setzero_ps();
+				
+				for (unsigned int j = 0; j < numObservations; ++j)
+				{
+					const __m256 dx = _mm256_sub_ps(px,_mm256_set1_ps(observationsX[j]));
+					const __m256 dy = _mm256_sub_ps(py,_mm256_set1_ps(observationsY[j]));
+					
+					const __m256 squaredDistance = _mm256_fmadd_ps(dx,dx,_mm256_mul_ps(dy,dy));
+					
+					l = _mm256_add_ps(l,_mm256_and_ps(_mm256_cmp_ps(squaredDistance,cutoff,_CMP_LE_OQ),fastExp2AVX2(_mm256_mul_ps(_mm256_sqrt_ps(squaredDistance),negativeScale))));
+				}
+				
+				_mm256_storeu_ps(likelihoods + i,l);
+			}
+			
+			likelihoodsScalar(x + i,y + i,numParticles - i,observationsX,observationsY,numObservations,sigmaRho,cutoffSquared,likelihoods + i);
+		}
+#endif
+		
+		LikelihoodsFn selectLikelihoods()
+		{
+#ifdef PTRACKING_LIKELIHOOD_X86
+			__builtin_cpu_init();
+			
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return likelihoodsAVX2;
+			else if (__builtin_cpu_supports("sse2")) return likelihoodsSSE2;
+#endif
+			
+			return likelihoodsScalar;
+		}
+		
+		LikelihoodsFn likelihoodsFunction(bool fast)
+		{
+			static const LikelihoodsFn fastLikelihoods = selectLikelihoods();
+			
+			return fast ? fastLikelihoods : likelihoodsExact;
+		}
+		
+		/// Particles weighted by every task, a multiple of the SIMD width so that the split does not change the results.
+		const unsigned int LIKELIHOOD_CHUNK = 512;
+		
+		struct LikelihoodsTask
+		{
+			LikelihoodsFn evaluate;
+			const float* x;
+			const float* y;
+			unsigned int numParticles;
+			const float* observationsX;
+			const float* observationsY;
+			unsigned int numObservations;
+			float sigmaRho;
+			float cutoffSquared;
+			float* likelihoods;
+		};
+		
+		void evaluateChunk(void* context, unsigned int index)
+		{
+			const LikelihoodsTask& task = *static_cast<const LikelihoodsTask*>(context);
+			const unsigned int begin = index * LIKELIHOOD_CHUNK;
+			const unsigned int size = min(LIKELIHOOD_CHUNK,task.numParticles - begin);
+			
+			task.evaluate(task.x + begin,task.y + begin,size,task.observationsX,task.observationsY,task.numObservations,task.sigmaRho,task.cutoffSquared,task.likelihoods + begin);
+		}
+		
+		/// Particles sorted by cell, every task evaluates an occupied cell against the observations gathered around it.
+		struct GatedLikelihoodsTask
+		{
+			LikelihoodsFn evaluate;
+			const int* cells;
+			const int* particleStarts;
+			const float* x;
+			const float* y;
+			const int* candidateStarts;
+			const float* candidatesX;
+			const float* candidatesY;
+			float sigmaRho;
+			float cutoffSquared;
+			float* likelihoods;
+		};
+		
+		void evaluateCell(void* context, unsigned int index)
+		{
+			const GatedLikelihoodsTask& task = *static_cast<const GatedLikelihoodsTask*>(context);
+			const int cell = task.cells[index];
+			const int begin = task.particleStarts[cell], end = task.particleStarts[cell + 1];
+			const int first = task.candidateStarts[index], last = task.candidateStarts[index + 1];
+			
+			if (first == last) fill(task.likelihoods + begin,task.likelihoods + end,0.0f);
+			else
+			{
+				task.evaluate(task.x + begin,task.y + begin,end - begin,task.candidatesX + first,task.candidatesY + first,last - first,task.sigmaRho,task.cutoffSquared,task.likelihoods + begin);
+			}
+		}
+	}
+	
+	BasicSensorModel::BasicSensorModel(const string& type) : SensorModel(type), linearVelocity(modelLinearVelocity), fastLikelihood(true), likelihoodCutoff(0.0), threadPool(&ThreadPool::serial()) {;}
 	
 	BasicSensorModel::~BasicSensorModel() {;}
 	
@@ -43,6 +280,12 @@ namespace PTracking
 			
 			key = "sigmaTheta";
 			sigmaTheta = fCfg.value(section,key);
+			
+			key = "fastLikelihood";
+			fastLikelihood = fCfg.value(section,key);
+			
+			key = "likelihoodCutoff";
+			likelihoodCutoff = fCfg.value(section,key);
 		}
 		catch (...)
 		{
@@ -62,11 +305,117 @@ namespace PTracking
 		
 		if (map == 0) return;
 		
-		for (PoseParticleVector::iterator i = particlesBegin; i != particlesEnd; i++)
+		const LikelihoodsFn evaluate = likelihoodsFunction(fastLikelihood);
+		const vector<ObjectSensorReading::Observation>& observations = osr->getObservations();
+		const unsigned int numParticles = particlesEnd - particlesBegin;
+		
+		if (numParticles == 0) return;
+		
+		/// Cartesian coordinates of the observations computed once for all the particles.
+		observationsX.resize(observations.size());
+		observationsY.resize(observations.size());
+		
+		for (unsigned int j = 0; j < observations.size(); ++j)
+		{
+			const Point2f observation = observations.at(j).observation.getCartesian();
+			
+			observationsX[j] = observation.x;
+			observationsY[j] = observation.y;
+		}
+		
+		particlesX.resize(numParticles);
+		particlesY.resize(numParticles);
+		likelihoods.resize(numParticles);
+		
+		PoseParticleVector::iterator particle = particlesBegin;
+		
+		for (unsigned int i = 0; i < numParticles; ++i, ++particle)
+		{
+			particlesX[i] = particle->pose.pose.x;
+			particlesY[i] = particle->pose.pose.y;
+		}
+		
+		if ((likelihoodCutoff > 0.0) && !observations.empty()) gatedLikelihoods(evaluate);
+		else
+		{
+			LikelihoodsTask task = { evaluate, &particlesX[0], &particlesY[0], numParticles, observations.empty() ? 0 : &observationsX[0], observations.empty() ? 0 : &observationsY[0],
+									 (unsigned int) observations.size(), sigmaRho, FLT_MAX, &likelihoods[0] };
+			
+			threadPool->run((numParticles + LIKELIHOOD_CHUNK - 1) / LIKELIHOOD_CHUNK,evaluateChunk,&task);
+		}
+		
+		particle = particlesBegin;
+		
+		for (unsigned int i = 0; i < numParticles; ++i, ++particle)
 		{
 			// We assume that the weight is resetted at the beginning of the new iteration.
-			i->weight *= likelihood(map,i->pose,osr->getObservations());
+			if (map->isInsideWorld(particlesX[i],particlesY[i])) particle->weight *= likelihoods[i];
+			else particle->weight = 0.0;
+		}
+	}
+	
+	void BasicSensorModel::gatedLikelihoods(void (*evaluate)(const float*, const float*, unsigned int, const float*, const float*, unsigned int, float, float, float*)) const
+	{
+		const unsigned int numParticles = particlesX.size();
+		
+		observationGrid.build(&observationsX[0],&observationsY[0],observationsX.size(),likelihoodCutoff);
+		
+		/// Counting sort of the particles by cell, the ones outside the grid are too far from every observation.
+		particleCells.resize(numParticles);
+		particleStarts.assign(observationGrid.getCellNumber() + 1,0);
+		
+		for (unsigned int i = 0; i < numParticles; ++i)
+		{
+			particleCells[i] = observationGrid.cell(particlesX[i],particlesY[i]);
+			
+			if (particleCells[i] == -1) likelihoods[i] = 0.0;
+			else ++particleStarts[particleCells[i] + 1];
 		}
+		
+		for (int i = 0; i < observationGrid.getCellNumber(); ++i) particleStarts[i + 1] += particleStarts[i];
+		
+		particleOrder.resize(particleStarts.back());
+		
+		vector<int> next(particleStarts.begin(),particleStarts.end() - 1);
+		
+		for (unsigned int i = 0; i < numParticles; ++i)
+		{
+			if (particleCells[i] != -1) particleOrder[next[particleCells[i]]++] = i;
+		}
+		
+		/// The observations around every occupied cell are gathered once, so that the cells can be evaluated in parallel.
+		occupiedCells.clear();
+		candidateStarts.assign(1,0);
+		candidatesX.clear();
+		candidatesY.clear();
+		
+		for (int cell = 0; cell < observationGrid.getCellNumber(); ++cell)
+		{
+			if (particleStarts[cell] == particleStarts[cell + 1]) continue;
+			
+			occupiedCells.push_back(cell);
+			observationGrid.neighbours(cell,candidatesX,candidatesY);
+			candidateStarts.push_back(candidatesX.size());
+		}
+		
+		if (occupiedCells.empty()) return;
+		
+		groupX.resize(particleOrder.size());
+		groupY.resize(particleOrder.size());
+		groupLikelihoods.resize(particleOrder.size());
+		
+		for (unsigned int i = 0; i < particleOrder.size(); ++i)
+		{
+			groupX[i] = particlesX[particleOrder[i]];
+			groupY[i] = particlesY[particleOrder[i]];
+		}
+		
+		GatedLikelihoodsTask task = { evaluate, &occupiedCells[0], &particleStarts[0], &groupX[0], &groupY[0], &candidateStarts[0], candidatesX.empty() ? 0 : &candidatesX[0],
+									  candidatesY.empty() ? 0 : &candidatesY[0], sigmaRho, likelihoodCutoff * likelihoodCutoff, &groupLikelihoods[0] };
+		
+		threadPool->run(occupiedCells.size(),evaluateCell,&task);
+		
+		for (unsigned int i = 0; i < particleOrder.size(); ++i) likelihoods[particleOrder[i]] = groupLikelihoods[i];
 	}
 	
 	float BasicSensorModel::likelihood(BasicSensorMap* map, PointWithVelocity& pose, const vector<ObjectSensorReading::Observation>& observations) const
@@ -79,8 +428,9 @@ namespace PTracking
 		
 		for (vector<ObjectSensorReading::Observation>::const_iterator it = observations.begin(); it != observations.end(); it++)
 		{
-			deltaRho = sqrt(((pose.pose.x - it->observation.getCartesian().x) * (pose.pose.x - it->observation.getCartesian().x)) +
-							((pose.pose.y - it->observation.getCartesian().y) * (pose.pose.y - it->observation.getCartesian().y)));
+			const Point2f observation = it->observation.getCartesian();
+			
+			deltaRho = sqrt(((pose.pose.x - observation.x) * (pose.pose.x - observation.x)) + ((pose.pose.y - observation.y) * (pose.pose.y - observation.y)));
 			
 			l += exp(-deltaRho / sigmaRho);
 		}
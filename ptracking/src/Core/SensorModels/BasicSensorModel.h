@@ -2,8 +2,10 @@
 
 #include "../Filters/ObjectSensorReading.h"
 #include "../SensorMaps/BasicSensorMap.h"
+#include "ObservationGrid.h"
 #include <Utils/Point2of.h>
 #include <Utils/PolarPoint.h>
+#include <Utils/ThreadPool.h>
 
 namespace PTracking
 {
@@ -35,6 +37,58 @@ namespace PTracking
 			 */
 			float linearVelocity;
 			
+			/**
+			 * @brief if true, the likelihood is computed with SIMD and an approximated exponential (relative error below 1e-5), otherwise with the exact math functions.
+			 */
+			bool fastLikelihood;
+			
+			/**
+			 * @brief if greater than 0, every particle is weighted only with the observations closer than this radius (searched in the grid cells around it).
+			 */
+			float likelihoodCutoff;
+			
+			/**
+			 * @brief pool evaluating the likelihood of the particles in chunks, or by grid cell when gated (the serial pool by default).
+			 */
+			ThreadPool* threadPool;
+			
+			/**
+			 * @brief cartesian coordinates of the current observations (structure of arrays).
+			 */
+			mutable std::vector<float> observationsX, observationsY;
+			
+			/**
+			 * @brief coordinates and likelihood of the particles being weighted (structure of arrays).
+			 */
+			mutable std::vector<float> particlesX, particlesY, likelihoods;
+			
+			/**
+			 * @brief grid over the current observations, used when likelihoodCutoff is greater than 0.
+			 */
+			mutable ObservationGrid observationGrid;
+			
+			/**
+			 * @brief cell of every particle, and the particles sorted by cell with the first index of every cell.
+			 */
+			mutable std::vector<int> particleCells, particleOrder, particleStarts;
+			
+			/**
+			 * @brief cells containing at least one particle, and the first index of the observations around each of them.
+			 */
+			mutable std::vector<int> occupiedCells, candidateStarts;
+			
+			/**
+			 * @brief observations around the occupied cells, and coordinates and likelihood of the particles sorted by cell.
+			 */
+			mutable std::vector<float> candidatesX, candidatesY, groupX, groupY, groupLikelihoods;
+			
+			/**
+			 * @brief Function that computes the likelihood of the particles, evaluating every grid cell (in parallel on the pool) against the observations of the cells around it.
+			 * 
+			 * @param evaluate function computing the likelihood of a batch of particles given a set of observations.
+			 */
+			void gatedLikelihoods(void (*evaluate)(const float*, const float*, unsigned int, const float*, const float*, unsigned int, float, float, float*)) const;
+			
 		public:
 			/**
 			 * @brief Constructor that takes the sensor model type as initialization value.
@@ -86,6 +140,15 @@ namespace PTracking
 			 */
 			virtual float likelihood(BasicSensorMap* map, PointWithVelocity& pose, const std::vector<ObjectSensorReading::Observation>& observations) const;
 			
+			/**
+			 * @brief Function that updates the pool used to evaluate the likelihood of the particles.
+			 * 
+			 * The particles are split in chunks of fixed size (or by grid cell when gated), hence the weights do not depend on the number of threads.
+			 * 
+			 * @param threadPool reference to the new pool.
+			 */
+			inline void setThreadPool(ThreadPool& threadPool) { this->threadPool = &threadPool; }
+			
 			/**
 			 * @brief Macro that defines the default clone function.
 			 */
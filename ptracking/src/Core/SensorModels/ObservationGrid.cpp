@@ -0,0 +1,84 @@
+#include "ObservationGrid.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+namespace PTracking
+{
+	ObservationGrid::ObservationGrid() : originX(0.0), originY(0.0), cellSize(1.0), columns(0), rows(0) {;}
+	
+	void ObservationGrid::build(const float* x, const float* y, unsigned int numObservations, float cutoff)
+	{
+		columns = rows = 0;
+		
+		observationsX.resize(numObservations);
+		observationsY.resize(numObservations);
+		
+		if (numObservations == 0) return;
+		
+		float minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+		
+		for (unsigned int i = 1; i < numObservations; ++i)
+		{
+			minX = min(minX,x[i]);
+			maxX = max(maxX,x[i]);
+			minY = min(minY,y[i]);
+			maxY = max(maxY,y[i]);
+		}
+		
+		/// One empty ring of cells around the observations, so that every point closer than the cutoff falls inside the grid.
+		cellSize = max(cutoff,max(maxX - minX,maxY - minY) / (sqrt((float) MAX_CELLS) - 3));
+		originX = minX - cellSize;
+		originY = minY - cellSize;
+		columns = ((int) ((maxX - minX) / cellSize)) + 3;
+		rows = ((int) ((maxY - minY) / cellSize)) + 3;
+		
+		/// Counting sort of the observations by cell.
+		cellStarts.assign(columns * rows + 1,0);
+		observationCells.resize(numObservations);
+		
+		for (unsigned int i = 0; i < numObservations; ++i)
+		{
+			observationCells[i] = cell(x[i],y[i]);
+			
+			++cellStarts[observationCells[i] + 1];
+		}
+		
+		for (int i = 0; i < columns * rows; ++i) cellStarts[i + 1] += cellStarts[i];
+		
+		vector<int> next(cellStarts.begin(),cellStarts.end() - 1);
+		
+		for (unsigned int i = 0; i < numObservations; ++i)
+		{
+			const int index = next[observationCells[i]]++;
+			
+			observationsX[index] = x[i];
+			observationsY[index] = y[i];
+		}
+	}
+	
+	int ObservationGrid::cell(float x, float y) const
+	{
+		const float column = floor((x - originX) / cellSize), row = floor((y - originY) / cellSize);
+		
+		if ((column < 0) || (column >= columns) || (row < 0) || (row >= rows)) return -1;
+		
+		return (((int) row) * columns) + ((int) column);
+	}
+	
+	void ObservationGrid::neighbours(int cell, vector<float>& x, vector<float>& y) const
+	{
+		const int column = cell % columns, row = cell / columns;
+		const int firstColumn = max(column - 1,0), lastColumn = min(column + 1,columns - 1);
+		
+		/// The cells of a row are contiguous, hence so are their observations.
+		for (int r = max(row - 1,0); r <= min(row + 1,rows - 1); ++r)
+		{
+			const int begin = cellStarts[(r * columns) + firstColumn], end = cellStarts[(r * columns) + lastColumn + 1];
+			
+			x.insert(x.end(),observationsX.begin() + begin,observationsX.begin() + end);
+			y.insert(y.end(),observationsY.begin() + begin,observationsY.begin() + end);
+		}
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+
+namespace PTracking
+{
+	/**
+	 * @class ObservationGrid
+	 * 
+	 * @brief Class that implements a uniform grid over the cartesian positions of a set of observations.
+	 * 
+	 * The cells are at least as large as the cutoff radius, so the 3x3 cells around a point contain all the observations closer than the cutoff.
+	 */
+	class ObservationGrid
+	{
+		private:
+			/**
+			 * @brief maximum number of cells of the grid (the cells are enlarged when the observations are too sparse).
+			 */
+			static const int MAX_CELLS = 65536;
+			
+			/**
+			 * @brief cartesian coordinates of the observations, sorted by cell in row-major order.
+			 */
+			std::vector<float> observationsX, observationsY;
+			
+			/**
+			 * @brief index of the first observation of every cell, plus the total number of observations.
+			 */
+			std::vector<int> cellStarts;
+			
+			/**
+			 * @brief cell of every observation given to build().
+			 */
+			std::vector<int> observationCells;
+			
+			/**
+			 * @brief coordinates of the bottom-left corner of the grid.
+			 */
+			float originX, originY;
+			
+			/**
+			 * @brief side of the cells.
+			 */
+			float cellSize;
+			
+			/**
+			 * @brief size of the grid.
+			 */
+			int columns, rows;
+			
+		public:
+			/**
+			 * @brief Empty constructor.
+			 */
+			ObservationGrid();
+			
+			/**
+			 * @brief Function that builds the grid.
+			 * 
+			 * @param x ordinates of the observations.
+			 * @param y abscissae of the observations.
+			 * @param numObservations number of observations.
+			 * @param cutoff cutoff radius (greater than 0).
+			 */
+			void build(const float* x, const float* y, unsigned int numObservations, float cutoff);
+			
+			/**
+			 * @brief Function that returns the cell containing a point.
+			 * 
+			 * @param x ordinate of the point.
+			 * @param y abscissa of the point.
+			 * 
+			 * @return the index of the cell, -1 if the point is farther than the cutoff from all the observations.
+			 */
+			int cell(float x, float y) const;
+			
+			/**
+			 * @brief Function that returns the number of cells of the grid.
+			 * 
+			 * @return the number of cells of the grid.
+			 */
+			inline int getCellNumber() const { return columns * rows; }
+			
+			/**
+			 * @brief Function that appends the observations of the 3x3 cells around a cell.
+			 * 
+			 * @param cell index of the cell.
+			 * @param x ordinates to which the gathered observations are appended.
+			 * @param y abscissae to which the gathered observations are appended.
+			 */
+			void neighbours(int cell, std::vector<float>& x, std::vector<float>& y) const;
+	};
+}
@@ -1 +1,18 @@
 #include <Manfield/filters/gmlocalizer/structs.h>
+#include <iostream>
+#include <string.h>
+
+using namespace std;
+
+LocalizerParameters::PoseType LocalizerParameters::string2PoseType(const char* name)
+{
+	if ((strcmp(name,"Best") == 0) || (strcmp(name,"best") == 0)) return Best;
+	else if ((strcmp(name,"Mean") == 0) || (strcmp(name,"mean") == 0)) return Mean;
+	else if ((strcmp(name,"RobustMean") == 0) || (strcmp(name,"robustmean") == 0)) return RobustMean;
+	else
+	{
+		cerr << "Implausible value for PoseType [" << name << "], returning Best" << endl;
+		
+		return Best;
+	}
+}
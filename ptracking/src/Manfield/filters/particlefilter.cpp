@@ -6,6 +6,7 @@
 
 using namespace std;
 using GMapping::ConfigFile;
+using PTracking::ClusterRange;
 using PTracking::Point2f;
 using PTracking::Point2of;
 using PTracking::PolarPoint;
@@ -103,7 +104,7 @@ namespace manfield
 		
 		try
 		{
-			m_params.setposeType(LocalizerParameters::string2PoseType(fCfg.value(section,key)));
+			m_params.setposeType(LocalizerParameters::string2PoseType(string(fCfg.value(section,key)).c_str()));
 		}
 		catch (...)
 		{
@@ -243,7 +244,7 @@ namespace manfield
 		initFromMap(*m_sensorModel);
 	}
 	
-	void ParticleFilter::setClusters(vector<pair<PoseParticleVector,Point2of> >& c)
+	void ParticleFilter::setClusters(const vector<ClusterRange>& c)
 	{
 		clusters = c;
 	}
@@ -259,7 +260,7 @@ namespace manfield
 		unsigned int size;
 		bool inserted;
 		
-		for (vector<pair<PoseParticleVector,Point2of> >::iterator it = clusters.begin(); it != clusters.end(); it++)
+		for (vector<ClusterRange>::const_iterator it = clusters.begin(); it != clusters.end(); it++)
 		{
 			inserted = false;
 			
@@ -282,11 +283,11 @@ namespace manfield
 					mean.x /= size;
 					mean.y /= size;
 					
-					if (Utils::isTargetNear((*it).second,mean,distance))
+					if (Utils::isTargetNear((*it).centroid,mean,distance))
 					{
 						PairPriorityBuffer pairBuffer;
 						
-						pairBuffer.estimatedTarget = (*it).second;
+						pairBuffer.estimatedTarget = (*it).centroid;
 						pairBuffer.weight = currentTimestamp;
 						
 						(*it2)->push(pairBuffer);
@@ -304,7 +305,7 @@ namespace manfield
 				
 				buffer = new PriorityBuffer<PairPriorityBuffer>(MAX_ELEMENTS_PRIORITY_BUFFER);
 				
-				pairBuffer.estimatedTarget = (*it).second;
+				pairBuffer.estimatedTarget = (*it).centroid;
 				pairBuffer.weight = currentTimestamp;
 				
 				buffer->push(pairBuffer);
@@ -2,6 +2,7 @@
 
 #include <Manfield/filters/gmlocalizer/localizer.h>
 #include <Manfield/sensorfilter.h>
+#include <Core/Clusterizer/Clusterizer.h>
 #include <Core/Filters/ObjectSensorReading.h>
 #include <Utils/Point2f.h>
 #include <Utils/Point2of.h>
@@ -25,7 +26,7 @@ namespace manfield
 				PairPriorityBuffer() : weight(0) {;}
 			};
 			
-			std::vector<std::pair<PoseParticleVector,PTracking::Point2of> > clusters;
+			std::vector<PTracking::ClusterRange> clusters;
 			std::list<PTracking::PriorityBuffer<PairPriorityBuffer>*> historyEstimatedTargets;
 			
 			float m_time_last_update;
@@ -44,7 +45,7 @@ namespace manfield
 			void checkHistoryEstimatedTargetForCleaning(unsigned long,unsigned long);
 			virtual void configure(const std::string&);
 			std::vector<PTracking::PolarPoint> findTrajectoriesEstimatedTargets(PTracking::Point2of,unsigned long,unsigned long,float);
-			std::vector<std::pair<PoseParticleVector,PTracking::Point2of> >& getClusters() { return clusters; }
+			std::vector<PTracking::ClusterRange>& getClusters() { return clusters; }
 			SensorModel* getSensorModel() { return m_sensorModel; }
 			float getTimeOfLastUpdate() { return m_time_last_update; }
 			virtual void initFromReadings(const std::vector<GMapping::SensorReading*>&);
@@ -59,7 +60,7 @@ namespace manfield
 			
 			virtual void predict(const PTracking::PointWithVelocity&, const PTracking::PointWithVelocity&) {;}
 			
-			void setClusters(std::vector<std::pair<PoseParticleVector,PTracking::Point2of> >&);
+			void setClusters(const std::vector<PTracking::ClusterRange>&);
 			void setParticles(PoseParticleVector);
 			void updateHistoryEstimatedTargets(unsigned long,float);
 			
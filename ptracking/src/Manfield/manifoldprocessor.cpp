@@ -1,6 +1,7 @@
 #include "manifoldprocessor.h"
 #include <ext/functional>
 #include <algorithm>
+#include <iostream>
 
 using namespace std;
 using PTracking::PointWithVelocity;
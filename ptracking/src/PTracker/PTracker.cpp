@@ -1,6 +1,5 @@
 #include "PTracker.h"
 #include <Core/Sensors/BasicSensor.h>
-#include <Utils/UdpSocket.h>
 #include <Manfield/configfile/configfile.h>
 #include <libxml/xmlreader.h>
 #include <sys/stat.h>
@@ -32,29 +31,38 @@ using namespace std;
 using namespace PTracking;
 using GMapping::ConfigFile;
 
-PTracker::PTracker() : agentId(-1)
+PTracker::PTracker() : agentReadings(AGENT_READINGS_QUEUE_SIZE), agentId(-1)
 {
 	signal(SIGINT,PTracker::interruptCallback);
 	
 	init();
-	
-	pthread_t waitAgentMessagesThreadId;
-	
-	pthread_create(&waitAgentMessagesThreadId,0,(void*(*)(void*)) waitAgentMessagesThread,this);
+	startReceiver(0);
 }
 
-PTracker::PTracker(int agentId, const string& filename) : agentId(agentId)
+PTracker::PTracker(int agentId, const string& filename, Reactor* reactor) : agentReadings(AGENT_READINGS_QUEUE_SIZE), agentId(agentId)
 {
-	signal(SIGINT,PTracker::interruptCallback);
+	/// The owner of the reactor handles the shutdown.
+	if (reactor == 0) signal(SIGINT,PTracker::interruptCallback);
 	
 	init(filename);
-	
-	pthread_t waitAgentMessagesThreadId;
-	
-	pthread_create(&waitAgentMessagesThreadId,0,(void*(*)(void*)) waitAgentMessagesThread,this);
+	startReceiver(reactor);
 }
 
-PTracker::~PTracker() {;}
+PTracker::~PTracker()
+{
+	/// A playback on a borrowed reactor is still running if the owner stopped the reactor before the observations were over.
+	finishPlayback();
+	
+	if (reactorOwned)
+	{
+		reactor->stop();
+		
+		pthread_join(reactorThread,0);
+		
+		delete reactor;
+	}
+	else reactor->remove(receiverSocket.getSocket());
+}
 
 string PTracker::buildHeader() const
 {
@@ -145,6 +153,18 @@ void PTracker::configure(const string& filename)
 		key = "messageFrequency";
 		messageFrequency = fCfg.value(section,key);
 		
+		key = "messageFormat";
+		temp = string(fCfg.value(section,key));
+		
+		if (strcasecmp(temp.c_str(),"binary") == 0) binaryMessages = true;
+		else if (strcasecmp(temp.c_str(),"text") == 0) binaryMessages = false;
+		else
+		{
+			ERR("Unknown message format '" << temp << "'. Exiting..." << endl);
+			
+			exit(-1);
+		}
+		
 		section = "Agent";
 		isPresent = false;
 		
@@ -173,7 +193,7 @@ void PTracker::configure(const string& filename)
 			
 			WARN("Adding receiver: " << address << ":" << p << endl);
 			
-			receivers.push_back(make_pair(address,p));
+			receivers.push_back(InetAddress(address,p));
 		}
 		
 		if (!isPresent)
@@ -305,6 +325,14 @@ void PTracker::init(string filename)
 	
 	configure(filename);
 	
+	/// The same socket (hence the same sender port) for all the messages, the receivers reassemble the fragmented messages by sender.
+	if (!senderSocket.isBound() && !senderSocket.rebind())
+	{
+		ERR("Error when opening the socket sending the estimations. Data Fusion among agents is not possible...exiting!" << endl);
+		
+		exit(-1);
+	}
+	
 	initialTimestamp.setToNow();
 	initialTimestampMas.setToNow();
 	currentTimestamp.setToNow();
@@ -314,6 +342,8 @@ void PTracker::init(string filename)
 	lastCurrentTargetIndex = 0;
 	lastTargetIndex = -1;
 	maxTargetIndex = 0;
+	playback.reactor = 0;
+	playback.timer = -1;
 	
 	processor.addSensorFilter(&objectParticleFilter);
 	
@@ -358,8 +388,6 @@ void PTracker::interruptCallback(int)
 
 void PTracker::exec(const ObjectSensorReading& visualReading)
 {
-	static UdpSocket senderSocket;
-	
 	vector<ObjectSensorReading> observations;
 	string dataToSend;
 	int ret;
@@ -394,8 +422,6 @@ void PTracker::exec(const ObjectSensorReading& visualReading)
 	
 	if (estimatedTargetModels.size() > 0)
 	{
-		dataToSend = "Agent ";
-		
 		AgentPacket agentPacket;
 		
 		agentPacket.dataPacket.ip = agentAddress;
@@ -404,7 +430,8 @@ void PTracker::exec(const ObjectSensorReading& visualReading)
 		agentPacket.dataPacket.estimatedTargetModels = estimatedTargetModels;
 		agentPacket.dataPacket.particlesTimestamp = currentTimestamp.getMsFromMidnight();
 		
-		dataToSend += agentPacket.toString();
+		if (binaryMessages) dataToSend = agentPacket.toBinary();
+		else dataToSend = "Agent " + agentPacket.toString();
 		
 		if ((Timestamp() - lastTimeInformationSent).getMs() > (1000.0 / messageFrequency))
 		{
@@ -420,11 +447,7 @@ void PTracker::exec(const ObjectSensorReading& visualReading)
 		objectSensorReadingMultiAgent.setEstimationsWithModels(estimatedTargetModels);
 		objectSensorReadingMultiAgent.setEstimationsTimestamp(currentTimestamp.getMsFromMidnight());
 		
-		mutex.lock();
-		
 		observationsMultiAgent.push_back(objectSensorReadingMultiAgent);
-		
-		mutex.unlock();
 	}
 	
 	initialTimestamp = currentTimestamp;
@@ -435,22 +458,31 @@ void PTracker::exec(const ObjectSensorReading& visualReading)
 		iterationCounter = 0;
 		initialTimestampMas = currentTimestamp;
 		
-		mutex.lock();
+		/// The readings received from the team of agents are swapped out of the queue, hence neither copied nor waited for.
+		while (true)
+		{
+			observationsMultiAgent.push_back(ObjectSensorReadingMultiAgent());
+			
+			if (!agentReadings.pop(observationsMultiAgent.back()))
+			{
+				observationsMultiAgent.pop_back();
+				
+				break;
+			}
+		}
 		
 		multiAgentProcessor.processReading(observationsMultiAgent);
 		estimatedTargetModelsMultiAgent = objectParticleFilterMultiAgent.getEstimationsWithModel();
 		
 		observationsMultiAgent.clear();
 		
-		mutex.unlock();
-		
 		dataToSend = prepareDataForViewer();
 		
-		ret = senderSocket.send(dataToSend,InetAddress(pViewerAddress,pViewerPort));
+		ret = senderSocket.sendMessage(dataToSend,InetAddress(pViewerAddress,pViewerPort));
 		
 		if (ret == -1)
 		{
-			ERR("Error when sending message to PViewer." << endl);
+			ERR("Error when sending message to PViewer (" << senderSocket.getStatistics().oversizedMessages << " oversized messages so far)." << endl);
 		}
 		
 		if (rosBridgeEnabled)
@@ -492,11 +524,17 @@ void PTracker::exec(const ObjectSensorReading& visualReading)
 
 void PTracker::exec(const string& observationFile, int frameRate)
 {
-	ofstream results;
-	string resultFile;
-	float sleepTime;
+	float periodMs;
 	
-	const vector<ObjectSensorReading>& visualReadings = readObservationFile(observationFile);
+	if (playback.reactor != 0)
+	{
+		ERR("An observation file is already being played back, '" << observationFile << "' is ignored." << endl);
+		
+		return;
+	}
+	
+	playback.readings = readObservationFile(observationFile);
+	playback.next = playback.readings.begin();
 	
 	struct stat temp;
 	
@@ -505,53 +543,109 @@ void PTracker::exec(const string& observationFile, int frameRate)
 		mkdir("../results",0700);
 	}
 	
-	resultFile = string("../results/PTracker-") + observationFile.substr(observationFile.rfind("/") + 1);
+	playback.resultFile = string("../results/PTracker-") + observationFile.substr(observationFile.rfind("/") + 1);
 	
-	results.open(resultFile.c_str());
+	playback.results.open(playback.resultFile.c_str());
 	
-	if (results.is_open())
+	if (playback.results.is_open())
 	{
-		results << "<?xml version=\"1.0\" encoding=\"utf-8\"?>" << endl;
-		results << "<dataset>" << endl;
+		playback.results << "<?xml version=\"1.0\" encoding=\"utf-8\"?>" << endl;
+		playback.results << "<dataset>" << endl;
 	}
 	
-	if (frameRate > 0) sleepTime = (1000.0 / frameRate) * 1000.0;
-	else sleepTime = 30e3;
+	if (frameRate > 0) periodMs = 1000.0 / frameRate;
+	else periodMs = 30.0;
+	
+	/// Only a local reactor can be stopped once the observations are over, a borrowed one keeps serving its owner.
+	Reactor ownReactor;
+	
+	playback.reactor = reactorOwned ? &ownReactor : reactor;
+	playback.timer = -1;
 	
-	for (vector<ObjectSensorReading>::const_iterator it = visualReadings.begin(); it != visualReadings.end(); ++it)
+	if (playback.next != playback.readings.end())
 	{
-		exec(*it);
+		playback.timer = playback.reactor->addTimer(periodMs,playbackCallback,this);
 		
-		if (results.is_open())
+		if (playback.timer == -1)
 		{
-			results << "   <frame number=\"" << counterResult << "\">" << endl;
-			results << "      <objectlist>" << endl;
+			ERR("Error when creating the timer of the observations. Exiting..." << endl);
+		}
+		else if (!reactorOwned) return;
+		else
+		{
+			/// Ctrl+C stops the playback, so that the results are saved anyway.
+			ownReactor.stopOnSignal(SIGINT);
+			ownReactor.run();
 			
-			for (EstimationsMultiAgent::const_iterator it2 = estimatedTargetModelsMultiAgent.begin(); it2 != estimatedTargetModelsMultiAgent.end(); ++it2)
+			if (ownReactor.getStopSignal() == SIGINT)
 			{
-				results << "         <object id=\"" << it2->first << "\">" << endl;
-				results << "            <box h=\"" << it2->second.first.first.model.height << "\" w=\"" << it2->second.first.first.model.width
-						<< "\" xc=\"" << it2->second.first.first.observation.getCartesian().x << "\" yc=\"" << it2->second.first.first.observation.getCartesian().y << "\"/>" << endl;
-				results << "         </object>" << endl;
+				ERR(endl << "*********************************************************************" << endl);
+				ERR("Caught Ctrl+C. Exiting..." << endl);
+				ERR("*********************************************************************" << endl);
 			}
-			
-			results << "      </objectlist>" << endl;
-			results << "   </frame>" << endl;
 		}
-		
-		usleep(sleepTime);
 	}
 	
-	if (results.is_open())
+	finishPlayback();
+}
+
+void PTracker::finishPlayback()
+{
+	if (playback.reactor == 0) return;
+	
+	if (playback.timer != -1) playback.reactor->remove(playback.timer);
+	
+	playback.reactor = 0;
+	playback.timer = -1;
+	playback.readings.clear();
+	
+	if (playback.results.is_open())
 	{
-		results << "</dataset>" << endl;
+		playback.results << "</dataset>" << endl;
+		playback.results.close();
 		
 		INFO(endl << "Results has been saved in ");
-		WARN(resultFile << endl)
+		WARN(playback.resultFile << endl)
 	}
 	else ERR(endl << "An error occured during the writing process. Results are not available..." << endl);
 }
 
+void PTracker::playbackCallback(void* context)
+{
+	PTracker* pTracker = (PTracker*) context;
+	Playback& playback = pTracker->playback;
+	ofstream& results = playback.results;
+	
+	pTracker->exec(*playback.next);
+	
+	if (results.is_open())
+	{
+		results << "   <frame number=\"" << pTracker->counterResult << "\">" << endl;
+		results << "      <objectlist>" << endl;
+		
+		for (EstimationsMultiAgent::const_iterator it = pTracker->estimatedTargetModelsMultiAgent.begin(); it != pTracker->estimatedTargetModelsMultiAgent.end(); ++it)
+		{
+			results << "         <object id=\"" << it->first << "\">" << endl;
+			results << "            <box h=\"" << it->second.first.first.model.height << "\" w=\"" << it->second.first.first.model.width
+					<< "\" xc=\"" << it->second.first.first.observation.getCartesian().x << "\" yc=\"" << it->second.first.first.observation.getCartesian().y << "\"/>" << endl;
+			results << "         </object>" << endl;
+		}
+		
+		results << "      </objectlist>" << endl;
+		results << "   </frame>" << endl;
+	}
+	
+	if (++playback.next == playback.readings.end())
+	{
+		Reactor* playbackReactor = playback.reactor;
+		
+		/// On a borrowed reactor only the timer is removed, the local one is stopped as well so that exec() returns.
+		pTracker->finishPlayback();
+		
+		if (pTracker->reactorOwned) playbackReactor->stop();
+	}
+}
+
 string PTracker::prepareDataForViewer() const
 {
 	stringstream streamDataToSend;
@@ -671,8 +765,7 @@ vector<ObjectSensorReading> PTracker::readObservationFile(const string& observat
 									y = atof((char*) temp);
 									xmlFree(temp);
 									
-									obs.observation.rho = sqrt((x * x) + (y * y));
-									obs.observation.theta = atan2(y,x);
+									obs.observation.setCartesian(Point2f(x,y));
 									
 									temp = xmlGetProp(box,XML_TAG_OBJECT_HXC);
 									obs.head.x = atof((char*) temp);
@@ -711,29 +804,29 @@ vector<ObjectSensorReading> PTracker::readObservationFile(const string& observat
 	return visualReadings;
 }
 
-void PTracker::sendEstimationsToAgents(const string& dataToSend) const
+void PTracker::sendEstimationsToAgents(const string& dataToSend)
 {
-	UdpSocket senderSocket;
 	int ret;
 	
-	for (vector<pair<string,int> >::const_iterator it = receivers.begin(); it != receivers.end(); it++)
+	/// All the datagrams to all the agents with a single system call.
+	ret = senderSocket.sendMessage(dataToSend,receivers);
+	
+	if (ret == -1)
 	{
-		ret = senderSocket.send(dataToSend,InetAddress(it->first,it->second));
-		
-		if (ret == -1)
-		{
-			ERR("Error when sending message to: '" << it->second << "'." << endl);
-		}
+		ERR("Error when sending message to the agents (" << senderSocket.getStatistics().sentMessages << " messages sent, " << senderSocket.getStatistics().oversizedMessages << " oversized so far)." << endl);
 	}
 }
 
 vector<PoseParticleVector> PTracker::updateBestParticles(const EstimationsSingleAgent& estimationsWithModel)
 {
+	/// Seeded by the filter, so that a fixed random seed gives the same particles.
+	Random random = objectParticleFilter.getRandom(ObjectParticleFilter::SamplingStream);
+	
 	bestParticles.clear();
 	
 	for (EstimationsSingleAgent::const_iterator it = estimationsWithModel.begin(); it != estimationsWithModel.end(); ++it)
 	{
-		bestParticles.push_back(Utils::samplingParticles(it->second.first.observation.getCartesian(),it->second.first.sigma,bestParticlesNumber));
+		bestParticles.push_back(Utils::samplingParticles(it->second.first.observation.getCartesian(),it->second.first.sigma,bestParticlesNumber,random));
 	}
 	
 	return bestParticles;
@@ -777,51 +870,86 @@ void PTracker::updateTargetVector(const ObjectSensorReading& visualReading)
 	}
 }
 
-void PTracker::waitAgentMessages()
+void PTracker::receiveAgentMessages()
 {
 	ObjectSensorReadingMultiAgent objectSensorReadingMultiAgent;
-	UdpSocket receiverSocket;
 	InetAddress sender;
 	string dataReceived;
 	int ret;
-	bool binding;
-	
-	binding = receiverSocket.bind(agentPort);
-	
-	if (!binding)
-	{
-		ERR("Error during the binding operation. Data Fusion among agents is not possible...exiting!" << endl);
-		
-		exit(-1);
-	}
-	
-	WARN("Agent " << agentId << " bound on port: " << agentPort << endl);
-	
-	objectSensorReadingMultiAgent.setSensor(objectSensorReading.getSensor());
 	
 	while (true)
 	{
-		ret = receiverSocket.recv(dataReceived,sender);
+		/// Negative timeout, the socket is readable but it may hold only a part of a fragmented message.
+		ret = receiverSocket.recvMessage(dataReceived,sender,-1.0);
 		
-		if (ret == -1)
+		if (receiverSocket.getStatistics().droppedMessages != droppedMessages)
+		{
+			droppedMessages = receiverSocket.getStatistics().droppedMessages;
+			
+			WARN("Incomplete messages from the agents dropped so far: " << droppedMessages << endl);
+		}
+		
+		if (ret == 0) break;
+		else if (ret == -1)
 		{
 			ERR("Error in receiving message from: '" << sender.toString() << "'." << endl);
 			
-			continue;
+			break;
 		}
 		
 		AgentPacket ap;
 		
-		ap.setData(dataReceived.substr(dataReceived.find(" ") + 1));
+		/// Peers still sending the text format are supported as well.
+		if (AgentPacket::isBinary(dataReceived.data(),dataReceived.size()))
+		{
+			if (!ap.fromBinary(dataReceived.data(),dataReceived.size()))
+			{
+				ERR("Malformed message from: '" << sender.toString() << "'." << endl);
+				
+				continue;
+			}
+		}
+		else ap.setData(dataReceived.substr(dataReceived.find(" ") + 1));
 		
+		/// The reading is rebuilt at every message, since the queue gives back the one previously stored in the slot.
 		objectSensorReadingMultiAgent.setAgent(ap.dataPacket.ip,ap.dataPacket.port);
-		objectSensorReadingMultiAgent.setEstimationsWithModels(ap.dataPacket.estimatedTargetModels);
+		objectSensorReadingMultiAgent.setSensor(objectSensorReading.getSensor());
+		objectSensorReadingMultiAgent.swapEstimationsWithModels(ap.dataPacket.estimatedTargetModels);
 		objectSensorReadingMultiAgent.setEstimationsTimestamp(ap.dataPacket.particlesTimestamp);
 		
-		mutex.lock();
+		if (!agentReadings.push(objectSensorReadingMultiAgent))
+		{
+			++discardedReadings;
+			
+			WARN("Readings from the agents discarded so far because the multi agent phase is late: " << discardedReadings << endl);
+		}
+	}
+}
+
+void PTracker::startReceiver(Reactor* reactor)
+{
+	discardedReadings = 0;
+	droppedMessages = 0;
+	reactorOwned = (reactor == 0);
+	
+	if (reactorOwned) this->reactor = new Reactor();
+	else this->reactor = reactor;
+	
+	if (!receiverSocket.bind(agentPort))
+	{
+		ERR("Error during the binding operation. Data Fusion among agents is not possible...exiting!" << endl);
 		
-		observationsMultiAgent.push_back(objectSensorReadingMultiAgent);
+		exit(-1);
+	}
+	
+	WARN("Agent " << agentId << " bound on port: " << agentPort << endl);
+	
+	if (!this->reactor->addSocket(receiverSocket.getSocket(),agentMessagesCallback,this))
+	{
+		ERR("Error when registering the socket of the agent in the reactor. Data Fusion among agents is not possible...exiting!" << endl);
 		
-		mutex.unlock();
+		exit(-1);
 	}
+	
+	if (reactorOwned) pthread_create(&reactorThread,0,(void*(*)(void*)) reactorThreadMain,this->reactor);
 }
@@ -3,7 +3,12 @@
 #include <Core/Processors/Processor.h>
 #include <Core/Processors/MultiAgentProcessor.h>
 #include <Utils/AgentPacket.h>
-#include <boost/thread/mutex.hpp>
+#include <Utils/InetAddress.h>
+#include <Utils/Reactor.h>
+#include <Utils/SpscQueue.h>
+#include <Utils/UdpSocket.h>
+#include <pthread.h>
+#include <fstream>
 
 /**
  * @class PTracker
@@ -13,6 +18,9 @@
  * PTracker allows to perform the distributed tracking in two ways:
  *	- by giving in input a file containing all the observations
  *	- by calling an exec function that performs the distributed tracking iteration by iteration
+ * 
+ * The messages of the other agents are received by a Reactor, either given by the owner of the agent (so that many agents can share a single thread)
+ * or created by the agent itself and run by a thread of its own.
  */
 class PTracker
 {
@@ -32,6 +40,26 @@ class PTracker
 		 */
 		static const int LAST_N_TARGET_PERCEPTIONS = 100;
 		
+		/**
+		 * @brief maximum number of readings received from the team of agents waiting for the multi agent phase.
+		 */
+		static const int AGENT_READINGS_QUEUE_SIZE = 256;
+		
+		/**
+		 * @struct Playback
+		 * 
+		 * @brief Struct that represents the observations of a file being played back by a timer of the reactor.
+		 */
+		struct Playback
+		{
+			std::vector<PTracking::ObjectSensorReading> readings;
+			std::vector<PTracking::ObjectSensorReading>::const_iterator next;
+			std::ofstream results;
+			std::string resultFile;
+			PTracking::Reactor* reactor;
+			int timer;
+		};
+		
 		/**
 		 * @brief map representing the estimations having both an identity and a model of the estimations performed by the team of agents.
 		 */
@@ -48,9 +76,9 @@ class PTracker
 		std::vector<PoseParticleVector> bestParticles;
 		
 		/**
-		 * @brief vector containing all the addresses of the agents that have to receive the information.
+		 * @brief vector containing all the addresses of the agents that have to receive the information (resolved once when configuring).
 		 */
-		std::vector<std::pair<std::string,int> > receivers;
+		std::vector<PTracking::InetAddress> receivers;
 		
 		/**
 		 * @brief vector containing all the estimations performed the team of agents.
@@ -128,9 +156,34 @@ class PTracker
 		PTracking::Timestamp lastTimeInformationSent;
 		
 		/**
-		 * @brief semaphore to handle the mutual exclusion between the single agent and the multi agent phase.
+		 * @brief readings received from the team of agents, handed off by the reactor to the multi agent phase.
+		 */
+		PTracking::SpscQueue<PTracking::ObjectSensorReadingMultiAgent> agentReadings;
+		
+		/**
+		 * @brief socket where the messages of the team of agents are received.
+		 */
+		PTracking::UdpSocket receiverSocket;
+		
+		/**
+		 * @brief socket where the estimations are sent to the team of agents, to PViewer and to the ros node bridge.
 		 */
-		boost::mutex mutex;
+		PTracking::UdpSocket senderSocket;
+		
+		/**
+		 * @brief pointer to the reactor where the socket of the agent is registered.
+		 */
+		PTracking::Reactor* reactor;
+		
+		/**
+		 * @brief thread running the reactor, if owned by the agent.
+		 */
+		pthread_t reactorThread;
+		
+		/**
+		 * @brief observation file being played back, if any (its reactor is 0 otherwise).
+		 */
+		Playback playback;
 		
 		/**
 		 * @brief address of the agent.
@@ -212,6 +265,16 @@ class PTracker
 		 */
 		int maxTargetIndex;
 		
+		/**
+		 * @brief number of readings received from the team of agents discarded because the multi agent phase was late.
+		 */
+		unsigned long discardedReadings;
+		
+		/**
+		 * @brief number of incomplete messages dropped by the receiver socket, as last reported.
+		 */
+		unsigned long droppedMessages;
+		
 		/**
 		 * @brief port of PViewer.
 		 */
@@ -222,19 +285,43 @@ class PTracker
 		 */
 		int rosBridgePort;
 		
+		/**
+		 * @brief true means that the estimations are sent to the team of agents in the binary format, otherwise in the text one.
+		 */
+		bool binaryMessages;
+		
 		/**
 		 * @brief enabling/disabling communication with the ros node bridge.
 		 */
 		bool rosBridgeEnabled;
 		
 		/**
-		 * @brief Function that invokes a thread-function that waits messages coming from other agents.
+		 * @brief true if the reactor has been created by the agent, that runs it in a thread of its own.
+		 */
+		bool reactorOwned;
+		
+		/**
+		 * @brief Function that receives the messages coming from other agents, executed by the reactor when the socket of the agent is readable.
+		 * 
+		 * @param pTracker pointer to the invocation object.
+		 */
+		static void agentMessagesCallback(void* pTracker) { ((PTracker*) pTracker)->receiveAgentMessages(); }
+		
+		/**
+		 * @brief Function that processes the next observation of a file being played back, executed by the reactor at the frame rate of the file.
 		 * 
 		 * @param pTracker pointer to the invocation object.
+		 */
+		static void playbackCallback(void* pTracker);
+		
+		/**
+		 * @brief Function that invokes a thread-function that runs the reactor owned by the agent.
+		 * 
+		 * @param reactor pointer to the reactor.
 		 * 
-		 * @return 0 if succeeded, -1 otherwise.
+		 * @return 0.
 		 */
-		static void* waitAgentMessagesThread(PTracker* pTracker) { pTracker->waitAgentMessages(); return 0; }
+		static void* reactorThreadMain(PTracking::Reactor* reactor) { reactor->run(); return 0; }
 		
 		/**
 		 * @brief Function that allows a clean exit catching the SIGINT signal.
@@ -255,6 +342,11 @@ class PTracker
 		 */
 		void configure(const std::string& filename);
 		
+		/**
+		 * @brief Function that ends the playback of an observation file, removing its timer from the reactor and completing the results.
+		 */
+		void finishPlayback();
+		
 		/**
 		 * @brief Function that initializes several configuration parameters.
 		 * 
@@ -281,9 +373,9 @@ class PTracker
 		/**
 		 * @brief Function that sends the estimations to all the agents.
 		 * 
-		 * @param dataToSend reference to the estimations to send (string format).
+		 * @param dataToSend reference to the estimations to send (either text or binary format).
 		 */
-		void sendEstimationsToAgents(const std::string& dataToSend) const;
+		void sendEstimationsToAgents(const std::string& dataToSend);
 		
 		/**
 		 * @brief Function that returns the best particles representing the current estimations performed by the single agent.
@@ -309,9 +401,16 @@ class PTracker
 		void updateTargetVector(const PTracking::ObjectSensorReading& visualReading);
 		
 		/**
-		 * @brief Function that collects messages coming from the other agents.
+		 * @brief Function that collects the messages coming from the other agents until none is left in the socket.
 		 */
-		void waitAgentMessages();
+		void receiveAgentMessages();
+		
+		/**
+		 * @brief Function that binds the socket of the agent and registers it in a reactor.
+		 * 
+		 * @param reactor pointer to the reactor, if 0 the agent creates one and runs it in a thread of its own.
+		 */
+		void startReceiver(PTracking::Reactor* reactor);
 		
 	public:
 		/**
@@ -326,11 +425,15 @@ class PTracker
 		 * 
 		 * @param agentId id of the agent.
 		 * @param filename file to be read.
+		 * @param reactor pointer to the reactor receiving the messages of the other agents, run by the caller that has to call exec() from the same thread
+		 * (or from its timers) and handles the shutdown. If 0, the agent creates a reactor running in a thread of its own and Ctrl+C terminates the process.
 		 */
-		PTracker(int agentId, const std::string& filename = "");
+		PTracker(int agentId, const std::string& filename = "", PTracking::Reactor* reactor = 0);
 		
 		/**
 		 * @brief Destructor.
+		 * 
+		 * It stops the reactor owned by the agent, or it unregisters the socket of the agent from the one given to the constructor.
 		 */
 		~PTracker();
 		
@@ -344,6 +447,10 @@ class PTracker
 		/**
 		 * @brief Function that reads the observation file and perform the distributed tracking. The results are written in a file. It can be stopped by pressing Ctrl+C.
 		 * 
+		 * If the agent has a reactor of its own, the observations are played back by a timer of a local reactor and the function returns once they are over.
+		 * Otherwise the timer is added to the reactor given to the constructor and the function returns immediately: the observations are played back while
+		 * the caller runs the reactor, then the timer is removed and the results are completed (the reactor is never stopped).
+		 * 
 		 * @param observationFile reference to the file containing all the observations.
 		 * @param frameRate the frame rate by which the observation file has been recorded.
 		 */
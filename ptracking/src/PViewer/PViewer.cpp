@@ -1,6 +1,4 @@
 #include "PViewer.h"
-#include <Utils/UdpSocket.h>
-#include <Utils/Timestamp.h>
 #include <Utils/Utils.h>
 #include <Manfield/configfile/configfile.h>
 #include <Manfield/utils/debugutils.h>
@@ -13,9 +11,10 @@ using namespace PTracking;
 using namespace Gnuplot;
 using GMapping::ConfigFile;
 
-PViewer::PViewer()
+PViewer::PViewer() : gnuplotGUI(0)
 {
-	signal(SIGINT,PViewer::interruptCallback);
+	/// Ctrl+C stops the reactor, so that exec() returns.
+	reactor.stopOnSignal(SIGINT);
 	
 	configure();
 }
@@ -157,238 +156,251 @@ void PViewer::drawPointWithOrientation(float x, float y, float theta, ostringstr
 void PViewer::exec()
 {
 	GnuplotGUI gnuplotGUI;
-	UdpSocket socket;
-	InetAddress sender;
-	Timestamp current, initial;
+	
+	this->gnuplotGUI = &gnuplotGUI;
+	droppedMessages = 0;
+	
+	if (receiverSocket.bind(port))
+	{
+		INFO("PViewer started." << endl);
+		
+		if (!reactor.addSocket(receiverSocket.getSocket(),messagesCallback,this) || (reactor.addTimer(1000.0 / visualizationFrequency,plotCallback,this) == -1))
+		{
+			ERR("Error when registering the socket and the timer of PViewer in the reactor." << endl);
+		}
+		else
+		{
+			reactor.run();
+			
+			if (reactor.getStopSignal() == SIGINT)
+			{
+				ERR(endl << "*********************************************************************" << endl);
+				ERR("Caught Ctrl+C. Exiting..." << endl);
+				ERR("*********************************************************************" << endl);
+			}
+		}
+		
+		receiverSocket.shutdown(SHUT_RDWR);
+	}
+	else
+	{
+		ERR("Error in binding on port " << port << "." <<endl);
+	}
+	
+	this->gnuplotGUI = 0;
+}
+
+void PViewer::plot()
+{
 	ostringstream circleDataForGnuplot, prepareDataForGnuplot, velocityDataForGnuplot;
 	stringstream streamDataReceived;
-	string color, dataReceived, isOriented, type;
+	string color, isOriented, type;
 	float maxReading, x, y, theta, x2, y2, width;
-	int objectType, ret;
+	int objectType;
 	short agentId, differentType, form, i;
-	bool binding, exiting, isFov, isPresent;
+	bool isFov;
+	
+	/// Nothing has been received since the last plot.
+	if (bufferDataReceived.empty()) return;
+	
+	// Sort the agent id in increasing order.
+	sort(bufferDataReceived.begin(),bufferDataReceived.end(),Utils::comparePairInt);
+	
+	prepareDataForGnuplot << "set terminal wxt size " << gnuplotWindowWidth << "," << gnuplotWindowHeight << endl;
+	prepareDataForGnuplot << "set grid" << endl;
+	prepareDataForGnuplot << "set xlabel \"Scale 1:" << worldScalingFactor << "\" textcolor rgb 'red'" << endl;
+	prepareDataForGnuplot << "set xlabel font \"Times-Roman, 15\"" << endl;
+	prepareDataForGnuplot << "set xrange[" << worldX.x << ":" << worldX.y << "]" << endl;
+	prepareDataForGnuplot << "set yrange[" << worldY.y << ":" << worldY.x << "]" << endl;
 	
-	exiting = false;
+	prepareDataForGnuplot << "plot ";
 	
-	binding = socket.bind(port);
+	i = 0;
+	isFov = false;
 	
-	if (binding)
+	for (vector<pair<int,string> >::iterator it = bufferDataReceived.begin(); it != bufferDataReceived.end(); ++it, ++i)
 	{
-		INFO("PViewer started." << endl);
+		streamDataReceived.str("");
+		streamDataReceived.clear();
+		
+		streamDataReceived << it->second;
+		
+		streamDataReceived >> agentId >> differentType;
+		
+		if ((i > 0) && isFov) prepareDataForGnuplot << ", ";
 		
-		initial.setToNow();
+		isFov = false;
 		
-		while (!exiting)
+		if (differentType > 0)
 		{
-			ret = socket.recv(dataReceived,sender);
-			
-			if (ret == -1)
-			{
-				ERR("Error when receiving message from: '" << sender.toString() << "'." << endl);
-			}
-			else
+			for (short i = 0; i < differentType; i++)
 			{
-				if (dataReceived == "End")
-				{
-					exiting = true;
-					
-					break;
-				}
-				
-				streamDataReceived.str("");
-				streamDataReceived.clear();
-				
-				streamDataReceived << dataReceived;
-				
-				streamDataReceived >> agentId;
+				streamDataReceived >> type >> isOriented >> color >> form >> width;
 				
-				isPresent = false;
-				
-				for (vector<pair<int,string> >::iterator it = bufferDataReceived.begin(); it != bufferDataReceived.end(); it++)
+				if (type != "FOV")
 				{
-					if (it->first == agentId)
+					if (isFov)
 					{
-						isPresent = true;
-						it->second = dataReceived;
+						prepareDataForGnuplot << ", ";
 						
-						break;
+						isFov = false;
 					}
-				}
-				
-				if (!isPresent) bufferDataReceived.push_back(make_pair(agentId,dataReceived));
-				
-				current.setToNow();
-				
-				if ((current - initial).getMs() > (1000.0 / visualizationFrequency))
-				{
-					prepareDataForGnuplot.str("");
-					prepareDataForGnuplot.clear();
-					
-					circleDataForGnuplot.str("");
-					circleDataForGnuplot.clear();
-					
-					velocityDataForGnuplot.str("");
-					velocityDataForGnuplot.clear();
-					
-					// Sort the agent id in increasing order.
-					sort(bufferDataReceived.begin(),bufferDataReceived.end(),Utils::comparePairInt);
 					
-					prepareDataForGnuplot << "set terminal wxt size " << gnuplotWindowWidth << "," << gnuplotWindowHeight << endl;
-					prepareDataForGnuplot << "set grid" << endl;
-					prepareDataForGnuplot << "set xlabel \"Scale 1:" << worldScalingFactor << "\" textcolor rgb 'red'" << endl;
-					prepareDataForGnuplot << "set xlabel font \"Times-Roman, 15\"" << endl;
-					prepareDataForGnuplot << "set xrange[" << worldX.x << ":" << worldX.y << "]" << endl;
-					prepareDataForGnuplot << "set yrange[" << worldY.y << ":" << worldY.x << "]" << endl;
-					
-					prepareDataForGnuplot << "plot ";
-					
-					i = 0;
-					isFov = false;
-					
-					for (vector<pair<int,string> >::iterator it = bufferDataReceived.begin(); it != bufferDataReceived.end(); ++it, ++i)
+					if (type != "ObservationsMapping")
 					{
-						streamDataReceived.str("");
-						streamDataReceived.clear();
-						
-						streamDataReceived << it->second;
-						
-						streamDataReceived >> agentId >> differentType;
+						prepareDataForGnuplot << "'-' notitle '" << type << "' w p pt " << form << " ps " << width << " lt rgb '" << color << "'";
 						
-						if ((i > 0) && isFov) prepareDataForGnuplot << ", ";
-						
-						isFov = false;
-						
-						if (differentType > 0)
-						{
-							for (short i = 0; i < differentType; i++)
-							{
-								streamDataReceived >> type >> isOriented >> color >> form >> width;
-								
-								if (type != "FOV")
-								{
-									if (isFov)
-									{
-										prepareDataForGnuplot << ", ";
-										
-										isFov = false;
-									}
-									
-									if (type != "ObservationsMapping")
-									{
-										prepareDataForGnuplot << "'-' notitle '" << type << "' w p pt " << form << " ps " << width << " lt rgb '" << color << "'";
-										
-										if (strcasecmp(isOriented.c_str(),"true") == 0) prepareDataForGnuplot << ", '-' notitle w vec lw 2 lt rgb '#000000'";
-									}
-									else prepareDataForGnuplot << "'-' notitle '" << type << "' w l lw " << width << " lt rgb '" << color << "'";
-									
-									if (((it + 1) != bufferDataReceived.end()) || (i < (differentType - 1))) prepareDataForGnuplot << ", ";
-								}
-								else
-								{
-									string temp;
-									
-									temp = prepareDataForGnuplot.str();
-									
-									prepareDataForGnuplot.str("");
-									prepareDataForGnuplot.clear();
-									
-									prepareDataForGnuplot << temp.substr(0,temp.size() - 2);
-									
-									isFov = true;
-								}
-							}
-						}
+						if (strcasecmp(isOriented.c_str(),"true") == 0) prepareDataForGnuplot << ", '-' notitle w vec lw 2 lt rgb '#000000'";
 					}
+					else prepareDataForGnuplot << "'-' notitle '" << type << "' w l lw " << width << " lt rgb '" << color << "'";
 					
-					prepareDataForGnuplot << endl;
+					if (((it + 1) != bufferDataReceived.end()) || (i < (differentType - 1))) prepareDataForGnuplot << ", ";
+				}
+				else
+				{
+					string temp;
 					
-					for (vector<pair<int,string> >::iterator it = bufferDataReceived.begin(); it != bufferDataReceived.end(); ++it)
-					{
-						streamDataReceived.str("");
-						streamDataReceived.clear();
-						
-						streamDataReceived << it->second;
-						
-						streamDataReceived >> agentId >> differentType;
-						
-						if (differentType > 0)
-						{
-							for (short i = 0; i < differentType; i++)
-							{
-								streamDataReceived >> type >> isOriented >> color >> form >> width;
-							}
-						}
-						
-						objectNumber = 0;
-						
-						while (streamDataReceived.good())
-						{
-							if (streamDataReceived.eof()) break;
-							
-							if (objectNumber == 0) streamDataReceived >> objectNumber >> objectType;
-							else streamDataReceived >> objectType;
-							
-							if (objectType == Utils::Point2fOnMap)
-							{
-								streamDataReceived >> x >> y;
-								
-								drawPoint(x / worldScalingFactor,y / worldScalingFactor,prepareDataForGnuplot);
-							}
-							else if (objectType == Utils::Point2ofOnMap)
-							{
-								streamDataReceived >> x >> y >> theta;
-								
-								drawPointWithOrientation(x / worldScalingFactor,y / worldScalingFactor,theta,prepareDataForGnuplot);
-							}
-							else if (objectType == Utils::Point2fWithVelocityOnMap)
-							{
-								streamDataReceived >> x >> y >> x2 >> y2;
-								
-								velocityDataForGnuplot << "set style arrow 3 head filled size screen 0.02,15,45 ls 1" << endl;
-								velocityDataForGnuplot << "set arrow from " << x << "," << y << " to " << x2 << "," << y2 << " as 3" << endl;
-								
-								drawPoint(x / worldScalingFactor,y / worldScalingFactor,prepareDataForGnuplot);
-							}
-							else if (objectType == Utils::Line2dOnMap)
-							{
-								streamDataReceived >> x >> y >> x2 >> y2;
-								
-								drawLine(x / worldScalingFactor,y / worldScalingFactor,x2 / worldScalingFactor,y2 / worldScalingFactor,prepareDataForGnuplot);
-							}
-							else if (objectType == Utils::Circle)
-							{
-								streamDataReceived >> maxReading >> x >> y >> theta;
-								
-								circleDataForGnuplot << "set object circle at " << (x / worldScalingFactor) << "," << (y / worldScalingFactor) << " size " << maxReading
-													 << " arc [" << (-90 + Utils::rad2deg(theta)) << ":" << (90 + Utils::rad2deg(theta)) << "] fc rgb '#000000'" << endl;
-								
-								objectNumber--;
-							}
-							else ERR("Object type not recognized: " << objectType << endl);
-						}
-					}
+					temp = prepareDataForGnuplot.str();
 					
-					gnuplotGUI.cmd(string("unset object\n") + string("unset arrow\n") + velocityDataForGnuplot.str() + circleDataForGnuplot.str() + prepareDataForGnuplot.str());
+					prepareDataForGnuplot.str("");
+					prepareDataForGnuplot.clear();
+					
+					prepareDataForGnuplot << temp.substr(0,temp.size() - 2);
 					
-					initial = current;
-					bufferDataReceived.clear();
+					isFov = true;
 				}
 			}
 		}
-		
-		socket.shutdown(SHUT_RDWR);
 	}
-	else
+	
+	prepareDataForGnuplot << endl;
+	
+	for (vector<pair<int,string> >::iterator it = bufferDataReceived.begin(); it != bufferDataReceived.end(); ++it)
 	{
-		ERR("Error in binding on port " << port << "." <<endl);
+		streamDataReceived.str("");
+		streamDataReceived.clear();
+		
+		streamDataReceived << it->second;
+		
+		streamDataReceived >> agentId >> differentType;
+		
+		if (differentType > 0)
+		{
+			for (short i = 0; i < differentType; i++)
+			{
+				streamDataReceived >> type >> isOriented >> color >> form >> width;
+			}
+		}
+		
+		objectNumber = 0;
+		
+		while (streamDataReceived.good())
+		{
+			if (streamDataReceived.eof()) break;
+			
+			if (objectNumber == 0) streamDataReceived >> objectNumber >> objectType;
+			else streamDataReceived >> objectType;
+			
+			if (objectType == Utils::Point2fOnMap)
+			{
+				streamDataReceived >> x >> y;
+				
+				drawPoint(x / worldScalingFactor,y / worldScalingFactor,prepareDataForGnuplot);
+			}
+			else if (objectType == Utils::Point2ofOnMap)
+			{
+				streamDataReceived >> x >> y >> theta;
+				
+				drawPointWithOrientation(x / worldScalingFactor,y / worldScalingFactor,theta,prepareDataForGnuplot);
+			}
+			else if (objectType == Utils::Point2fWithVelocityOnMap)
+			{
+				streamDataReceived >> x >> y >> x2 >> y2;
+				
+				velocityDataForGnuplot << "set style arrow 3 head filled size screen 0.02,15,45 ls 1" << endl;
+				velocityDataForGnuplot << "set arrow from " << x << "," << y << " to " << x2 << "," << y2 << " as 3" << endl;
+				
+				drawPoint(x / worldScalingFactor,y / worldScalingFactor,prepareDataForGnuplot);
+			}
+			else if (objectType == Utils::Line2dOnMap)
+			{
+				streamDataReceived >> x >> y >> x2 >> y2;
+				
+				drawLine(x / worldScalingFactor,y / worldScalingFactor,x2 / worldScalingFactor,y2 / worldScalingFactor,prepareDataForGnuplot);
+			}
+			else if (objectType == Utils::Circle)
+			{
+				streamDataReceived >> maxReading >> x >> y >> theta;
+				
+				circleDataForGnuplot << "set object circle at " << (x / worldScalingFactor) << "," << (y / worldScalingFactor) << " size " << maxReading
+									 << " arc [" << (-90 + Utils::rad2deg(theta)) << ":" << (90 + Utils::rad2deg(theta)) << "] fc rgb '#000000'" << endl;
+				
+				objectNumber--;
+			}
+			else ERR("Object type not recognized: " << objectType << endl);
+		}
 	}
+	
+	gnuplotGUI->cmd(string("unset object\n") + string("unset arrow\n") + velocityDataForGnuplot.str() + circleDataForGnuplot.str() + prepareDataForGnuplot.str());
+	
+	bufferDataReceived.clear();
 }
 
-void PViewer::interruptCallback(int)
+void PViewer::receiveMessages()
 {
-	ERR(endl << "*********************************************************************" << endl);
-	ERR("Caught Ctrl+C. Exiting..." << endl);
-	ERR("*********************************************************************" << endl);
+	InetAddress sender;
+	stringstream streamDataReceived;
+	string dataReceived;
+	int ret;
+	short agentId;
+	bool isPresent;
 	
-	exit(0);
+	while (true)
+	{
+		ret = receiverSocket.recvMessage(dataReceived,sender,-1.0);
+		
+		if (receiverSocket.getStatistics().droppedMessages != droppedMessages)
+		{
+			droppedMessages = receiverSocket.getStatistics().droppedMessages;
+			
+			WARN("Incomplete messages dropped so far: " << droppedMessages << endl);
+		}
+		
+		if (ret == 0) break;
+		else if (ret == -1)
+		{
+			ERR("Error when receiving message from: '" << sender.toString() << "'." << endl);
+			
+			break;
+		}
+		
+		if (dataReceived == "End")
+		{
+			reactor.stop();
+			
+			break;
+		}
+		
+		streamDataReceived.str("");
+		streamDataReceived.clear();
+		
+		streamDataReceived << dataReceived;
+		
+		streamDataReceived >> agentId;
+		
+		isPresent = false;
+		
+		for (vector<pair<int,string> >::iterator it = bufferDataReceived.begin(); it != bufferDataReceived.end(); it++)
+		{
+			if (it->first == agentId)
+			{
+				isPresent = true;
+				it->second = dataReceived;
+				
+				break;
+			}
+		}
+		
+		if (!isPresent) bufferDataReceived.push_back(make_pair(agentId,dataReceived));
+	}
 }
@@ -1,9 +1,16 @@
 #pragma once
 
 #include <Utils/Point2f.h>
+#include <Utils/Reactor.h>
+#include <Utils/UdpSocket.h>
 #include <string>
 #include <vector>
 
+namespace Gnuplot
+{
+	class GnuplotGUI;
+}
+
 /**
  * @class PViewer
  * 
@@ -16,7 +23,8 @@
  *	- the targets' estimation performed by each agent
  * 
  * PViewer waits messages, that could come from all the agents, on a UDP socket and it plots the
- * information received with a frequency set in the configuration file. 
+ * information received with a frequency set in the configuration file. Both the socket and the
+ * plotting timer are handled by a Reactor.
  */
 class PViewer
 {
@@ -26,6 +34,21 @@ class PViewer
 		 */
 		std::vector<std::pair<int,std::string> > bufferDataReceived;
 		
+		/**
+		 * @brief reactor dispatching the messages and the plotting timer.
+		 */
+		PTracking::Reactor reactor;
+		
+		/**
+		 * @brief socket where messages are received.
+		 */
+		PTracking::UdpSocket receiverSocket;
+		
+		/**
+		 * @brief pointer to the gnuplot window, valid while exec() is running.
+		 */
+		Gnuplot::GnuplotGUI* gnuplotGUI;
+		
 		/**
 		 * @brief maximum admissible range for the x coordinate.
 		 */
@@ -67,9 +90,23 @@ class PViewer
 		int port;
 		
 		/**
-		 * @brief Function that allows a clean exit intercepting the SIGINT signal.
+		 * @brief number of incomplete messages dropped by the socket, as last reported.
 		 */
-		static void interruptCallback(int);
+		unsigned long droppedMessages;
+		
+		/**
+		 * @brief Function that receives the messages, executed by the reactor when the socket is readable.
+		 * 
+		 * @param pViewer pointer to the invocation object.
+		 */
+		static void messagesCallback(void* pViewer) { ((PViewer*) pViewer)->receiveMessages(); }
+		
+		/**
+		 * @brief Function that plots the information received, executed by the reactor with the visualization frequency.
+		 * 
+		 * @param pViewer pointer to the invocation object.
+		 */
+		static void plotCallback(void* pViewer) { ((PViewer*) pViewer)->plot(); }
 		
 		/**
 		 * @brief Function that reads a config file in order to initialize several configuration parameters.
@@ -106,11 +143,21 @@ class PViewer
 		 */
 		void drawPointWithOrientation(float x, float y, float theta, std::ostringstream& prepareDataForGnuPlot);
 		
+		/**
+		 * @brief Function that plots the information received since the last plot, if any.
+		 */
+		void plot();
+		
+		/**
+		 * @brief Function that stores the messages received until none is left in the socket, stopping the reactor when a "End" message is received.
+		 */
+		void receiveMessages();
+		
 	public:
 		/**
 		 * @brief Empty constructor.
 		 * 
-		 * It registrers the SIGINT callback and it configures the parameters reading a config file.
+		 * It makes SIGINT stop the reactor and it configures the parameters reading a config file.
 		 */
 		PViewer();
 		
@@ -120,7 +167,7 @@ class PViewer
 		~PViewer();
 		
 		/**
-		 * @brief Function that waits messages on the specified UDP port and plots the information received with a frequency of 30 Hz. It stops when either a "End" message is received or Ctrl+C is pressed.
+		 * @brief Function that runs the reactor, waiting messages on the specified UDP port and plotting the information received with the visualization frequency. It stops when either a "End" message is received or Ctrl+C is pressed.
 		 */
 		void exec();
 };
@@ -242,8 +242,7 @@ vector<pair<vector<int>,ObjectSensorReading> > PVisualizer::readEstimationFile(c
 									y = atof((char*) temp);
 									xmlFree(temp);
 									
-									obs.observation.rho = sqrt((x * x) + (y * y));
-									obs.observation.theta = atan2(y,x);
+									obs.observation.setCartesian(PTracking::Point2f(x,y));
 									
 									observations.push_back(obs);
 								}
@@ -4,6 +4,7 @@
 #include <Utils/Utils.h>
 #include <Manfield/filters/gmlocalizer/structs.h>
 #include <inttypes.h>
+#include <string.h>
 
 namespace PTracking
 {
@@ -14,7 +15,96 @@ namespace PTracking
 	 */
 	class AgentPacket
 	{
+		private:
+			/**
+			 * @brief size of the field holding the sender address in a binary packet (NUL-padded).
+			 */
+			static const unsigned int BINARY_IP_SIZE = 16;
+			
+			/**
+			 * @brief Function that appends an unsigned integer to a buffer in little-endian order.
+			 * 
+			 * @param buffer reference to the buffer.
+			 * @param value value to be appended.
+			 * @param bytes number of bytes of the value.
+			 */
+			inline static void putUnsigned(std::string& buffer, uint64_t value, int bytes)
+			{
+				for (int i = 0; i < bytes; ++i, value >>= 8) buffer.push_back((char) (value & 0xFF));
+			}
+			
+			/**
+			 * @brief Function that appends a float to a buffer in little-endian order.
+			 * 
+			 * @param buffer reference to the buffer.
+			 * @param value value to be appended.
+			 */
+			inline static void putFloat(std::string& buffer, float value)
+			{
+				uint32_t bits;
+				
+				memcpy(&bits,&value,sizeof(bits));
+				
+				putUnsigned(buffer,bits,sizeof(bits));
+			}
+			
+			/**
+			 * @brief Function that reads an unsigned integer stored in little-endian order, advancing the read position.
+			 * 
+			 * @param data reference to the read position.
+			 * @param bytes number of bytes of the value.
+			 * 
+			 * @return the value read.
+			 */
+			inline static uint64_t getUnsigned(const char*& data, int bytes)
+			{
+				uint64_t value = 0;
+				
+				for (int i = bytes - 1; i >= 0; --i) value = (value << 8) | (uint8_t) data[i];
+				
+				data += bytes;
+				
+				return value;
+			}
+			
+			/**
+			 * @brief Function that reads a float stored in little-endian order, advancing the read position.
+			 * 
+			 * @param data reference to the read position.
+			 * 
+			 * @return the value read.
+			 */
+			inline static float getFloat(const char*& data)
+			{
+				const uint32_t bits = getUnsigned(data,sizeof(bits));
+				float value;
+				
+				memcpy(&value,&bits,sizeof(value));
+				
+				return value;
+			}
+			
 		public:
+			/**
+			 * @brief first byte of a binary packet, it can not be the first character of a text packet.
+			 */
+			static const uint8_t BINARY_MAGIC = 0xA5;
+			
+			/**
+			 * @brief version of the binary layout.
+			 */
+			static const uint8_t BINARY_VERSION = 1;
+			
+			/**
+			 * @brief size of the header of a binary packet: magic, version, address, port, agent pose, timestamp and number of estimations.
+			 */
+			static const unsigned int BINARY_HEADER_SIZE = 2 + BINARY_IP_SIZE + 2 + 12 + 8 + 2;
+			
+			/**
+			 * @brief size of an estimation in a binary packet: identity, cartesian position, sigma, width, height and barycenter (16 bits each), velocity and averaged velocity.
+			 */
+			static const unsigned int BINARY_ESTIMATION_SIZE = 4 + 8 + 8 + 6 + 8 + 8;
+			
 			/**
 			 * @struct Data
 			 * 
@@ -80,17 +170,132 @@ namespace PTracking
 				for (int i = 0; i < size; ++i)
 				{
 					ObjectSensorReading::Observation o;
+					float rho, theta;
 					int targetIdentity;
 					
-					app >> targetIdentity >> o.observation.rho >> o.observation.theta >> o.sigma.x >> o.sigma.y
+					app >> targetIdentity >> rho >> theta >> o.sigma.x >> o.sigma.y
 						>> o.model.width >> o.model.height >> o.model.barycenter >> o.model.velocity.x >> o.model.velocity.y >> o.model.averagedVelocity.x >> o.model.averagedVelocity.y;
 					
+					o.observation = PolarPoint(theta,rho);
+					
 					dataPacket.estimatedTargetModels.insert(std::make_pair(targetIdentity,std::make_pair(o,o.sigma)));
 				}
 				
 				app >> dataPacket.particlesTimestamp;
 			}
 			
+			/**
+			 * @brief Function that fills the packet fields by decoding a binary packet, reading directly from the buffer where it has been received.
+			 * 
+			 * @param data pointer to the packet.
+			 * @param size size of the packet.
+			 * 
+			 * @return \b true if the packet has been decoded, \b false if it is truncated or its version is unknown.
+			 */
+			inline bool fromBinary(const char* data, size_t size)
+			{
+				if ((size < BINARY_HEADER_SIZE) || ((uint8_t) data[0] != BINARY_MAGIC) || ((uint8_t) data[1] != BINARY_VERSION)) return false;
+				
+				data += 2;
+				
+				dataPacket.ip.assign(data,strnlen(data,BINARY_IP_SIZE));
+				data += BINARY_IP_SIZE;
+				
+				dataPacket.port = getUnsigned(data,2);
+				dataPacket.agentPose.x = getFloat(data);
+				dataPacket.agentPose.y = getFloat(data);
+				dataPacket.agentPose.theta = getFloat(data);
+				dataPacket.particlesTimestamp = getUnsigned(data,8);
+				
+				const unsigned int estimations = getUnsigned(data,2);
+				
+				if (size < (BINARY_HEADER_SIZE + (estimations * BINARY_ESTIMATION_SIZE))) return false;
+				
+				dataPacket.estimatedTargetModels.clear();
+				
+				for (unsigned int i = 0; i < estimations; ++i)
+				{
+					ObjectSensorReading::Observation o;
+					Point2f position;
+					int targetIdentity;
+					
+					targetIdentity = (int32_t) getUnsigned(data,4);
+					position.x = getFloat(data);
+					position.y = getFloat(data);
+					o.sigma.x = getFloat(data);
+					o.sigma.y = getFloat(data);
+					o.model.width = (int16_t) getUnsigned(data,2);
+					o.model.height = (int16_t) getUnsigned(data,2);
+					o.model.barycenter = (int16_t) getUnsigned(data,2);
+					o.model.velocity.x = getFloat(data);
+					o.model.velocity.y = getFloat(data);
+					o.model.averagedVelocity.x = getFloat(data);
+					o.model.averagedVelocity.y = getFloat(data);
+					
+					o.observation.setCartesian(position);
+					
+					dataPacket.estimatedTargetModels.insert(std::make_pair(targetIdentity,std::make_pair(o,o.sigma)));
+				}
+				
+				return true;
+			}
+			
+			/**
+			 * @brief Function that checks whether a packet is binary, otherwise it is a text one.
+			 * 
+			 * @param data pointer to the packet.
+			 * @param size size of the packet.
+			 * 
+			 * @return \b true if the packet starts with BINARY_MAGIC, \b false otherwise.
+			 */
+			inline static bool isBinary(const char* data, size_t size) { return (size > 0) && ((uint8_t) data[0] == BINARY_MAGIC); }
+			
+			/**
+			 * @brief Function that encodes the packet information in the binary format (fixed layout, little-endian).
+			 * 
+			 * Unlike toString(), the values are not rounded and the position of the estimations is sent in cartesian form.
+			 * 
+			 * @return a buffer containing the binary packet.
+			 */
+			inline std::string toBinary() const
+			{
+				std::string buffer;
+				
+				buffer.reserve(BINARY_HEADER_SIZE + (dataPacket.estimatedTargetModels.size() * BINARY_ESTIMATION_SIZE));
+				
+				buffer.push_back((char) BINARY_MAGIC);
+				buffer.push_back((char) BINARY_VERSION);
+				buffer.append(dataPacket.ip,0,BINARY_IP_SIZE);
+				buffer.append(BINARY_IP_SIZE - std::min(dataPacket.ip.size(),(size_t) BINARY_IP_SIZE),'\0');
+				
+				putUnsigned(buffer,dataPacket.port,2);
+				putFloat(buffer,dataPacket.agentPose.x);
+				putFloat(buffer,dataPacket.agentPose.y);
+				putFloat(buffer,dataPacket.agentPose.theta);
+				putUnsigned(buffer,dataPacket.particlesTimestamp,8);
+				putUnsigned(buffer,dataPacket.estimatedTargetModels.size(),2);
+				
+				for (std::map<int,std::pair<ObjectSensorReading::Observation,Point2f> >::const_iterator it = dataPacket.estimatedTargetModels.begin(); it != dataPacket.estimatedTargetModels.end(); ++it)
+				{
+					const ObjectSensorReading::Observation& o = it->second.first;
+					
+					putUnsigned(buffer,(uint32_t) it->first,4);
+					putFloat(buffer,o.observation.getCartesian().x);
+					putFloat(buffer,o.observation.getCartesian().y);
+					putFloat(buffer,o.sigma.x);
+					putFloat(buffer,o.sigma.y);
+					putUnsigned(buffer,(uint16_t) o.model.width,2);
+					putUnsigned(buffer,(uint16_t) o.model.height,2);
+					putUnsigned(buffer,(uint16_t) o.model.barycenter,2);
+					putFloat(buffer,o.model.velocity.x);
+					putFloat(buffer,o.model.velocity.y);
+					putFloat(buffer,o.model.averagedVelocity.x);
+					putFloat(buffer,o.model.averagedVelocity.y);
+				}
+				
+				return buffer;
+			}
+			
 			/**
 			 * @brief Function that converts the packet information into a string.
 			 * 
@@ -106,7 +311,7 @@ namespace PTracking
 				
 				for (std::map<int,std::pair<ObjectSensorReading::Observation,Point2f> >::iterator it = dataPacket.estimatedTargetModels.begin(); it != dataPacket.estimatedTargetModels.end(); ++it)
 				{
-					app << " " << it->first << " " << Utils::roundN(it->second.first.observation.rho,2) << " " << Utils::roundN(it->second.first.observation.theta,2)
+					app << " " << it->first << " " << Utils::roundN(it->second.first.observation.getRho(),2) << " " << Utils::roundN(it->second.first.observation.getTheta(),2)
 						<< " " << Utils::roundN(it->second.first.sigma.x,2) << " " << Utils::roundN(it->second.first.sigma.y,2)
 						<< " " << it->second.first.model.width << " " << it->second.first.model.height << " " << it->second.first.model.barycenter << " " << it->second.first.model.velocity.x
 						<< " " << it->second.first.model.velocity.y << " " << it->second.first.model.averagedVelocity.x << " " << it->second.first.model.averagedVelocity.y;
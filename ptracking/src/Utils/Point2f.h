@@ -38,15 +38,6 @@ namespace PTracking
 		 */
 		Point2(Numeric x, Numeric y) : x(x), y(y) {;}
 		
-		/**
-		 * @brief Constructor that takes a Point as initialization value.
-		 * 
-		 * It initializes x and y with the point given in input.
-		 * 
-		 * @param p reference to the new point.
-		 */
-		Point2(const Point2<Numeric>& p) : x(p.x), y(p.y) {;}
-		
 		/**
 		 * @brief Operator that computes the difference of two points.
 		 * 
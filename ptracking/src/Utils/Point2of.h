@@ -45,15 +45,6 @@ namespace PTracking
 			 */
 			explicit Point2o(const Point2<Numeric>& p, float theta = 0) : Point2<Numeric>(p), theta(theta) {;}
 			
-			/**
-			 * @brief Constructor that takes a Point as initialization value.
-			 * 
-			 * It initializes x, y and theta with the point given in input.
-			 * 
-			 * @param p reference to the new point.
-			 */
-			Point2o(const Point2o<Numeric>& p) : Point2<Numeric>(p.x,p.y), theta(p.theta) {;}
-			
 			/**
 			 * @brief Operator that computes the difference of two points with orientation.
 			 * 
@@ -6,87 +6,100 @@
 namespace PTracking
 {
 	/**
-	 * @struct PolarPoint
+	 * @class PolarPoint
 	 * 
-	 * @brief Struct that represents a polar point.
+	 * @brief Class that represents a polar point.
+	 * 
+	 * The point is stored in cartesian form, the one used by the filters at every iteration, while rho and theta are computed only when requested.
 	 */
-	struct PolarPoint
+	class PolarPoint
 	{
-		/**
-		 * @brief module of the point.
-		 */
-		float rho;
-		
-		/**
-		 * @brief orientation of the point.
-		 */
-		float theta;
+		private:
+			/**
+			 * @brief cartesian form of the point.
+			 */
+			Point2f cartesian;
 		
-		/**
-		 * @brief Constructor that takes rho and theta as initialization values.
-		 * 
-		 * It initializes rho and theta with the values given in input.
-		 * 
-		 * @param theta value of the orientation.
-		 * @param rho value of the module.
-		 */
-		PolarPoint(float theta = 0.0, float rho = 0.0) : rho(rho), theta(theta) {;}
-		
-		/**
-		 * @brief Operator that computes the sum of two polar points.
-		 * 
-		 * @param p reference to the polar point that we want to sum to the current one.
-		 * 
-		 * @return a new polar point obtained by summing the x and y component of the current polar point and p.
-		 */
-		PolarPoint operator+ (const PolarPoint& p) const
-		{
-			float x = rho * cos(theta) + p.rho * cos(p.theta);
-			float y = rho * sin(theta) + p.rho * sin(p.theta);
+		public:
+			/**
+			 * @brief Constructor that takes rho and theta as initialization values.
+			 * 
+			 * It initializes the point with the values given in input.
+			 * 
+			 * @param theta value of the orientation.
+			 * @param rho value of the module.
+			 */
+			PolarPoint(float theta = 0.0, float rho = 0.0) : cartesian(Point2f(cos(theta),sin(theta)) * rho) {;}
 			
-			if ((x == 0) && (y == 0)) return PolarPoint(0,0);
-			else return PolarPoint(atan2(y,x),sqrt((x * x) + (y * y)));
-		}
-		
-		/**
-		 * @brief Operator that computes the difference of two polar points.
-		 * 
-		 * @param p reference to the polar point that we want to subtract to the current one.
-		 * 
-		 * @return a new polar point obtained by subtracting the x and y component of the current polar point and p.
-		 */
-		PolarPoint operator- (const PolarPoint& p) const
-		{
-			PolarPoint np(p);
+			/**
+			 * @brief Constructor that takes the cartesian form of the point as initialization value.
+			 * 
+			 * @param cartesian reference to the cartesian form of the point.
+			 */
+			explicit PolarPoint(const Point2f& cartesian) : cartesian(cartesian) {;}
 			
-			np.theta -= M_PI;
+			/**
+			 * @brief Operator that computes the sum of two polar points.
+			 * 
+			 * @param p reference to the polar point that we want to sum to the current one.
+			 * 
+			 * @return a new polar point obtained by summing the x and y component of the current polar point and p.
+			 */
+			PolarPoint operator+ (const PolarPoint& p) const { return PolarPoint(cartesian + p.cartesian); }
 			
-			return *this + np;
-		}
-		
-		/**
-		 * @brief Operator that checks if the current polar point has an orientation less than the one of the polar point given in input.
-		 * 
-		 * @param p reference to the polar point that we want to compare with the current one.
-		 * 
-		 * @return \b true if the current polar point has an orientation less than the orientation of p, \b false otherwise.
-		 */
-		bool operator< (const PolarPoint& p) const { return theta < p.theta; }
-		
-		/**
-		 * @brief Operator that checks if two polar points are equal.
-		 * 
-		 * @param p reference to the polar point that we want to compare with the current one.
-		 * 
-		 * @return \b true if the current polar point and p are equal, \b false otherwise.
-		 */
-		bool operator== (const PolarPoint& p) { return (theta == p.theta) && (rho == p.rho); }
-		
-		/**
-		 * @brief Function that returns the cartesian point.
-		 * 
-		 * @return the cartesian form of the current polar point.
-		 */
-		Point2f getCartesian() const { return Point2f(cos(theta),sin(theta)) * rho; }
+			/**
+			 * @brief Operator that computes the difference of two polar points.
+			 * 
+			 * @param p reference to the polar point that we want to subtract to the current one.
+			 * 
+			 * @return a new polar point obtained by subtracting the x and y component of the current polar point and p.
+			 */
+			PolarPoint operator- (const PolarPoint& p) const { return PolarPoint(cartesian - p.cartesian); }
+			
+			/**
+			 * @brief Operator that checks if the current polar point has an orientation less than the one of the polar point given in input.
+			 * 
+			 * @param p reference to the polar point that we want to compare with the current one.
+			 * 
+			 * @return \b true if the current polar point has an orientation less than the orientation of p, \b false otherwise.
+			 */
+			bool operator< (const PolarPoint& p) const { return getTheta() < p.getTheta(); }
+			
+			/**
+			 * @brief Operator that checks if two polar points are equal.
+			 * 
+			 * @param p reference to the polar point that we want to compare with the current one.
+			 * 
+			 * @return \b true if the current polar point and p are equal, \b false otherwise.
+			 */
+			bool operator== (const PolarPoint& p) const { return (cartesian.x == p.cartesian.x) && (cartesian.y == p.cartesian.y); }
+			
+			/**
+			 * @brief Function that returns the cartesian point.
+			 * 
+			 * @return the cartesian form of the current polar point.
+			 */
+			inline const Point2f& getCartesian() const { return cartesian; }
+			
+			/**
+			 * @brief Function that returns the module of the point.
+			 * 
+			 * @return the module of the current polar point.
+			 */
+			inline float getRho() const { return cartesian.mod(); }
+			
+			/**
+			 * @brief Function that returns the orientation of the point.
+			 * 
+			 * @return the orientation of the current polar point, within [-M_PI,M_PI].
+			 */
+			inline float getTheta() const { return atan2(cartesian.y,cartesian.x); }
+			
+			/**
+			 * @brief Function that updates the point with its cartesian form.
+			 * 
+			 * @param cartesian reference to the new cartesian form of the point.
+			 */
+			inline void setCartesian(const Point2f& cartesian) { this->cartesian = cartesian; }
 	};
 }
@@ -0,0 +1,154 @@
+#include "Random.h"
+#include <math.h>
+#include <pthread.h>
+
+namespace PTracking
+{
+	namespace
+	{
+		/// Number of thread generators created so far, every one of them gets its own stream.
+		uint64_t streams = 0;
+		
+		pthread_key_t localKey;
+		pthread_once_t localKeyOnce = PTHREAD_ONCE_INIT;
+		
+		void deleteLocal(void* generator)
+		{
+			delete static_cast<Random*>(generator);
+		}
+		
+		void createLocalKey()
+		{
+			pthread_key_create(&localKey,deleteLocal);
+		}
+		
+		uint64_t splitMix64(uint64_t& x)
+		{
+			uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+			
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			
+			return z ^ (z >> 31);
+		}
+		
+		/// Uniform number in (0,1], suitable for a logarithm.
+		inline float positiveUniform(Random& random)
+		{
+			return ((random.next() >> 40) + 1) * (1.0f / 16777216.0f);
+		}
+		
+		/**
+		 * @brief Tables of the 128 layers of the Ziggurat of Marsaglia and Tsang for the standard normal distribution.
+		 */
+		struct Ziggurat
+		{
+			static const int LAYERS = 128;
+			
+			/// Start of the tail.
+			static const float R;
+			
+			/// Magnitude below which a sample falls inside the rectangle of its layer.
+			uint32_t k[LAYERS];
+			
+			/// Width of the layers, scaled by 2^-31.
+			float w[LAYERS];
+			
+			/// Density at the top of the layers.
+			float f[LAYERS];
+			
+			Ziggurat()
+			{
+				const double m = 2147483648.0, v = 9.91256303526217e-3;
+				double d = R, t = R;
+				const double q = v / exp(-0.5 * d * d);
+				
+				k[0] = (uint32_t) ((d / q) * m);
+				k[1] = 0;
+				w[0] = q / m;
+				w[LAYERS - 1] = d / m;
+				f[0] = 1.0;
+				f[LAYERS - 1] = exp(-0.5 * d * d);
+				
+				for (int i = LAYERS - 2; i >= 1; --i)
+				{
+					d = sqrt(-2.0 * log((v / d) + exp(-0.5 * d * d)));
+					k[i + 1] = (uint32_t) ((d / t) * m);
+					t = d;
+					f[i] = exp(-0.5 * d * d);
+					w[i] = d / m;
+				}
+			}
+		};
+		
+		const float Ziggurat::R = 3.442619855899f;
+		
+		const Ziggurat ziggurat;
+		
+		/// Standard normal number, the slow path is taken by about 1% of the samples.
+		inline float standardNormal(Random& random)
+		{
+			for (;;)
+			{
+				const int32_t h = (int32_t) (random.next() >> 32);
+				const int i = h & (Ziggurat::LAYERS - 1);
+				const uint32_t magnitude = (h < 0) ? (0U - (uint32_t) h) : (uint32_t) h;
+				const float x = h * ziggurat.w[i];
+				
+				if (magnitude < ziggurat.k[i]) return x;
+				
+				if (i == 0)
+				{
+					float tx, ty;
+					
+					/// Tail beyond R.
+					do
+					{
+						tx = -logf(positiveUniform(random)) / Ziggurat::R;
+						ty = -logf(positiveUniform(random));
+					}
+					while ((ty + ty) < (tx * tx));
+					
+					return (h > 0) ? (Ziggurat::R + tx) : (-Ziggurat::R - tx);
+				}
+				
+				if ((ziggurat.f[i] + (random.uniform() * (ziggurat.f[i - 1] - ziggurat.f[i]))) < expf(-0.5f * x * x)) return x;
+			}
+		}
+	}
+	
+	Random::Random(uint64_t seed)
+	{
+		for (int i = 0; i < 4; ++i) state[i] = splitMix64(seed);
+	}
+	
+	float Random::gaussian(float sigma)
+	{
+		float value;
+		
+		gaussians(&value,1,sigma);
+		
+		return value;
+	}
+	
+	void Random::gaussians(float* values, unsigned int n, float sigma)
+	{
+		for (unsigned int i = 0; i < n; ++i) values[i] = sigma * standardNormal(*this);
+	}
+	
+	Random& Random::local()
+	{
+		pthread_once(&localKeyOnce,createLocalKey);
+		
+		Random* generator = static_cast<Random*>(pthread_getspecific(localKey));
+		
+		if (generator == 0)
+		{
+			generator = new Random(__sync_fetch_and_add(&streams,1));
+			
+			pthread_setspecific(localKey,generator);
+		}
+		
+		return *generator;
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace PTracking
+{
+	/**
+	 * @class Random
+	 * 
+	 * @brief Class that implements the xoshiro256+ pseudo-random number generator, with a Ziggurat Gaussian sampler.
+	 * 
+	 * A generator must not be shared among threads: local() returns a generator owned by the calling thread, seeded with a different stream for every thread.
+	 */
+	class Random
+	{
+		private:
+			/**
+			 * @brief state of the generator.
+			 */
+			uint64_t state[4];
+			
+			/**
+			 * @brief Function that rotates a 64 bits word to the left.
+			 * 
+			 * @param x word to be rotated.
+			 * @param k number of bits.
+			 * 
+			 * @return the rotated word.
+			 */
+			inline static uint64_t rotate(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+			
+		public:
+			/**
+			 * @brief Constructor that takes a seed as initialization value.
+			 * 
+			 * @param seed seed of the generator, expanded with splitmix64.
+			 */
+			explicit Random(uint64_t seed);
+			
+			/**
+			 * @brief Function that generates a number with a Gaussian distribution having zero mean and a specified standard deviation.
+			 * 
+			 * @param sigma standard deviation of the Gaussian distribution.
+			 * 
+			 * @return the generated number.
+			 */
+			float gaussian(float sigma);
+			
+			/**
+			 * @brief Function that generates a batch of numbers with a Gaussian distribution having zero mean and a specified standard deviation (Ziggurat).
+			 * 
+			 * @param values pointer to the array where the numbers are stored.
+			 * @param n number of numbers to be generated.
+			 * @param sigma standard deviation of the Gaussian distribution.
+			 */
+			void gaussians(float* values, unsigned int n, float sigma);
+			
+			/**
+			 * @brief Function that returns the generator of the calling thread, creating it on the first call.
+			 * 
+			 * @return a reference to the generator of the calling thread.
+			 */
+			static Random& local();
+			
+			/**
+			 * @brief Function that generates the next 64 random bits.
+			 * 
+			 * @return the generated bits.
+			 */
+			inline uint64_t next()
+			{
+				const uint64_t result = state[0] + state[3];
+				const uint64_t t = state[1] << 17;
+				
+				state[2] ^= state[0];
+				state[3] ^= state[1];
+				state[1] ^= state[2];
+				state[0] ^= state[3];
+				state[2] ^= t;
+				state[3] = rotate(state[3],45);
+				
+				return result;
+			}
+			
+			/**
+			 * @brief Function that generates a number with a uniform distribution in [0,1).
+			 * 
+			 * @return the generated number.
+			 */
+			inline float uniform() { return (next() >> 40) * (1.0f / 16777216.0f); }
+	};
+}
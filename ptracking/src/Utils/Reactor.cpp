@@ -0,0 +1,217 @@
+#include "Reactor.h"
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace PTracking
+{
+	Reactor* Reactor::signalReactors[NSIG];
+	
+	Reactor::Reactor() : stopSignal(0), stopping(false)
+	{
+		epoll = epoll_create1(EPOLL_CLOEXEC);
+		wakeUp = eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+		
+		if ((epoll != -1) && (wakeUp != -1))
+		{
+			struct epoll_event event;
+			
+			memset(&event,0,sizeof(struct epoll_event));
+			event.events = EPOLLIN;
+			event.data.fd = wakeUp;
+			
+			if (epoll_ctl(epoll,EPOLL_CTL_ADD,wakeUp,&event) == -1)
+			{
+				close(wakeUp);
+				wakeUp = -1;
+			}
+		}
+	}
+	
+	Reactor::~Reactor()
+	{
+		for (map<int,struct sigaction>::const_iterator it = previousActions.begin(); it != previousActions.end(); ++it)
+		{
+			sigaction(it->first,&it->second,0);
+			signalReactors[it->first] = 0;
+		}
+		
+		for (map<int,Handler>::const_iterator it = handlers.begin(); it != handlers.end(); ++it)
+		{
+			if (it->second.timer) close(it->first);
+		}
+		
+		if (wakeUp != -1) close(wakeUp);
+		if (epoll != -1) close(epoll);
+	}
+	
+	bool Reactor::add(int descriptor, Callback callback, void* context, bool timer)
+	{
+		if (!isValid() || (descriptor < 0) || (handlers.find(descriptor) != handlers.end())) return false;
+		
+		struct epoll_event event;
+		
+		memset(&event,0,sizeof(struct epoll_event));
+		event.events = EPOLLIN;
+		event.data.fd = descriptor;
+		
+		if (epoll_ctl(epoll,EPOLL_CTL_ADD,descriptor,&event) == -1) return false;
+		
+		Handler& handler = handlers[descriptor];
+		
+		handler.callback = callback;
+		handler.context = context;
+		handler.timer = timer;
+		
+		return true;
+	}
+	
+	bool Reactor::addSocket(int socket, Callback callback, void* context)
+	{
+		return add(socket,callback,context,false);
+	}
+	
+	int Reactor::addTimer(float periodMs, Callback callback, void* context)
+	{
+		if (periodMs <= 0.0) return -1;
+		
+		const int timer = timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK | TFD_CLOEXEC);
+		
+		if (timer == -1) return -1;
+		
+		struct itimerspec period;
+		
+		period.it_interval.tv_sec = (time_t) (periodMs / 1000.0);
+		period.it_interval.tv_nsec = (long) ((periodMs - (period.it_interval.tv_sec * 1000.0)) * 1e6);
+		
+		/// A period shorter than a nanosecond would disarm the timer.
+		if ((period.it_interval.tv_sec == 0) && (period.it_interval.tv_nsec == 0)) period.it_interval.tv_nsec = 1;
+		
+		period.it_value = period.it_interval;
+		
+		if ((timerfd_settime(timer,0,&period,0) == -1) || !add(timer,callback,context,true))
+		{
+			close(timer);
+			
+			return -1;
+		}
+		
+		return timer;
+	}
+	
+	bool Reactor::remove(int descriptor)
+	{
+		map<int,Handler>::iterator it = handlers.find(descriptor);
+		
+		if (it == handlers.end()) return false;
+		
+		epoll_ctl(epoll,EPOLL_CTL_DEL,descriptor,0);
+		
+		if (it->second.timer) close(descriptor);
+		
+		handlers.erase(it);
+		
+		return true;
+	}
+	
+	void Reactor::run()
+	{
+		struct epoll_event events[MAX_EVENTS];
+		
+		if (!isValid()) return;
+		
+		while (!__atomic_load_n(&stopping,__ATOMIC_ACQUIRE))
+		{
+			const int ready = epoll_wait(epoll,events,MAX_EVENTS,-1);
+			
+			if (ready == -1)
+			{
+				if (errno == EINTR) continue;
+				
+				break;
+			}
+			
+			for (int i = 0; (i < ready) && !__atomic_load_n(&stopping,__ATOMIC_ACQUIRE); ++i)
+			{
+				/// The handler could have been removed by a callback of the same batch.
+				map<int,Handler>::const_iterator it = handlers.find(events[i].data.fd);
+				
+				if (it == handlers.end()) continue;
+				
+				const Handler handler = it->second;
+				
+				if (handler.timer)
+				{
+					uint64_t expirations;
+					
+					if (read(events[i].data.fd,&expirations,sizeof(uint64_t)) != sizeof(uint64_t)) continue;
+				}
+				
+				handler.callback(handler.context);
+			}
+		}
+		
+		/// The loop can be run again, hence the stop request is consumed together with the wake up.
+		uint64_t wakeUps;
+		
+		const ssize_t drained = read(wakeUp,&wakeUps,sizeof(uint64_t));
+		
+		(void) drained;
+		
+		__atomic_store_n(&stopping,false,__ATOMIC_RELEASE);
+	}
+	
+	void Reactor::signalHandler(int signum)
+	{
+		Reactor* reactor = signalReactors[signum];
+		
+		if (reactor != 0)
+		{
+			reactor->stopSignal = signum;
+			reactor->stop();
+		}
+	}
+	
+	void Reactor::stop()
+	{
+		const uint64_t one = 1;
+		
+		__atomic_store_n(&stopping,true,__ATOMIC_RELEASE);
+		
+		/// write() is async-signal-safe, if it fails the eventfd is already readable.
+		const ssize_t written = write(wakeUp,&one,sizeof(uint64_t));
+		
+		(void) written;
+	}
+	
+	bool Reactor::stopOnSignal(int signum)
+	{
+		if ((signum <= 0) || (signum >= NSIG) || ((signalReactors[signum] != 0) && (signalReactors[signum] != this))) return false;
+		
+		struct sigaction action, previousAction;
+		
+		memset(&action,0,sizeof(struct sigaction));
+		action.sa_handler = signalHandler;
+		sigemptyset(&action.sa_mask);
+		
+		signalReactors[signum] = this;
+		
+		if (sigaction(signum,&action,&previousAction) == -1)
+		{
+			signalReactors[signum] = 0;
+			
+			return false;
+		}
+		
+		/// The action to be restored is the one before the first call.
+		previousActions.insert(make_pair(signum,previousAction));
+		
+		return true;
+	}
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <signal.h>
+#include <map>
+
+namespace PTracking
+{
+	/**
+	 * @class Reactor
+	 * 
+	 * @brief Class that implements an event loop based on epoll, dispatching the readable sockets and the expired timers to their callbacks.
+	 * 
+	 * All the callbacks are executed by the thread running the loop, hence several agents can share a single thread without any locking among them. The sockets and
+	 * the timers must be added and removed either before the loop runs or by its callbacks, while stop() can be called by any thread and by a signal handler.
+	 */
+	class Reactor
+	{
+		public:
+			/**
+			 * @brief Function executed when a socket is readable or a timer expires.
+			 */
+			typedef void (*Callback)(void* context);
+			
+		private:
+			/**
+			 * @struct Handler
+			 * 
+			 * @brief Struct that represents a socket or a timer registered in the loop.
+			 */
+			struct Handler
+			{
+				Callback callback;
+				void* context;
+				bool timer;
+			};
+			
+			/**
+			 * @brief maximum number of events dispatched for a single epoll_wait.
+			 */
+			static const int MAX_EVENTS = 64;
+			
+			/**
+			 * @brief reactors stopped by every signal.
+			 */
+			static Reactor* signalReactors[NSIG];
+			
+			/**
+			 * @brief handlers of the loop, indexed by descriptor.
+			 */
+			std::map<int,Handler> handlers;
+			
+			/**
+			 * @brief actions of the signals before stopOnSignal(), restored by the destructor.
+			 */
+			std::map<int,struct sigaction> previousActions;
+			
+			/**
+			 * @brief epoll descriptor.
+			 */
+			int epoll;
+			
+			/**
+			 * @brief eventfd descriptor waking up the loop when it has to stop.
+			 */
+			int wakeUp;
+			
+			/**
+			 * @brief signal that stopped the loop, 0 if none.
+			 */
+			volatile sig_atomic_t stopSignal;
+			
+			/**
+			 * @brief true when the loop has to stop.
+			 */
+			bool stopping;
+			
+			Reactor(const Reactor&);
+			Reactor& operator=(const Reactor&);
+			
+			/**
+			 * @brief Function that stops the reactor registered for a signal.
+			 * 
+			 * @param signum signal received.
+			 */
+			static void signalHandler(int signum);
+			
+			/**
+			 * @brief Function that adds a descriptor to the epoll set.
+			 * 
+			 * @param descriptor descriptor to be added.
+			 * @param callback function executed when the descriptor is readable.
+			 * @param context argument of the callback.
+			 * @param timer true if the descriptor is a timerfd.
+			 * 
+			 * @return \b true if succeeded, \b false otherwise.
+			 */
+			bool add(int descriptor, Callback callback, void* context, bool timer);
+			
+		public:
+			/**
+			 * @brief Empty constructor.
+			 * 
+			 * It creates the epoll set, the loop is usable only if isValid() returns true.
+			 */
+			Reactor();
+			
+			/**
+			 * @brief Destructor.
+			 * 
+			 * It closes the timers and restores the signal actions replaced by stopOnSignal(), the sockets are left open.
+			 */
+			~Reactor();
+			
+			/**
+			 * @brief Function that registers a socket, the callback is executed as long as the socket has data to be read.
+			 * 
+			 * @param socket descriptor of the socket.
+			 * @param callback function executed when the socket is readable.
+			 * @param context argument of the callback.
+			 * 
+			 * @return \b true if succeeded, \b false otherwise.
+			 */
+			bool addSocket(int socket, Callback callback, void* context);
+			
+			/**
+			 * @brief Function that registers a periodic timer, the expirations missed while a callback runs are collapsed in a single one.
+			 * 
+			 * @param periodMs period of the timer (in ms).
+			 * @param callback function executed when the timer expires.
+			 * @param context argument of the callback.
+			 * 
+			 * @return the descriptor of the timer, -1 if the timer could not be created.
+			 */
+			int addTimer(float periodMs, Callback callback, void* context);
+			
+			/**
+			 * @brief Function that returns the signal that stopped the loop.
+			 * 
+			 * @return the signal that stopped the loop, 0 if it has not been stopped by a signal.
+			 */
+			inline int getStopSignal() const { return stopSignal; }
+			
+			/**
+			 * @brief Function that checks if the epoll set has been created.
+			 * 
+			 * @return \b true if the reactor is usable, \b false otherwise.
+			 */
+			inline bool isValid() const { return (epoll != -1) && (wakeUp != -1); }
+			
+			/**
+			 * @brief Function that unregisters a socket or a timer, closing the timer.
+			 * 
+			 * @param descriptor descriptor of the socket or of the timer.
+			 * 
+			 * @return \b true if succeeded, \b false if the descriptor was not registered.
+			 */
+			bool remove(int descriptor);
+			
+			/**
+			 * @brief Function that dispatches the events to the callbacks until stop() is called. It returns immediately if the reactor has already been stopped.
+			 * 
+			 * The stop request is consumed when it returns, so that the loop can be run again.
+			 */
+			void run();
+			
+			/**
+			 * @brief Function that makes run() return once the callback being executed (if any) has finished. It is async-signal-safe.
+			 */
+			void stop();
+			
+			/**
+			 * @brief Function that makes a signal stop the loop, instead of executing its previous action.
+			 * 
+			 * @param signum signal stopping the loop.
+			 * 
+			 * @return \b true if succeeded, \b false otherwise.
+			 */
+			bool stopOnSignal(int signum);
+	};
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace PTracking
+{
+	/**
+	 * @class SpscQueue
+	 * 
+	 * @brief Class that implements a bounded lock-free queue between a single producer thread and a single consumer thread.
+	 * 
+	 * The elements are handed off by swapping them with the slots of a ring (through an unqualified swap, so that the overload of the element type is used),
+	 * hence neither push() nor pop() copy an element or allocate memory and neither of them ever waits for the other thread.
+	 */
+	template<typename T> class SpscQueue
+	{
+		private:
+			/**
+			 * @brief size of a cache line, the indexes are kept on different lines to avoid false sharing between the two threads.
+			 */
+			static const unsigned int CACHE_LINE = 64;
+			
+			/**
+			 * @brief ring of the elements, its size is a power of two.
+			 */
+			std::vector<T> slots;
+			
+			/**
+			 * @brief size of the ring minus one.
+			 */
+			unsigned long mask;
+			
+			char headPadding[CACHE_LINE];
+			
+			/**
+			 * @brief number of elements popped so far, written only by the consumer.
+			 */
+			unsigned long head;
+			
+			char tailPadding[CACHE_LINE];
+			
+			/**
+			 * @brief number of elements pushed so far, written only by the producer.
+			 */
+			unsigned long tail;
+			
+			SpscQueue(const SpscQueue&);
+			SpscQueue& operator=(const SpscQueue&);
+			
+		public:
+			/**
+			 * @brief Constructor that takes the capacity of the queue as initialization value.
+			 * 
+			 * @param capacity minimum number of elements that the queue can hold (rounded up to a power of two).
+			 */
+			explicit SpscQueue(unsigned long capacity) : head(0), tail(0)
+			{
+				unsigned long size = 1;
+				
+				while (size < capacity) size <<= 1;
+				
+				slots.resize(size);
+				mask = size - 1;
+			}
+			
+			/**
+			 * @brief Function that returns the number of elements that the queue can hold.
+			 * 
+			 * @return the capacity of the queue.
+			 */
+			inline unsigned long capacity() const { return slots.size(); }
+			
+			/**
+			 * @brief Function that removes the oldest element of the queue. It must be called only by the consumer thread.
+			 * 
+			 * @param element reference to the element where the removed one is stored (its previous value is left in the queue, to be reused by the producer).
+			 * 
+			 * @return \b true if an element has been removed, \b false if the queue is empty.
+			 */
+			bool pop(T& element)
+			{
+				const unsigned long position = head;
+				
+				if (__atomic_load_n(&tail,__ATOMIC_ACQUIRE) == position) return false;
+				
+				using std::swap;
+				
+				swap(element,slots[position & mask]);
+				
+				__atomic_store_n(&head,position + 1,__ATOMIC_RELEASE);
+				
+				return true;
+			}
+			
+			/**
+			 * @brief Function that appends an element to the queue. It must be called only by the producer thread.
+			 * 
+			 * @param element reference to the element to be appended (it gets an unspecified value if the element has been appended).
+			 * 
+			 * @return \b true if the element has been appended, \b false if the queue is full.
+			 */
+			bool push(T& element)
+			{
+				const unsigned long position = tail;
+				
+				if ((position - __atomic_load_n(&head,__ATOMIC_ACQUIRE)) == slots.size()) return false;
+				
+				using std::swap;
+				
+				swap(slots[position & mask],element);
+				
+				__atomic_store_n(&tail,position + 1,__ATOMIC_RELEASE);
+				
+				return true;
+			}
+	};
+}
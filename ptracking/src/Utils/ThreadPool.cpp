@@ -0,0 +1,187 @@
+#include "ThreadPool.h"
+#include <unistd.h>
+
+namespace PTracking
+{
+	ThreadPool::ThreadPool(unsigned int numThreads) : task(0), context(0), generation(0), numThreads((numThreads == 0) ? 1 : numThreads), busyWorkers(0), stopping(false)
+	{
+		pthread_mutex_init(&mutex,0);
+		pthread_mutex_init(&runMutex,0);
+		pthread_cond_init(&wakeUp,0);
+		pthread_cond_init(&finished,0);
+		
+		queues.resize(this->numThreads);
+		
+		for (unsigned int i = 0; i < this->numThreads; ++i)
+		{
+			pthread_mutex_init(&queues[i].mutex,0);
+			queues[i].begin = 0;
+			queues[i].end = 0;
+		}
+		
+		/// The calling thread acts as worker 0.
+		workers.resize(this->numThreads);
+		threads.resize(this->numThreads);
+		
+		for (unsigned int i = 1; i < this->numThreads; ++i)
+		{
+			workers[i].pool = this;
+			workers[i].id = i;
+			
+			pthread_create(&threads[i],0,workerMain,&workers[i]);
+		}
+	}
+	
+	ThreadPool::~ThreadPool()
+	{
+		pthread_mutex_lock(&mutex);
+		stopping = true;
+		pthread_cond_broadcast(&wakeUp);
+		pthread_mutex_unlock(&mutex);
+		
+		for (unsigned int i = 1; i < numThreads; ++i) pthread_join(threads[i],0);
+		
+		for (unsigned int i = 0; i < numThreads; ++i) pthread_mutex_destroy(&queues[i].mutex);
+		
+		pthread_cond_destroy(&finished);
+		pthread_cond_destroy(&wakeUp);
+		pthread_mutex_destroy(&runMutex);
+		pthread_mutex_destroy(&mutex);
+	}
+	
+	bool ThreadPool::pop(unsigned int id, unsigned int& index)
+	{
+		Queue& queue = queues[id];
+		bool found = false;
+		
+		pthread_mutex_lock(&queue.mutex);
+		
+		if (queue.begin < queue.end)
+		{
+			index = queue.begin++;
+			found = true;
+		}
+		
+		pthread_mutex_unlock(&queue.mutex);
+		
+		return found;
+	}
+	
+	void ThreadPool::run(unsigned int count, Task task, void* context)
+	{
+		if ((numThreads == 1) || (count <= 1))
+		{
+			for (unsigned int i = 0; i < count; ++i) task(context,i);
+			
+			return;
+		}
+		
+		pthread_mutex_lock(&runMutex);
+		pthread_mutex_lock(&mutex);
+		
+		/// Every thread gets a contiguous share of the indexes.
+		for (unsigned int i = 0; i < numThreads; ++i)
+		{
+			pthread_mutex_lock(&queues[i].mutex);
+			queues[i].begin = (unsigned int) (((unsigned long) count * i) / numThreads);
+			queues[i].end = (unsigned int) (((unsigned long) count * (i + 1)) / numThreads);
+			pthread_mutex_unlock(&queues[i].mutex);
+		}
+		
+		this->task = task;
+		this->context = context;
+		busyWorkers = numThreads - 1;
+		++generation;
+		
+		pthread_cond_broadcast(&wakeUp);
+		pthread_mutex_unlock(&mutex);
+		
+		work(0);
+		
+		pthread_mutex_lock(&mutex);
+		
+		while (busyWorkers > 0) pthread_cond_wait(&finished,&mutex);
+		
+		pthread_mutex_unlock(&mutex);
+		pthread_mutex_unlock(&runMutex);
+	}
+	
+	ThreadPool& ThreadPool::serial()
+	{
+		static ThreadPool pool(1);
+		
+		return pool;
+	}
+	
+	ThreadPool& ThreadPool::shared()
+	{
+		static ThreadPool pool(sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1);
+		
+		return pool;
+	}
+	
+	bool ThreadPool::steal(unsigned int id, unsigned int& index)
+	{
+		for (unsigned int i = 1; i < numThreads; ++i)
+		{
+			Queue& victim = queues[(id + i) % numThreads];
+			bool found = false;
+			
+			pthread_mutex_lock(&victim.mutex);
+			
+			if (victim.begin < victim.end)
+			{
+				index = --victim.end;
+				found = true;
+			}
+			
+			pthread_mutex_unlock(&victim.mutex);
+			
+			if (found) return true;
+		}
+		
+		return false;
+	}
+	
+	void ThreadPool::work(unsigned int id)
+	{
+		unsigned int index;
+		
+		while (pop(id,index) || steal(id,index)) task(context,index);
+	}
+	
+	void ThreadPool::workerLoop(unsigned int id)
+	{
+		unsigned long seen = 0;
+		
+		pthread_mutex_lock(&mutex);
+		
+		for (;;)
+		{
+			while (!stopping && (generation == seen)) pthread_cond_wait(&wakeUp,&mutex);
+			
+			if (stopping) break;
+			
+			seen = generation;
+			
+			pthread_mutex_unlock(&mutex);
+			
+			work(id);
+			
+			pthread_mutex_lock(&mutex);
+			
+			if (--busyWorkers == 0) pthread_cond_signal(&finished);
+		}
+		
+		pthread_mutex_unlock(&mutex);
+	}
+	
+	void* ThreadPool::workerMain(void* worker)
+	{
+		Worker* w = static_cast<Worker*>(worker);
+		
+		w->pool->workerLoop(w->id);
+		
+		return 0;
+	}
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <pthread.h>
+#include <vector>
+
+namespace PTracking
+{
+	/**
+	 * @class ThreadPool
+	 * 
+	 * @brief Class that implements a work-stealing thread pool running a batch of independent tasks.
+	 * 
+	 * Every thread gets a contiguous share of the task indexes: it executes them from the front and, once done, steals the remaining ones of the other threads
+	 * from the back. The calling thread takes part in the work, so a pool of one thread executes the tasks in order without any synchronization.
+	 */
+	class ThreadPool
+	{
+		public:
+			/**
+			 * @brief Function executed for every task index.
+			 */
+			typedef void (*Task)(void* context, unsigned int index);
+			
+		private:
+			/**
+			 * @struct Queue
+			 * 
+			 * @brief Struct that represents the range of task indexes owned by a thread.
+			 */
+			struct Queue
+			{
+				pthread_mutex_t mutex;
+				unsigned int begin;
+				unsigned int end;
+			};
+			
+			/**
+			 * @struct Worker
+			 * 
+			 * @brief Struct that represents the argument of a worker thread.
+			 */
+			struct Worker
+			{
+				ThreadPool* pool;
+				unsigned int id;
+			};
+			
+			/**
+			 * @brief queues of the threads (the calling one is the first).
+			 */
+			std::vector<Queue> queues;
+			
+			/**
+			 * @brief arguments of the worker threads.
+			 */
+			std::vector<Worker> workers;
+			
+			/**
+			 * @brief worker threads (the first one is unused).
+			 */
+			std::vector<pthread_t> threads;
+			
+			/**
+			 * @brief mutex and conditions used to start the workers and to wait for them.
+			 */
+			pthread_mutex_t mutex;
+			pthread_cond_t wakeUp, finished;
+			
+			/**
+			 * @brief mutex serializing the batches run by different threads.
+			 */
+			pthread_mutex_t runMutex;
+			
+			/**
+			 * @brief task and context of the current batch.
+			 */
+			Task task;
+			void* context;
+			
+			/**
+			 * @brief number of batches started so far.
+			 */
+			unsigned long generation;
+			
+			/**
+			 * @brief number of threads, the calling one included.
+			 */
+			unsigned int numThreads;
+			
+			/**
+			 * @brief number of workers still executing the current batch.
+			 */
+			unsigned int busyWorkers;
+			
+			/**
+			 * @brief true when the pool is being destroyed.
+			 */
+			bool stopping;
+			
+			ThreadPool(const ThreadPool&);
+			ThreadPool& operator=(const ThreadPool&);
+			
+			/**
+			 * @brief Function that pops the next task index of a thread.
+			 * 
+			 * @param id thread.
+			 * @param index reference to the popped index.
+			 * 
+			 * @return \b true if an index has been popped, \b false if the queue of the thread is empty.
+			 */
+			bool pop(unsigned int id, unsigned int& index);
+			
+			/**
+			 * @brief Function that steals a task index from the back of the queue of another thread.
+			 * 
+			 * @param id thread stealing the index.
+			 * @param index reference to the stolen index.
+			 * 
+			 * @return \b true if an index has been stolen, \b false if all the queues are empty.
+			 */
+			bool steal(unsigned int id, unsigned int& index);
+			
+			/**
+			 * @brief Function that executes tasks until all the queues are empty.
+			 * 
+			 * @param id thread executing the tasks.
+			 */
+			void work(unsigned int id);
+			
+			/**
+			 * @brief Function that waits for a batch, executes it and signals its end, until the pool is destroyed.
+			 * 
+			 * @param id worker thread.
+			 */
+			void workerLoop(unsigned int id);
+			
+			/**
+			 * @brief Entry point of the worker threads.
+			 * 
+			 * @param worker pointer to the Worker argument.
+			 */
+			static void* workerMain(void* worker);
+			
+		public:
+			/**
+			 * @brief Constructor that takes the number of threads as initialization value.
+			 * 
+			 * @param numThreads number of threads, the calling one included (0 is treated as 1).
+			 */
+			explicit ThreadPool(unsigned int numThreads);
+			
+			/**
+			 * @brief Destructor, it joins the worker threads.
+			 */
+			~ThreadPool();
+			
+			/**
+			 * @brief Function that returns the number of threads of the pool.
+			 * 
+			 * @return the number of threads, the calling one included.
+			 */
+			inline unsigned int getNumThreads() const { return numThreads; }
+			
+			/**
+			 * @brief Function that runs task(context,i) for every i in [0,count) and waits for all of them.
+			 * 
+			 * Batches run by different threads are executed one after the other, a task must not run a batch on the same pool.
+			 * 
+			 * @param count number of tasks.
+			 * @param task function executed for every task index.
+			 * @param context pointer given to every task.
+			 */
+			void run(unsigned int count, Task task, void* context);
+			
+			/**
+			 * @brief Function that returns a pool with one thread, which runs the tasks in order on the calling thread.
+			 * 
+			 * @return a reference to the serial pool.
+			 */
+			static ThreadPool& serial();
+			
+			/**
+			 * @brief Function that returns the pool shared by the whole process, with one thread for each online core.
+			 * 
+			 * @return a reference to the shared pool.
+			 */
+			static ThreadPool& shared();
+	};
+}
@@ -1,5 +1,6 @@
 #include "UdpSocket.h"
 #include <errno.h>
+#include <string.h>
 #include <sstream>
 #include <iostream>
 #include <unistd.h>
@@ -29,7 +30,24 @@ using namespace std;
 
 namespace PTracking
 {
-	UdpSocket::UdpSocket() : address(), socket(-1), bufferSize(UDP_SOCKET_DEFAULT_BUFFER_SIZE)
+	namespace
+	{
+		void putUnsigned(string& buffer, uint32_t value, int bytes)
+		{
+			for (int i = 0; i < bytes; ++i, value >>= 8) buffer.push_back((char) (value & 0xFF));
+		}
+		
+		uint32_t getUnsigned(const char* data, int bytes)
+		{
+			uint32_t value = 0;
+			
+			for (int i = bytes - 1; i >= 0; --i) value = (value << 8) | (uint8_t) data[i];
+			
+			return value;
+		}
+	}
+	
+	UdpSocket::UdpSocket() : sequence(0), ringSize(0), ringNext(0), address(), socket(-1), bufferSize(UDP_SOCKET_DEFAULT_BUFFER_SIZE)
 	{
 		buffer = new char[UDP_SOCKET_DEFAULT_BUFFER_SIZE];
 		rebind();
@@ -39,7 +57,7 @@ namespace PTracking
 		DOUT("bufferSize = " << UDP_SOCKET_DEFAULT_BUFFER_SIZE);
 	}
 	
-	UdpSocket::UdpSocket(unsigned short port) : address(port), socket(-1), bufferSize(UDP_SOCKET_DEFAULT_BUFFER_SIZE)
+	UdpSocket::UdpSocket(unsigned short port) : sequence(0), ringSize(0), ringNext(0), address(port), socket(-1), bufferSize(UDP_SOCKET_DEFAULT_BUFFER_SIZE)
 	{	
 		buffer = new char[UDP_SOCKET_DEFAULT_BUFFER_SIZE];
 		rebind();
@@ -50,7 +68,7 @@ namespace PTracking
 		DOUT("Port =		" << address.getPort());
 	}
 	
-	UdpSocket::UdpSocket(const InetAddress& address) : address(address), socket(-1), bufferSize(UDP_SOCKET_DEFAULT_BUFFER_SIZE)
+	UdpSocket::UdpSocket(const InetAddress& address) : sequence(0), ringSize(0), ringNext(0), address(address), socket(-1), bufferSize(UDP_SOCKET_DEFAULT_BUFFER_SIZE)
 	{
 		buffer = new char[UDP_SOCKET_DEFAULT_BUFFER_SIZE];
 		rebind();
@@ -185,10 +203,175 @@ namespace PTracking
 		}
 	}
 	
+	bool UdpSocket::reassemble(const char* fragment, size_t size, const InetAddress& address, string& data)
+	{
+		const uint64_t sender = (((uint64_t) address.getAddress().sin_addr.s_addr) << 16) | address.getPort();
+		Timestamp now;
+		
+		/// Dropping the messages whose fragments stopped arriving.
+		for (map<uint64_t,Reassembly>::iterator it = reassemblies.begin(); it != reassemblies.end(); )
+		{
+			if ((now - it->second.started).getMs() > REASSEMBLY_TIMEOUT)
+			{
+				++statistics.droppedMessages;
+				
+				reassemblies.erase(it++);
+			}
+			else ++it;
+		}
+		
+		if ((size <= FRAGMENT_HEADER_SIZE) || ((uint8_t) fragment[1] != 1))
+		{
+			++statistics.malformedFragments;
+			
+			return false;
+		}
+		
+		const uint32_t fragmentSequence = getUnsigned(fragment + 2,4);
+		const unsigned int index = getUnsigned(fragment + 6,2), count = getUnsigned(fragment + 8,2);
+		
+		if ((count == 0) || (count > MAX_FRAGMENTS) || (index >= count))
+		{
+			++statistics.malformedFragments;
+			
+			return false;
+		}
+		
+		map<uint64_t,Reassembly>::iterator reassembly = reassemblies.find(sender);
+		
+		/// A sender has only one message in flight, hence a new sequence number means that the previous message is lost.
+		if ((reassembly != reassemblies.end()) && ((reassembly->second.sequence != fragmentSequence) || (reassembly->second.fragments.size() != count)))
+		{
+			if (reassembly->second.sequence != fragmentSequence) ++statistics.droppedMessages;
+			else ++statistics.malformedFragments;
+			
+			reassemblies.erase(reassembly);
+			reassembly = reassemblies.end();
+		}
+		
+		if (reassembly == reassemblies.end())
+		{
+			reassembly = reassemblies.insert(make_pair(sender,Reassembly())).first;
+			reassembly->second.fragments.resize(count);
+			reassembly->second.sequence = fragmentSequence;
+			reassembly->second.received = 0;
+		}
+		
+		Reassembly& message = reassembly->second;
+		
+		/// Duplicated fragment.
+		if (!message.fragments[index].empty()) return false;
+		
+		message.fragments[index].assign(fragment + FRAGMENT_HEADER_SIZE,size - FRAGMENT_HEADER_SIZE);
+		
+		if (++message.received < count) return false;
+		
+		data.clear();
+		
+		for (vector<string>::const_iterator it = message.fragments.begin(); it != message.fragments.end(); ++it) data += *it;
+		
+		reassemblies.erase(reassembly);
+		
+		return true;
+	}
+	
+	ssize_t UdpSocket::nextDatagram(const char*& datagram, InetAddress& address, double timeoutSecs)
+	{
+		if (ringNext == ringSize)
+		{
+			if (ring.empty())
+			{
+				ring.resize(RECEIVE_BATCH * bufferSize);
+				ringSenders.resize(RECEIVE_BATCH);
+				ringHeaders.resize(RECEIVE_BATCH);
+				ringVectors.resize(RECEIVE_BATCH);
+				
+				for (unsigned int i = 0; i < RECEIVE_BATCH; ++i)
+				{
+					ringVectors[i].iov_base = &ring[i * bufferSize];
+					ringVectors[i].iov_len = bufferSize;
+					
+					memset(&ringHeaders[i],0,sizeof(struct mmsghdr));
+					ringHeaders[i].msg_hdr.msg_name = &ringSenders[i];
+					ringHeaders[i].msg_hdr.msg_iov = &ringVectors[i];
+					ringHeaders[i].msg_hdr.msg_iovlen = 1;
+				}
+			}
+			
+			if (timeoutSecs > 0.0)
+			{
+				fd_set rfds;
+				struct timeval tv;
+				
+				FD_ZERO(&rfds);
+				FD_SET(socket,&rfds);
+				
+				tv.tv_sec = (int) timeoutSecs;
+				tv.tv_usec = (int) ((timeoutSecs - tv.tv_sec) * 1000 * 1000);
+				
+				if (select(socket + 1,&rfds,0,0,&tv) <= 0) return 0;
+			}
+			
+			/// The kernel overwrites the length of the sender addresses.
+			for (unsigned int i = 0; i < RECEIVE_BATCH; ++i) ringHeaders[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+			
+			/// Waiting for the first datagram only (unless a negative timeout is given), then taking the ones already queued.
+			const int received = recvmmsg(socket,&ringHeaders[0],RECEIVE_BATCH,(timeoutSecs < 0.0) ? MSG_DONTWAIT : MSG_WAITFORONE,0);
+			
+			if (received < 0) return (((errno == EAGAIN) || (errno == EWOULDBLOCK)) && (timeoutSecs < 0.0)) ? 0 : -1;
+			
+			ringSize = received;
+			ringNext = 0;
+		}
+		
+		datagram = &ring[ringNext * bufferSize];
+		address = InetAddress(ringSenders[ringNext]);
+		
+		return ringHeaders[ringNext++].msg_len;
+	}
+	
+	ssize_t UdpSocket::recvMessage(string& data, InetAddress& address, double timeoutSecs)
+	{
+		const char* datagram;
+		
+		while (true)
+		{
+			const ssize_t bytes = nextDatagram(datagram,address,timeoutSecs);
+			
+			if (bytes <= 0)
+			{
+				data.clear();
+				
+				return bytes;
+			}
+			
+			if ((uint8_t) datagram[0] != FRAGMENT_MAGIC)
+			{
+				data.assign(datagram,bytes);
+				
+				++statistics.receivedMessages;
+				
+				return bytes;
+			}
+			
+			if (reassemble(datagram,bytes,address,data))
+			{
+				++statistics.receivedMessages;
+				
+				return data.size();
+			}
+		}
+	}
+	
 	ssize_t UdpSocket::send(const std::string& data, const InetAddress& address)
 	{
 		if (!data.size()) return 0;
-		else if (data.size() > bufferSize) return -1;
+		else if (data.size() > bufferSize)
+		{
+			++statistics.oversizedMessages;
+			
+			return -1;
+		}
 		
 		DOUT("socket    = " << socket);
 		DOUT("data      = " << data);
@@ -203,6 +386,95 @@ namespace PTracking
 		return bytesent;
 	}
 	
+	ssize_t UdpSocket::sendMessage(const string& data, const InetAddress* addresses, unsigned int numAddresses)
+	{
+		static const unsigned int FRAGMENT_PAYLOAD = UDP_SOCKET_MAX_DATAGRAM_SIZE - FRAGMENT_HEADER_SIZE;
+		
+		if (data.empty() || (numAddresses == 0)) return 0;
+		
+		/// A message starting with the magic byte is sent as a fragment as well, otherwise it would be taken for one.
+		if ((data.size() <= UDP_SOCKET_MAX_DATAGRAM_SIZE) && ((uint8_t) data[0] != FRAGMENT_MAGIC))
+		{
+			datagrams.resize(1);
+			datagrams[0] = data;
+		}
+		else
+		{
+			const unsigned int count = (data.size() + FRAGMENT_PAYLOAD - 1) / FRAGMENT_PAYLOAD;
+			
+			if (count > MAX_FRAGMENTS)
+			{
+				statistics.oversizedMessages += numAddresses;
+				
+				return -1;
+			}
+			
+			/// The strings keep their capacity, hence no allocation once the largest message has been sent.
+			datagrams.resize(count);
+			
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				string& fragment = datagrams[i];
+				
+				fragment.clear();
+				fragment.push_back((char) FRAGMENT_MAGIC);
+				fragment.push_back(1);
+				
+				putUnsigned(fragment,sequence,4);
+				putUnsigned(fragment,i,2);
+				putUnsigned(fragment,count,2);
+				
+				fragment.append(data,i * FRAGMENT_PAYLOAD,FRAGMENT_PAYLOAD);
+			}
+			
+			++sequence;
+		}
+		
+		const unsigned int total = datagrams.size() * numAddresses;
+		
+		destinations.resize(numAddresses);
+		sendHeaders.resize(total);
+		sendVectors.resize(total);
+		
+		for (unsigned int i = 0; i < numAddresses; ++i) destinations[i] = addresses[i].getAddress();
+		
+		/// All the datagrams of the first address, then all the ones of the second address and so on.
+		for (unsigned int i = 0; i < total; ++i)
+		{
+			const string& datagram = datagrams[i % datagrams.size()];
+			
+			sendVectors[i].iov_base = const_cast<char*>(datagram.data());
+			sendVectors[i].iov_len = datagram.size();
+			
+			memset(&sendHeaders[i],0,sizeof(struct mmsghdr));
+			sendHeaders[i].msg_hdr.msg_name = &destinations[i / datagrams.size()];
+			sendHeaders[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+			sendHeaders[i].msg_hdr.msg_iov = &sendVectors[i];
+			sendHeaders[i].msg_hdr.msg_iovlen = 1;
+		}
+		
+		unsigned int sent = 0;
+		
+		/// sendmmsg can send less datagrams than requested (at most UIO_MAXIOV per call).
+		while (sent < total)
+		{
+			const int bytes = sendmmsg(socket,&sendHeaders[sent],total - sent,0);
+			
+			if (bytes <= 0) break;
+			
+			sent += bytes;
+		}
+		
+		/// Only the addresses that got all the datagrams received the message.
+		const unsigned int delivered = sent / datagrams.size();
+		
+		statistics.sentMessages += delivered;
+		
+		if (datagrams.size() > 1) statistics.fragmentedMessages += delivered;
+		
+		return (sent == total) ? (ssize_t) data.size() : -1;
+	}
+	
 	bool UdpSocket::shutdown(int how)
 	{
 		return ::shutdown(socket,how) != -1;
@@ -1,9 +1,17 @@
 #pragma once
 
 #include "InetAddress.h"
+#include "Timestamp.h"
+#include <stdint.h>
+#include <sys/socket.h>
+#include <map>
+#include <vector>
 
 #define UDP_SOCKET_DEFAULT_BUFFER_SIZE 5000
 
+/// Largest datagram sent by sendMessage(), small enough to never be fragmented by IP on an Ethernet link.
+#define UDP_SOCKET_MAX_DATAGRAM_SIZE 1400
+
 namespace PTracking
 {
 	/**
@@ -13,6 +21,179 @@ namespace PTracking
 	 */
 	class UdpSocket
 	{
+		public:
+			/**
+			 * @struct Statistics
+			 * 
+			 * @brief Struct that represents the counters of the messages sent and received by sendMessage() and recvMessage().
+			 */
+			struct Statistics
+			{
+				/**
+				 * @brief number of messages sent (once for every destination), either in one datagram or in fragments.
+				 */
+				unsigned long sentMessages;
+				
+				/**
+				 * @brief number of messages sent in fragments (once for every destination).
+				 */
+				unsigned long fragmentedMessages;
+				
+				/**
+				 * @brief number of messages not sent because too large, either for send() or for sendMessage().
+				 */
+				unsigned long oversizedMessages;
+				
+				/**
+				 * @brief number of messages received, either in one datagram or reassembled.
+				 */
+				unsigned long receivedMessages;
+				
+				/**
+				 * @brief number of fragmented messages dropped because not completed in time or superseded by a newer message of the same sender.
+				 */
+				unsigned long droppedMessages;
+				
+				/**
+				 * @brief number of fragments discarded because inconsistent with the message they belong to.
+				 */
+				unsigned long malformedFragments;
+				
+				Statistics() : sentMessages(0), fragmentedMessages(0), oversizedMessages(0), receivedMessages(0), droppedMessages(0), malformedFragments(0) {;}
+			};
+			
+		private:
+			/**
+			 * @struct Reassembly
+			 * 
+			 * @brief Struct that represents a fragmented message being received from a sender.
+			 */
+			struct Reassembly
+			{
+				/**
+				 * @brief fragments of the message, empty until received.
+				 */
+				std::vector<std::string> fragments;
+				
+				/**
+				 * @brief time when the first fragment has been received.
+				 */
+				Timestamp started;
+				
+				/**
+				 * @brief sequence number of the message.
+				 */
+				uint32_t sequence;
+				
+				/**
+				 * @brief number of fragments received so far.
+				 */
+				unsigned int received;
+			};
+			
+			/**
+			 * @brief first byte of a fragment, it can not be the first byte of a text or of a binary AgentPacket message.
+			 */
+			static const uint8_t FRAGMENT_MAGIC = 0xA6;
+			
+			/**
+			 * @brief size of the header of a fragment: magic, version, sequence number, fragment index and number of fragments.
+			 */
+			static const unsigned int FRAGMENT_HEADER_SIZE = 10;
+			
+			/**
+			 * @brief maximum number of fragments of a message, it bounds the memory used to reassemble a message.
+			 */
+			static const unsigned int MAX_FRAGMENTS = 1024;
+			
+			/**
+			 * @brief time (in ms) after which an incomplete message is dropped.
+			 */
+			static const unsigned int REASSEMBLY_TIMEOUT = 500;
+			
+			/**
+			 * @brief maximum number of datagrams read by recvMessage() with a single system call.
+			 */
+			static const unsigned int RECEIVE_BATCH = 32;
+			
+			/**
+			 * @brief messages being reassembled, one for every sender (address and port).
+			 */
+			std::map<uint64_t,Reassembly> reassemblies;
+			
+			/**
+			 * @brief counters of the messages.
+			 */
+			Statistics statistics;
+			
+			/**
+			 * @brief sequence number of the next fragmented message.
+			 */
+			uint32_t sequence;
+			
+			/**
+			 * @brief datagrams of the message being sent, reused among the messages.
+			 */
+			std::vector<std::string> datagrams;
+			
+			/**
+			 * @brief destinations, headers and buffers of the datagrams given to sendmmsg.
+			 */
+			std::vector<struct sockaddr_in> destinations;
+			std::vector<struct mmsghdr> sendHeaders;
+			std::vector<struct iovec> sendVectors;
+			
+			/**
+			 * @brief ring of RECEIVE_BATCH buffers of bufferSize bytes filled by recvmmsg, allocated by the first recvMessage().
+			 */
+			std::vector<char> ring;
+			
+			/**
+			 * @brief senders, headers and buffers of the datagrams given to recvmmsg.
+			 */
+			std::vector<struct sockaddr_in> ringSenders;
+			std::vector<struct mmsghdr> ringHeaders;
+			std::vector<struct iovec> ringVectors;
+			
+			/**
+			 * @brief number of datagrams read by the last recvmmsg and index of the next one to be consumed.
+			 */
+			unsigned int ringSize, ringNext;
+			
+			/**
+			 * @brief Function that returns the next datagram of the ring, reading a new batch when the ring has been consumed.
+			 * 
+			 * @param datagram reference to the pointer to the datagram, valid until the next call.
+			 * @param address reference to the sender address.
+			 * @param timeoutSecs maximum number of seconds to wait for a datagram (0 to wait forever, a negative value to not wait at all).
+			 * 
+			 * @return the size of the datagram, 0 if the timeout expired and -1 if the receive failed.
+			 */
+			ssize_t nextDatagram(const char*& datagram, InetAddress& address, double timeoutSecs);
+			
+			/**
+			 * @brief Function that stores a fragment, returning the message once all its fragments have been received.
+			 * 
+			 * @param fragment pointer to the fragment (header included).
+			 * @param size size of the fragment.
+			 * @param address reference to the sender address.
+			 * @param data reference to the reassembled message.
+			 * 
+			 * @return \b true if the message has been completed, \b false otherwise.
+			 */
+			bool reassemble(const char* fragment, size_t size, const InetAddress& address, std::string& data);
+			
+			/**
+			 * @brief Function that sends a message of any size to an array of addresses.
+			 * 
+			 * @param data message to be sent.
+			 * @param addresses pointer to the first receiver address.
+			 * @param numAddresses number of receiver addresses.
+			 * 
+			 * @return the size of the message if all its datagrams have been sent to all the addresses, -1 otherwise.
+			 */
+			ssize_t sendMessage(const std::string& data, const InetAddress* addresses, unsigned int numAddresses);
+			
 		protected:
 			/**
 			 * @brief address of the sender/receiver.
@@ -92,6 +273,13 @@ namespace PTracking
 			 */
 			inline InetAddress getAddress() { return address; }
 			
+			/**
+			 * @brief Function that returns the counters of the messages.
+			 * 
+			 * @return a reference to the counters of the messages.
+			 */
+			inline const Statistics& getStatistics() const { return statistics; }
+			
 			/**
 			 * @brief Function that returns the socket descriptor.
 			 * 
@@ -124,6 +312,21 @@ namespace PTracking
 			 */
 			ssize_t recv(std::string& data, InetAddress& address, double timeoutSecs = 0.0);
 			
+			/**
+			 * @brief Function that receives a message sent with sendMessage() (or with send()) and stores the sender address.
+			 * 
+			 * The fragments of a message are reassembled, a sender can have only one fragmented message in flight. The datagrams are read in bursts of up to
+			 * RECEIVE_BATCH with a single system call, hence recv() must not be used on the same socket. With a negative timeout it returns 0 as soon as
+			 * no more datagrams are queued, keeping the incomplete messages for the next call, as needed by a socket registered in a Reactor.
+			 * 
+			 * @param data received message.
+			 * @param address reference to the sender address.
+			 * @param timeoutSecs maximum number of seconds to wait for every datagram (0 to wait forever, a negative value to not wait at all).
+			 * 
+			 * @return the size of the message, 0 if the timeout expired and -1 if the receive failed.
+			 */
+			ssize_t recvMessage(std::string& data, InetAddress& address, double timeoutSecs = 0.0);
+			
 			/**
 			 * @brief Function that receives a RAW packet without storing the sender address.
 			 * 
@@ -143,6 +346,30 @@ namespace PTracking
 			 */
 			ssize_t send(const std::string& data, const InetAddress& address);
 			
+			/**
+			 * @brief Function that sends a message of any size to a specific address.
+			 * 
+			 * A message larger than UDP_SOCKET_MAX_DATAGRAM_SIZE is split in fragments that recvMessage() reassembles, a smaller one is sent as it is.
+			 * 
+			 * @param data message to be sent.
+			 * @param address reference to the receiver address.
+			 * 
+			 * @return the size of the message if all its datagrams have been sent, -1 otherwise.
+			 */
+			inline ssize_t sendMessage(const std::string& data, const InetAddress& address) { return sendMessage(data,&address,1); }
+			
+			/**
+			 * @brief Function that sends a message of any size to several addresses.
+			 * 
+			 * The message is split in datagrams once and all of them are sent to all the addresses with a single sendmmsg call (unless very many).
+			 * 
+			 * @param data message to be sent.
+			 * @param addresses reference to the receiver addresses.
+			 * 
+			 * @return the size of the message if all its datagrams have been sent to all the addresses, -1 otherwise.
+			 */
+			inline ssize_t sendMessage(const std::string& data, const std::vector<InetAddress>& addresses) { return addresses.empty() ? 0 : sendMessage(data,&addresses[0],addresses.size()); }
+			
 			/**
 			 * @brief Function that shutdowns the socket.
 			 * 
@@ -3,13 +3,14 @@
 #include "Point2f.h"
 #include "Point2of.h"
 #include "PolarPoint.h"
+#include "Random.h"
+#include "../Core/Clusterizer/Clusterizer.h"
 #include "../Core/Filters/ObjectSensorReading.h"
 #include <Manfield/filters/gmlocalizer/structs.h>
 #include <Manfield/utils/debugutils.h>
-#include <boost/random.hpp>
-#include <boost/random/normal_distribution.hpp>
 #include <math.h>
 #include <string.h>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -93,6 +94,40 @@ namespace PTracking
 				Point2fWithVelocityOnMap
 			};
 			
+			/**
+			 * @brief Function that adds Gaussian noise to the pose of a range of particles.
+			 * 
+			 * The noise is generated in batches, by default with the generator of the calling thread.
+			 * 
+			 * @param begin iterator to the first particle of the range.
+			 * @param end iterator past the last particle of the range.
+			 * @param sigmaPosition standard deviation of the noise on the position.
+			 * @param sigmaTheta standard deviation of the noise on the orientation.
+			 * @param random reference to the generator of the noise.
+			 */
+			inline static void addGaussianNoise(PoseParticleVector::iterator begin, PoseParticleVector::iterator end, float sigmaPosition, float sigmaTheta, Random& random = Random::local())
+			{
+				static const int BATCH_SIZE = 64;
+				
+				float noiseX[BATCH_SIZE], noiseY[BATCH_SIZE], noiseTheta[BATCH_SIZE];
+				
+				while (begin != end)
+				{
+					const int size = std::min((int) (end - begin),BATCH_SIZE);
+					
+					random.gaussians(noiseX,size,sigmaPosition);
+					random.gaussians(noiseY,size,sigmaPosition);
+					random.gaussians(noiseTheta,size,sigmaTheta);
+					
+					for (int i = 0; i < size; ++i, ++begin)
+					{
+						begin->pose.pose.x += noiseX[i];
+						begin->pose.pose.y += noiseY[i];
+						begin->pose.pose.theta = angNormPiSig(begin->pose.pose.theta + noiseTheta[i]);
+					}
+				}
+			}
+			
 			/**
 			 * @brief Function that normalizes an angle within [-M_PI,M_PI].
 			 * 
@@ -158,15 +193,28 @@ namespace PTracking
 			 * @return a point representing the centroid of the particles given in input.
 			 */
 			inline static Point2of calculateCentroid(const PoseParticleVector& particles)
+			{
+				return calculateCentroid(particles,0,particles.size());
+			}
+			
+			/**
+			 * @brief Function that computes the centroid of a range of particles.
+			 * 
+			 * @param particles reference to the vector of particles.
+			 * @param begin index of the first particle of the range.
+			 * @param end index past the last particle of the range.
+			 * 
+			 * @return a point representing the centroid of the particles in [begin,end).
+			 */
+			inline static Point2of calculateCentroid(const PoseParticleVector& particles, int begin, int end)
 			{
 				Point2of centroid;
-				int i, size;
+				int i;
 				
-				i = 0;
-				size = particles.size();
+				i = begin;
 				
 				/// Partial Loop Unrolling to better use pipeling.
-				for (; i < size - 3; i += 4)
+				for (; i < end - 3; i += 4)
 				{
 					centroid.x += particles.at(i).pose.pose.x + particles.at(i + 1).pose.pose.x +
 								  particles.at(i + 2).pose.pose.x + particles.at(i + 3).pose.pose.x;
@@ -175,16 +223,16 @@ namespace PTracking
 								  particles.at(i + 2).pose.pose.y + particles.at(i + 3).pose.pose.y;
 				}
 				
-				for (; i < size; ++i)
+				for (; i < end; ++i)
 				{
 					centroid.x += particles.at(i).pose.pose.x;
 					centroid.y += particles.at(i).pose.pose.y;
 				}
 				
-				if (particles.size() > 0)
+				if (end > begin)
 				{
-					centroid.x /= particles.size();
-					centroid.y /= particles.size();
+					centroid.x /= end - begin;
+					centroid.y /= end - begin;
 				}
 				
 				return centroid;
@@ -262,6 +310,21 @@ namespace PTracking
 			 * @return a point representing the standard deviation of the vector of particles given in input.
 			 */
 			inline static Point2f calculateSigmaParticles(const PoseParticleVector& part, const Point2f& mean)
+			{
+				return calculateSigmaParticles(part,0,part.size(),mean);
+			}
+			
+			/**
+			 * @brief Function that computes the standard deviation of a range of particles.
+			 * 
+			 * @param part reference to the vector of particles.
+			 * @param begin index of the first particle of the range.
+			 * @param end index past the last particle of the range.
+			 * @param mean reference to the mean of the particles in the range.
+			 * 
+			 * @return a point representing the standard deviation of the particles in [begin,end).
+			 */
+			inline static Point2f calculateSigmaParticles(const PoseParticleVector& part, int begin, int end, const Point2f& mean)
 			{
 				Point2f sigma;
 				int i, size;
@@ -269,11 +332,11 @@ namespace PTracking
 				sigma.x = 0.0;
 				sigma.y = 0.0;
 				
-				i = 0;
-				size = part.size();
+				i = begin;
+				size = end - begin;
 				
 				/// Partial Loop Unrolling to better use pipeling.
-				for (; i < size - 3; i += 4)
+				for (; i < end - 3; i += 4)
 				{
 					sigma.x += ((part.at(i).pose.pose.x - mean.x) * (part.at(i).pose.pose.x - mean.x)) +
 							   ((part.at(i + 1).pose.pose.x - mean.x) * (part.at(i + 1).pose.pose.x - mean.x)) +
@@ -286,7 +349,7 @@ namespace PTracking
 							   ((part.at(i + 3).pose.pose.y - mean.y) * (part.at(i + 3).pose.pose.y - mean.y));
 				}
 				
-				for (; i < size; ++i)
+				for (; i < end; ++i)
 				{
 					sigma.x += ((part.at(i).pose.pose.x - mean.x) * (part.at(i).pose.pose.x - mean.x));
 					sigma.y += ((part.at(i).pose.pose.y - mean.y) * (part.at(i).pose.pose.y - mean.y));
@@ -335,16 +398,16 @@ namespace PTracking
 			}
 			
 			/**
-			 * @brief Function that compares two pairs having as second element a Point2of object.
+			 * @brief Function that compares two clusters by the abscissa of their centroid.
 			 * 
-			 * @param i reference to the first pair to be compared.
-			 * @param j reference to the second pair to be compared.
+			 * @param i reference to the first cluster to be compared.
+			 * @param j reference to the second cluster to be compared.
 			 * 
-			 * @return \b true if the first pair is less than the second one, \b false otherwise.
+			 * @return \b true if the first cluster is less than the second one, \b false otherwise.
 			 */
-			inline static bool comparePairPoint2of(const std::pair<PoseParticleVector,Point2of>& i, const std::pair<PoseParticleVector,Point2of>& j)
+			inline static bool compareClusterRange(const ClusterRange& i, const ClusterRange& j)
 			{
-				return (i.second.x < j.second.x);
+				return (i.centroid.x < j.centroid.x);
 			}
 			
 			/**
@@ -593,17 +656,15 @@ namespace PTracking
 			/**
 			 * @brief Function that generates a Gaussian number with a Gaussian distribution having zero mean and a specified standard deviation.
 			 * 
+			 * It uses the generator of the calling thread, hence it can be called from several threads at once.
+			 * 
 			 * @param sigma standard deviation of the Gaussian distribution.
 			 * 
 			 * @return the generated Gaussian number.
 			 */
 			inline static float sampleGaussianSigma(float sigma)
 			{
-				static boost::mt19937 rng;
-				static boost::normal_distribution<> nd(0.0,sigma);
-				static boost::variate_generator<boost::mt19937&,boost::normal_distribution<> > var_nor(rng,nd);
-				
-				return var_nor();
+				return Random::local().gaussian(sigma);
 			}
 			
 			/**
@@ -612,16 +673,17 @@ namespace PTracking
 			 * @param mean reference to the vector of means.
 			 * @param sigma reference to the vector of standard deviations.
 			 * @param n particles number for each vector.
+			 * @param random generator drawing the particles (the one of the calling thread by default).
 			 * 
 			 * @return a vector of vectors of particles sampled using the values given in input.
 			 */
-			inline static std::vector<PoseParticleVector> samplingParticles(const std::vector<Point2f>& mean, const std::vector<Point2f>& sigma, int n)
+			inline static std::vector<PoseParticleVector> samplingParticles(const std::vector<Point2f>& mean, const std::vector<Point2f>& sigma, int n, Random& random = Random::local())
 			{
 				std::vector<PoseParticleVector> particles;
 				
 				for (unsigned int i = 0; i < mean.size(); ++i)
 				{
-					particles.push_back(samplingParticles(mean.at(i),sigma.at(i),n));
+					particles.push_back(samplingParticles(mean.at(i),sigma.at(i),n,random));
 				}
 				
 				return particles;
@@ -633,22 +695,36 @@ namespace PTracking
 			 * @param mean reference to the mean of the vector.
 			 * @param sigma reference to the standard deviation of the vector.
 			 * @param n particles number of the vector.
+			 * @param random generator drawing the particles (the one of the calling thread by default).
 			 * 
 			 * @return a vector of particles sampled using the values given in input.
 			 */
-			inline static PoseParticleVector samplingParticles(const Point2f& mean, const Point2f& sigma, int n)
+			inline static PoseParticleVector samplingParticles(const Point2f& mean, const Point2f& sigma, int n, Random& random = Random::local())
 			{
+				static const int BATCH_SIZE = 64;
+				
 				PoseParticleVector particles;
+				float noiseX[BATCH_SIZE], noiseY[BATCH_SIZE];
+				
+				particles.reserve(n);
 				
-				for (int i = 0; i < n; i++)
+				for (int i = 0; i < n; i += BATCH_SIZE)
 				{
-					PointWithVelocity poseParticle;
+					const int size = std::min(n - i,BATCH_SIZE);
 					
-					poseParticle.pose.x = mean.x + sampleGaussianSigma(sigma.x);
-					poseParticle.pose.y = mean.y + sampleGaussianSigma(sigma.y);
-					poseParticle.pose.theta = 0.0;
+					random.gaussians(noiseX,size,sigma.x);
+					random.gaussians(noiseY,size,sigma.y);
 					
-					particles.push_back(PoseParticle(poseParticle,1.0));
+					for (int j = 0; j < size; ++j)
+					{
+						PointWithVelocity poseParticle;
+						
+						poseParticle.pose.x = mean.x + noiseX[j];
+						poseParticle.pose.y = mean.y + noiseY[j];
+						poseParticle.pose.theta = 0.0;
+						
+						particles.push_back(PoseParticle(poseParticle,1.0));
+					}
 				}
 				
 				return particles;